@@ -0,0 +1,132 @@
+#ifndef MODERN_CPP_INC_BENCH_BENCHMARK_HPP
+#define MODERN_CPP_INC_BENCH_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// what the benchmark executables in src/bench share: timing, the command
+// line and the output. every benchmark runs its operation in batches sized to
+// take a fraction of --min-time and reports the median batch, as ns per
+// operation and, where it means something, GFLOP/s and GB/s. --json writes
+// the same numbers one benchmark per line, with stable names and ordering,
+// so the files of two commits diff cleanly
+//
+//   <bench> [--filter substring] [--min-time seconds] [--json file]
+
+namespace mcpp::bench {
+
+struct Result {
+  std::string name;
+  std::size_t iterations;
+  // flops and bytes per operation, 0 when they don't apply
+  double nsPerOp, flops, bytes;
+};
+
+struct Options {
+  std::string filter;
+  double minTime = 0.2;
+  std::string json;
+};
+
+// keeps the compiler from dropping computations whose results go unused
+template <typename T> void doNotOptimize(const T &value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+// median ns per call of op over a few batches, the batch size picked from a
+// first timed call so the batches add up to about minTime
+inline Result measure(std::string name, double flops, double bytes,
+                      double minTime, const std::function<void()> &op) {
+  using Clock = std::chrono::steady_clock;
+  constexpr std::size_t samples = 7;
+  const auto seconds = [](Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+  };
+  auto start = Clock::now();
+  op(); // also warms up caches and the kernel dispatch
+  const auto once = std::max(seconds(Clock::now() - start), 1e-9);
+  const auto iterations =
+      std::max(std::size_t(minTime / samples / once), std::size_t(1));
+  std::vector<double> times(samples);
+  for (auto &time : times) {
+    start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+      op();
+    time = seconds(Clock::now() - start) / double(iterations);
+  }
+  std::nth_element(times.begin(), times.begin() + samples / 2, times.end());
+  return {std::move(name), iterations * samples, times[samples / 2] * 1e9,
+          flops, bytes};
+}
+
+// one line per result, the rates left out when they don't apply
+inline void print(const Result &r) {
+  std::printf("%-32s %14.1f ns/op", r.name.c_str(), r.nsPerOp);
+  if (r.flops > 0)
+    std::printf(" %9.2f GFLOP/s", r.flops / r.nsPerOp);
+  else if (r.bytes > 0)
+    std::printf(" %17s", "");
+  if (r.bytes > 0)
+    std::printf(" %9.2f GB/s", r.bytes / r.nsPerOp);
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+// properties go at the top of the file as they are, so their values must
+// already be json
+inline void
+writeJson(std::ostream &out, const std::vector<Result> &results,
+          const std::vector<std::pair<std::string, std::string>> &properties) {
+  // gflops and gbps are null when the operation does no arithmetic or moves
+  // no elements
+  const auto number = [&](double value) {
+    if (value > 0)
+      out << value;
+    else
+      out << "null";
+  };
+  out.precision(6);
+  out << "{\n";
+  for (const auto &[key, value] : properties)
+    out << "  \"" << key << "\": " << value << ",\n";
+  out << "  \"benchmarks\": [\n";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto &r = results[i];
+    out << "    {\"name\": \"" << r.name << "\", \"iterations\": "
+        << r.iterations << ", \"ns_per_op\": " << r.nsPerOp
+        << ", \"gflops\": ";
+    number(r.flops / r.nsPerOp);
+    out << ", \"gbps\": ";
+    number(r.bytes / r.nsPerOp);
+    out << '}' << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "  ]\n}\n";
+}
+
+inline bool parse(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; ++i) {
+    const auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!std::strcmp(argv[i], "--filter") && value)
+      options.filter = value;
+    else if (!std::strcmp(argv[i], "--min-time") && value)
+      options.minTime = std::atof(value);
+    else if (!std::strcmp(argv[i], "--json") && value)
+      options.json = value;
+    else
+      return false;
+    ++i;
+  }
+  return options.minTime > 0;
+}
+
+} // namespace mcpp::bench
+
+#endif // MODERN_CPP_INC_BENCH_BENCHMARK_HPP
@@ -0,0 +1,156 @@
+#ifndef MODERN_CPP_INC_CONCURRENCY_THREAD_POOL_HPP
+#define MODERN_CPP_INC_CONCURRENCY_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mcpp::concurrency {
+
+// fixed set of workers that run index-parallel loops. the thread calling
+// parallelFor works too, so a pool of n threads spawns n - 1 of them. loops
+// are handed out one index at a time through an atomic counter, which keeps
+// uneven tasks balanced without any per-loop allocation. a parallelFor issued
+// from inside a task runs serially on the calling worker instead of
+// deadlocking. if tasks throw, the first exception is rethrown by parallelFor
+// once every worker has let go of the loop, and indices nobody has started
+// yet are skipped
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t threadCount =
+                          std::max(std::thread::hardware_concurrency(), 1U)) {
+    for (std::size_t i = 1; i < threadCount; ++i)
+      workers_.emplace_back([this] { work_(); });
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_)
+      worker.join();
+  }
+
+  [[nodiscard]] std::size_t threadCount() const { return workers_.size() + 1; }
+
+  // calls task(i) for every i in [0, count) and returns once all are done
+  template <typename F> void parallelFor(std::size_t count, const F &task) {
+    if (count == 0)
+      return;
+    if (workers_.empty() || count == 1 || insideWorker_) {
+      for (std::size_t i = 0; i < count; ++i)
+        task(i);
+      return;
+    }
+
+    Job job{[](const void *f, std::size_t i) {
+              (*static_cast<const F *>(f))(i);
+            },
+            &task, count};
+    std::lock_guard submitLock(submitMutex_);
+    {
+      std::lock_guard lock(mutex_);
+      job_ = &job;
+      ++generation_;
+    }
+    wake_.notify_all();
+
+    {
+      struct Restore {
+        bool wasInsideWorker;
+        ~Restore() { insideWorker_ = wasInsideWorker; }
+      } restore{std::exchange(insideWorker_, true)};
+      run_(job);
+    }
+
+    std::unique_lock lock(mutex_);
+    done_.wait(lock, [&] { return job.finished == count && active_ == 0; });
+    job_ = nullptr;
+    if (job.error)
+      std::rethrow_exception(job.error);
+  }
+
+private:
+  struct Job {
+    void (*invoke)(const void *, std::size_t);
+    const void *task;
+    std::size_t count;
+    std::atomic<std::size_t> next = 0, finished = 0;
+    std::atomic<bool> failed = false;
+    // the first exception a task threw, written under the pool's mutex
+    std::exception_ptr error = nullptr;
+  };
+
+  // never throws: an index counts as finished even when its task threw, or
+  // the submitter would wait forever and its job would die under the workers
+  void run_(Job &job) {
+    for (std::size_t i; (i = job.next.fetch_add(1)) < job.count;) {
+      if (!job.failed.load(std::memory_order_relaxed))
+        try {
+          job.invoke(job.task, i);
+        } catch (...) {
+          std::lock_guard lock(mutex_);
+          if (!job.error)
+            job.error = std::current_exception();
+          job.failed = true;
+        }
+      if (job.finished.fetch_add(1) + 1 == job.count) {
+        std::lock_guard lock(mutex_);
+        done_.notify_all();
+      }
+    }
+  }
+
+  void work_() {
+    insideWorker_ = true;
+    std::size_t seen = 0;
+    std::unique_lock lock(mutex_);
+    for (;;) {
+      wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_)
+        return;
+      seen = generation_;
+      // a worker waking up after the submitter cleared the job just goes
+      // back to sleep; one that grabs it is counted so the job outlives it
+      if (!job_)
+        continue;
+      auto job = job_;
+      ++active_;
+      lock.unlock();
+      run_(*job);
+      lock.lock();
+      if (--active_ == 0)
+        done_.notify_all();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_, submitMutex_;
+  std::condition_variable wake_, done_;
+  Job *job_ = nullptr;
+  std::size_t generation_ = 0, active_ = 0;
+  bool stopping_ = false;
+
+  static inline thread_local bool insideWorker_ = false;
+};
+
+// process-wide pool sized to the hardware, created on first use
+inline ThreadPool &defaultThreadPool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+} // namespace mcpp::concurrency
+
+#endif // MODERN_CPP_INC_CONCURRENCY_THREAD_POOL_HPP
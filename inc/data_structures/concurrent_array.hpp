@@ -0,0 +1,363 @@
+#ifndef MODERN_CPP_INC_DATA_STRUCTURES_CONCURRENT_ARRAY_HPP
+#define MODERN_CPP_INC_DATA_STRUCTURES_CONCURRENT_ARRAY_HPP
+
+#include "data_structures/dynamic_array.hpp"
+#include "memory/aligned.hpp"
+#include "memory/memory_resource.hpp"
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace mcpp::data_structures {
+
+// an append-only array any number of threads can push to at once without a
+// lock. elements live in segments of doubling size that are never moved or
+// freed while the array lives, so their addresses are stable. a push claims
+// an index with one fetch_add, builds the element and then flags its slot as
+// ready. the push that claims the middle index of a segment installs the next
+// one, so pushes normally find their segment already there and only one
+// thread pays for the allocation. iterating (and size()) is safe while other
+// threads push: iteration covers the indices claimed when begin() was called
+// and skips slots whose element isn't ready yet. freeze() and clear() need
+// the pushes to be over. the segments come from a memory resource, which has
+// to be thread safe (the heap is, the arena and pool resources aren't)
+template <typename T> class ConcurrentArray {
+  // U is T or const T
+  template <typename U> class Iterator_ {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = U *;
+    using reference = U &;
+
+    Iterator_() = default;
+    Iterator_(const ConcurrentArray *, std::size_t index, std::size_t end);
+
+    Iterator_ &operator++();
+    Iterator_ operator++(int);
+    U &operator*() const;
+    U *operator->() const;
+    bool operator==(const Iterator_ &) const;
+    bool operator!=(const Iterator_ &) const;
+
+  private:
+    // moves forward to the first ready slot from index_ on, or to end()
+    void skipUnready_();
+
+    const ConcurrentArray *array_{};
+    std::size_t index_{}, end_{};
+  };
+
+public:
+  using Iterator = Iterator_<T>;
+  using ConstIterator = Iterator_<const T>;
+
+  explicit ConcurrentArray(
+      memory::MemoryResource * = memory::defaultResource());
+
+  ConcurrentArray(const ConcurrentArray &) = delete;
+  ConcurrentArray &operator=(const ConcurrentArray &) = delete;
+
+  ~ConcurrentArray();
+
+  // both return the index the element went to
+  std::size_t push(const T &);
+  std::size_t push(T &&);
+  // the element is published once it's built, the reference stays valid
+  // until the array is cleared, frozen or destroyed
+  template <typename... Args> T &emplace(Args &&...);
+
+  // the number of claimed indices, elements being pushed included
+  [[nodiscard]] std::size_t size() const;
+  // whether the element at index has been pushed completely
+  [[nodiscard]] bool ready(std::size_t index) const;
+
+  // for indices whose push has returned (or that were seen ready)
+  [[nodiscard]] const T &operator[](std::size_t) const;
+  T &operator[](std::size_t);
+
+  // only the indices claimed by the time begin() is called
+  Iterator begin();
+  Iterator end();
+  ConstIterator begin() const;
+  ConstIterator end() const;
+
+  // not concurrently with pushes: moves the elements, in index order, into a
+  // contiguous Array and leaves this one empty
+  [[nodiscard]] Array<T>
+  freeze(memory::MemoryResource * = memory::defaultResource());
+  // not concurrently with pushes
+  void clear();
+
+private:
+  struct Slot_ {
+    alignas(T) unsigned char storage[sizeof(T)];
+    std::atomic<bool> ready{false};
+
+    T *value() { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+
+  // segment k holds firstSegment_ << k slots and starts at index
+  // firstSegment_ * (2^k - 1), which makes room for any index memory could
+  // hold
+  static constexpr std::size_t firstSegmentShift_ = 6,
+                               firstSegment_ = 1 << firstSegmentShift_,
+                               maxSegments_ = 64 - firstSegmentShift_;
+
+  static std::size_t segmentOf_(std::size_t index);
+  static std::size_t segmentSize_(std::size_t segment);
+  static std::size_t segmentStart_(std::size_t segment);
+
+  // the slot of index, nullptr if its segment hasn't been installed yet
+  Slot_ *find_(std::size_t index) const;
+  // the slot of index, installing its segment if it's missing
+  Slot_ *slot_(std::size_t index);
+  // the slots of segment, allocating them unless they're already installed
+  Slot_ *install_(std::size_t segment);
+  // claims an index and builds the element there, returning the index
+  template <typename... Args> std::size_t construct_(Args &&...);
+  void release_() noexcept;
+
+  static constexpr auto outOfRangeMsg_ = "out of range";
+
+  // on a line of its own, every push hits it
+  alignas(memory::cacheLineSize) std::atomic<std::size_t> size_;
+  alignas(memory::cacheLineSize) std::atomic<Slot_ *> segments_[maxSegments_];
+  memory::MemoryResource *resource_;
+};
+
+// iterator member functions
+
+template <typename T>
+template <typename U>
+ConcurrentArray<T>::Iterator_<U>::Iterator_(const ConcurrentArray *array,
+                                            std::size_t index,
+                                            std::size_t end)
+    : array_(array), index_(index), end_(end) {
+  skipUnready_();
+}
+
+template <typename T>
+template <typename U>
+ConcurrentArray<T>::Iterator_<U> &
+ConcurrentArray<T>::Iterator_<U>::operator++() {
+  ++index_;
+  skipUnready_();
+  return *this;
+}
+
+template <typename T>
+template <typename U>
+ConcurrentArray<T>::Iterator_<U>
+ConcurrentArray<T>::Iterator_<U>::operator++(int) {
+  const auto result = *this;
+  operator++();
+  return result;
+}
+
+template <typename T>
+template <typename U>
+U &ConcurrentArray<T>::Iterator_<U>::operator*() const {
+  return *array_->find_(index_)->value();
+}
+
+template <typename T>
+template <typename U>
+U *ConcurrentArray<T>::Iterator_<U>::operator->() const {
+  return array_->find_(index_)->value();
+}
+
+template <typename T>
+template <typename U>
+bool ConcurrentArray<T>::Iterator_<U>::operator==(
+    const Iterator_ &other) const {
+  return index_ == other.index_;
+}
+
+template <typename T>
+template <typename U>
+bool ConcurrentArray<T>::Iterator_<U>::operator!=(
+    const Iterator_ &other) const {
+  return !operator==(other);
+}
+
+template <typename T>
+template <typename U>
+void ConcurrentArray<T>::Iterator_<U>::skipUnready_() {
+  while (index_ < end_ && !array_->ready(index_))
+    ++index_;
+  if (index_ >= end_)
+    index_ = end_ = SIZE_MAX; // every iterator past its end is end()
+}
+
+// member functions
+
+template <typename T>
+ConcurrentArray<T>::ConcurrentArray(memory::MemoryResource *resource)
+    : size_(0), segments_(), resource_(resource) {}
+
+template <typename T> ConcurrentArray<T>::~ConcurrentArray() { release_(); }
+
+template <typename T> std::size_t ConcurrentArray<T>::push(const T &value) {
+  return construct_(value);
+}
+
+template <typename T> std::size_t ConcurrentArray<T>::push(T &&value) {
+  return construct_(std::move(value));
+}
+
+template <typename T>
+template <typename... Args>
+T &ConcurrentArray<T>::emplace(Args &&...args) {
+  return *find_(construct_(std::forward<Args>(args)...))->value();
+}
+
+template <typename T> std::size_t ConcurrentArray<T>::size() const {
+  return size_.load(std::memory_order_acquire);
+}
+
+template <typename T> bool ConcurrentArray<T>::ready(std::size_t index) const {
+  if (index >= size())
+    return false;
+  const auto slot = find_(index);
+  return slot && slot->ready.load(std::memory_order_acquire);
+}
+
+template <typename T>
+const T &ConcurrentArray<T>::operator[](std::size_t index) const {
+  return const_cast<ConcurrentArray *>(this)->operator[](index);
+}
+
+template <typename T> T &ConcurrentArray<T>::operator[](std::size_t index) {
+  if (index >= size())
+    throw std::out_of_range(outOfRangeMsg_);
+  assert(ready(index));
+  return *find_(index)->value();
+}
+
+template <typename T>
+ConcurrentArray<T>::Iterator ConcurrentArray<T>::begin() {
+  return Iterator(this, 0, size());
+}
+
+template <typename T> ConcurrentArray<T>::Iterator ConcurrentArray<T>::end() {
+  return Iterator(this, SIZE_MAX, SIZE_MAX);
+}
+
+template <typename T>
+ConcurrentArray<T>::ConstIterator ConcurrentArray<T>::begin() const {
+  return ConstIterator(this, 0, size());
+}
+
+template <typename T>
+ConcurrentArray<T>::ConstIterator ConcurrentArray<T>::end() const {
+  return ConstIterator(this, SIZE_MAX, SIZE_MAX);
+}
+
+template <typename T>
+Array<T> ConcurrentArray<T>::freeze(memory::MemoryResource *resource) {
+  Array<T> result(size(), resource);
+  for (auto &element : *this)
+    result.emplace(std::move(element));
+  release_();
+  return result;
+}
+
+template <typename T> void ConcurrentArray<T>::clear() { release_(); }
+
+template <typename T>
+std::size_t ConcurrentArray<T>::segmentOf_(std::size_t index) {
+  return std::bit_width((index >> firstSegmentShift_) + 1) - 1;
+}
+
+template <typename T>
+std::size_t ConcurrentArray<T>::segmentSize_(std::size_t segment) {
+  return firstSegment_ << segment;
+}
+
+template <typename T>
+std::size_t ConcurrentArray<T>::segmentStart_(std::size_t segment) {
+  return firstSegment_ * ((std::size_t(1) << segment) - 1);
+}
+
+template <typename T>
+ConcurrentArray<T>::Slot_ *ConcurrentArray<T>::find_(std::size_t index) const {
+  const auto segment = segmentOf_(index);
+  const auto slots = segments_[segment].load(std::memory_order_acquire);
+  return slots ? slots + (index - segmentStart_(segment)) : nullptr;
+}
+
+template <typename T>
+ConcurrentArray<T>::Slot_ *ConcurrentArray<T>::slot_(std::size_t index) {
+  const auto segment = segmentOf_(index);
+  auto slots = segments_[segment].load(std::memory_order_acquire);
+  if (!slots)
+    slots = install_(segment);
+  return slots + (index - segmentStart_(segment));
+}
+
+// normally only the push at the middle of the previous segment gets here, half
+// a segment of pushes ahead of anyone needing it. a push that still finds its
+// segment missing (the first one, or one that outran the installer) allocates
+// too, the first to install wins and the others throw theirs away, so no push
+// ever waits for another thread
+template <typename T>
+ConcurrentArray<T>::Slot_ *ConcurrentArray<T>::install_(std::size_t segment) {
+  auto slots = segments_[segment].load(std::memory_order_acquire);
+  if (slots)
+    return slots;
+  const auto count = segmentSize_(segment);
+  const auto fresh = static_cast<Slot_ *>(
+      resource_->allocate(count * sizeof(Slot_), alignof(Slot_)));
+  // only the ready flags are initialized, the storage stays untouched
+  std::uninitialized_default_construct_n(fresh, count);
+  if (segments_[segment].compare_exchange_strong(slots, fresh,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+    return fresh;
+  std::destroy_n(fresh, count);
+  resource_->deallocate(fresh, count * sizeof(Slot_), alignof(Slot_));
+  return slots;
+}
+
+// a throwing constructor (or allocation) leaves its slot unready for good,
+// readers skip it
+template <typename T>
+template <typename... Args>
+std::size_t ConcurrentArray<T>::construct_(Args &&...args) {
+  const auto index = size_.fetch_add(1, std::memory_order_relaxed);
+  const auto slot = slot_(index);
+  const auto segment = segmentOf_(index);
+  if (index == segmentStart_(segment) + segmentSize_(segment) / 2 &&
+      segment + 1 < maxSegments_)
+    install_(segment + 1);
+  ::new (slot->storage) T(std::forward<Args>(args)...);
+  slot->ready.store(true, std::memory_order_release);
+  return index;
+}
+
+template <typename T> void ConcurrentArray<T>::release_() noexcept {
+  for (std::size_t segment = 0; segment < maxSegments_; ++segment) {
+    const auto slots = segments_[segment].exchange(nullptr);
+    if (!slots)
+      continue;
+    const auto count = segmentSize_(segment);
+    for (std::size_t i = 0; i < count; ++i)
+      if (slots[i].ready.load(std::memory_order_relaxed))
+        std::destroy_at(slots[i].value());
+    std::destroy_n(slots, count);
+    resource_->deallocate(slots, count * sizeof(Slot_), alignof(Slot_));
+  }
+  size_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace mcpp::data_structures
+
+#endif // MODERN_CPP_INC_DATA_STRUCTURES_CONCURRENT_ARRAY_HPP
@@ -1,30 +1,180 @@
 #ifndef MODERN_CPP_INC_DATA_STRUCTURES_ARRAY_HPP
 #define MODERN_CPP_INC_DATA_STRUCTURES_ARRAY_HPP
 
+#include "memory/memory_resource.hpp"
+#include "type_traits/type_traits.hpp"
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
 
 namespace mcpp::data_structures {
 
+namespace detail {
+
+// raw storage and growth policy shared by the array types. buffers come from
+// a memory resource, with capacity elements of room each
+template <typename T> struct ArrayStorage {
+  static constexpr auto initialCapacity = std::size_t(10);
+  // reason for this factor here: https://archive.ph/Z2R8w
+  static constexpr auto expansionFactor = 1.618033988749894;
+  static constexpr auto relocatesBytes =
+      type_traits::IsTriviallyRelocatableV<T>;
+
+  static std::size_t grownCapacity(std::size_t capacity) {
+    return std::max(std::size_t(capacity * expansionFactor),
+                    std::max(capacity + 1, initialCapacity));
+  }
+
+  static T *allocate(std::size_t capacity, memory::MemoryResource *resource) {
+    if (capacity == 0)
+      return nullptr;
+    return static_cast<T *>(
+        resource->allocate(capacity * sizeof(T), alignof(T)));
+  }
+
+  static void deallocate(T *data, std::size_t capacity,
+                         memory::MemoryResource *resource) noexcept {
+    if (data)
+      resource->deallocate(data, capacity * sizeof(T), alignof(T));
+  }
+
+  // moves count elements into the uninitialized storage at to and ends the
+  // lifetime of the originals. if it throws (only possible when copying, for
+  // types whose move constructor may throw) the originals are left as they
+  // were
+  static void relocate(T *from, std::size_t count, T *to) {
+    if (count == 0)
+      return;
+    if constexpr (relocatesBytes) {
+      std::memcpy(static_cast<void *>(to), from, count * sizeof(T));
+    } else {
+      if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                    !std::is_copy_constructible_v<T>)
+        std::uninitialized_move_n(from, count, to);
+      else
+        std::uninitialized_copy_n(from, count, to);
+      std::destroy_n(from, count);
+    }
+  }
+
+  // a buffer of newCapacity with the count elements of data relocated into
+  // it. data is freed if owned (it isn't when it's an inline buffer), and
+  // heap blocks of elements that move as bytes are simply realloc'd
+  static T *reallocate(T *data, std::size_t count, std::size_t capacity,
+                       std::size_t newCapacity,
+                       memory::MemoryResource *resource, bool owned = true) {
+    if constexpr (relocatesBytes)
+      if (owned && resource == memory::heapResource())
+        return static_cast<T *>(memory::heapResource()->reallocate(
+            data, capacity * sizeof(T), newCapacity * sizeof(T),
+            alignof(T)));
+    const auto newData = allocate(newCapacity, resource);
+    try {
+      relocate(data, count, newData);
+    } catch (...) {
+      deallocate(newData, newCapacity, resource);
+      throw;
+    }
+    if (owned)
+      deallocate(data, capacity, resource);
+    return newData;
+  }
+
+  // like reallocate, with a new element constructed at index count. it's
+  // built before anything moves, since args may refer to the old elements:
+  // in its final place if the old ones get moved one by one, in a slot of
+  // its own if they're moved as bytes (realloc frees them)
+  template <typename... Args>
+  static T *emplaceGrowing(T *data, std::size_t count, std::size_t capacity,
+                           std::size_t newCapacity,
+                           memory::MemoryResource *resource, bool owned,
+                           Args &&...args) {
+    if constexpr (relocatesBytes) {
+      alignas(T) unsigned char slot[sizeof(T)];
+      ::new (slot) T(std::forward<Args>(args)...);
+      T *newData;
+      try {
+        newData =
+            reallocate(data, count, capacity, newCapacity, resource, owned);
+      } catch (...) {
+        std::destroy_at(reinterpret_cast<T *>(slot));
+        throw;
+      }
+      std::memcpy(static_cast<void *>(newData + count), slot, sizeof(T));
+      return newData;
+    } else {
+      const auto newData = allocate(newCapacity, resource);
+      try {
+        ::new (newData + count) T(std::forward<Args>(args)...);
+      } catch (...) {
+        deallocate(newData, newCapacity, resource);
+        throw;
+      }
+      try {
+        relocate(data, count, newData);
+      } catch (...) {
+        std::destroy_at(newData + count);
+        deallocate(newData, newCapacity, resource);
+        throw;
+      }
+      if (owned)
+        deallocate(data, capacity, resource);
+      return newData;
+    }
+  }
+};
+
+} // namespace detail
+
+// elements live in raw storage, only the first size() slots are constructed.
+// growth moves the elements over (copies them if moving could throw), and
+// trivially relocatable ones (see type_traits::IsTriviallyRelocatable) are
+// moved as plain bytes, with realloc when the storage is on the heap. the
+// storage comes from a memory resource, see memory/memory_resource.hpp
 template <typename T> class Array {
 public:
   using Iterator = T *;
   using ConstIterator = const T *;
 
+  // doesn't allocate until the first push
   Array();
-  explicit Array(std::size_t);
-  Array(const std::initializer_list<T> &);
+  explicit Array(memory::MemoryResource *);
+  explicit Array(std::size_t,
+                 memory::MemoryResource * = memory::defaultResource());
+  Array(const std::initializer_list<T> &,
+        memory::MemoryResource * = memory::defaultResource());
+  Array(const Array &, memory::MemoryResource * = memory::defaultResource());
+  Array(Array &&) noexcept;
 
   ~Array();
 
+  // assignment keeps this array's resource. moving from an array with a
+  // different one moves the elements over one by one
+  Array &operator=(const Array &);
+  Array &operator=(Array &&);
+
   auto push(const T &);
+  auto push(T &&);
+  // constructs the element in place, the arguments may refer to elements of
+  // this array even if it has to grow
+  template <typename... Args> T &emplace(Args &&...);
+  // makes room for at least that many elements without changing the size
+  auto reserve(std::size_t);
   auto remove(const T &);
   [[nodiscard]] auto contains(const T &) const;
   auto clear();
   [[nodiscard]] auto size() const;
+  [[nodiscard]] auto capacity() const;
+  [[nodiscard]] memory::MemoryResource *resource() const;
 
   [[nodiscard]] const auto &operator[](std::size_t) const;
   auto &operator[](std::size_t);
@@ -37,44 +187,119 @@ public:
   ConstIterator end() const;
 
 private:
-  auto expand_();
+  using Storage_ = detail::ArrayStorage<T>;
+
   auto reallocate_(std::size_t);
 
   static constexpr auto outOfRangeMsg_ = "out of range";
-  static constexpr auto initialCapacity_ = std::size_t(10);
-  // reason for this factor here: https://archive.ph/Z2R8w
-  static constexpr auto expansionFactor_ = 1.618033988749894;
 
   T *data_;
   std::size_t capacity_, size_;
+  memory::MemoryResource *resource_;
 };
 
-template <typename T> Array<T>::Array() : Array(initialCapacity_) {}
+template <typename T> Array<T>::Array() : Array(memory::defaultResource()) {}
 
 template <typename T>
-Array<T>::Array(std::size_t initialCapacity)
-    : data_(new T[initialCapacity]), capacity_(initialCapacity), size_(0) {}
+Array<T>::Array(memory::MemoryResource *resource)
+    : data_(nullptr), capacity_(0), size_(0), resource_(resource) {}
 
 template <typename T>
-Array<T>::Array(const std::initializer_list<T> &list)
-    : data_(new T[list.size()]), capacity_(list.size()), size_(list.size()) {
-  std::copy(std::cbegin(list), std::cend(list), data_);
+Array<T>::Array(std::size_t initialCapacity, memory::MemoryResource *resource)
+    : data_(Storage_::allocate(initialCapacity, resource)),
+      capacity_(initialCapacity), size_(0), resource_(resource) {}
+
+template <typename T>
+Array<T>::Array(const std::initializer_list<T> &list,
+                memory::MemoryResource *resource)
+    : Array(list.size(), resource) {
+  std::uninitialized_copy(std::cbegin(list), std::cend(list), data_);
+  size_ = list.size();
 }
 
-template <typename T> Array<T>::~Array() { delete[] data_; }
+template <typename T>
+Array<T>::Array(const Array &other, memory::MemoryResource *resource)
+    : Array(other.size_, resource) {
+  std::uninitialized_copy(other.data_, other.data_ + other.size_, data_);
+  size_ = other.size_;
+}
 
-template <typename T> auto Array<T>::push(const T &value) {
-  if (size_ == capacity_)
-    expand_();
-  data_[size_++] = value;
+template <typename T>
+Array<T>::Array(Array &&other) noexcept
+    : data_(other.data_), capacity_(other.capacity_), size_(other.size_),
+      resource_(other.resource_) {
+  other.data_ = nullptr;
+  other.capacity_ = other.size_ = 0;
 }
 
-template <typename T> auto Array<T>::remove(const T &value) {
-  if (std::remove(data_, data_ + size_, value) < end()) {
-    --size_;
-    return true;
+template <typename T> Array<T>::~Array() {
+  std::destroy_n(data_, size_);
+  Storage_::deallocate(data_, capacity_, resource_);
+}
+
+template <typename T> Array<T> &Array<T>::operator=(const Array &other) {
+  if (this == &other)
+    goto skipCopy;
+  {
+    // built aside first, so a throwing copy leaves this untouched
+    Array copy(other, resource_);
+    *this = std::move(copy);
+  }
+skipCopy:
+  return *this;
+}
+
+template <typename T> Array<T> &Array<T>::operator=(Array &&other) {
+  if (this == &other)
+    goto skipMove;
+  if (resource_ != other.resource_) {
+    Array moved(other.size_, resource_);
+    for (auto &element : other)
+      moved.emplace(std::move(element));
+    other.clear();
+    *this = std::move(moved);
+    goto skipMove;
   }
-  return false;
+  std::destroy_n(data_, size_);
+  Storage_::deallocate(data_, capacity_, resource_);
+  data_ = std::exchange(other.data_, nullptr);
+  capacity_ = std::exchange(other.capacity_, 0);
+  size_ = std::exchange(other.size_, 0);
+skipMove:
+  return *this;
+}
+
+template <typename T> auto Array<T>::push(const T &value) { emplace(value); }
+
+template <typename T> auto Array<T>::push(T &&value) {
+  emplace(std::move(value));
+}
+
+template <typename T>
+template <typename... Args>
+T &Array<T>::emplace(Args &&...args) {
+  if (size_ != capacity_)
+    return *::new (data_ + size_++) T(std::forward<Args>(args)...);
+  const auto newCapacity = Storage_::grownCapacity(capacity_);
+  data_ = Storage_::emplaceGrowing(data_, size_, capacity_, newCapacity,
+                                   resource_, true,
+                                   std::forward<Args>(args)...);
+  capacity_ = newCapacity;
+  return data_[size_++];
+}
+
+template <typename T> auto Array<T>::reserve(std::size_t capacity) {
+  if (capacity > capacity_)
+    reallocate_(capacity);
+}
+
+template <typename T> auto Array<T>::remove(const T &value) {
+  const auto newEnd = std::remove(begin(), end(), value);
+  if (newEnd == end())
+    return false;
+  std::destroy(newEnd, end());
+  size_ = newEnd - data_;
+  return true;
 }
 
 template <typename T> auto Array<T>::contains(const T &value) const {
@@ -83,18 +308,24 @@ template <typename T> auto Array<T>::contains(const T &value) const {
 }
 
 template <typename T> auto Array<T>::clear() {
-  reallocate_(initialCapacity_);
-  size_ = 0;
+  std::destroy_n(data_, size_);
+  Storage_::deallocate(data_, capacity_, resource_);
+  data_ = nullptr;
+  capacity_ = size_ = 0;
 }
 
 template <typename T> auto Array<T>::size() const { return size_; }
 
+template <typename T> auto Array<T>::capacity() const { return capacity_; }
+
+template <typename T>
+memory::MemoryResource *Array<T>::resource() const {
+  return resource_;
+}
+
 template <typename T>
 const auto &Array<T>::operator[](std::size_t index) const {
-  // if (index >= size_)
-  // throw std::out_of_range(outOfRangeMsg_);
-  // return data_[index];
-  return const_cast<const Array *>(this)->operator[](index); // ? valid i guess
+  return const_cast<Array *>(this)->operator[](index);
 }
 
 template <typename T> auto &Array<T>::operator[](std::size_t index) {
@@ -118,14 +349,10 @@ template <typename T> Array<T>::ConstIterator Array<T>::end() const {
 }
 
 template <typename T> auto Array<T>::reallocate_(std::size_t newCapacity) {
-  auto newData = new T[capacity_ = newCapacity];
-  std::copy(data_, data_ + size_, newData);
-  delete[] data_;
-  data_ = newData;
-}
-
-template <typename T> auto Array<T>::expand_() {
-  reallocate_(capacity_ * expansionFactor_);
+  assert(newCapacity >= size_);
+  data_ = Storage_::reallocate(data_, size_, capacity_, newCapacity,
+                               resource_);
+  capacity_ = newCapacity;
 }
 
 // non-member functions
@@ -140,6 +367,16 @@ std::ostream &operator<<(std::ostream &stream, const Array<T> &array) {
   return stream << ']';
 }
 
-} // namespace data_structures
+} // namespace mcpp::data_structures
+
+namespace mcpp::type_traits {
+
+// pointers and sizes, nothing points back into the object
+template <typename T>
+struct IsTriviallyRelocatable<data_structures::Array<T>> {
+  static constexpr const bool value = true;
+};
+
+} // namespace mcpp::type_traits
 
 #endif // MODERN_CPP_INC_DATA_STRUCTURES_ARRAY_HPP
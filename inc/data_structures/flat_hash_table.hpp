@@ -0,0 +1,925 @@
+#ifndef MODERN_CPP_INC_DATA_STRUCTURES_FLAT_HASH_TABLE_HPP
+#define MODERN_CPP_INC_DATA_STRUCTURES_FLAT_HASH_TABLE_HPP
+
+#include "memory/memory_resource.hpp"
+#include "misc/string.hpp"
+#include "type_traits/type_traits.hpp"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mcpp::data_structures {
+
+// hash and equality for the flat tables. the generic ones defer to std, the
+// BasicString ones are transparent: they also take C strings and string
+// views, so looking one up never builds a temporary BasicString. the tables
+// mix whatever comes out of Hash, so it needn't spread its bits itself
+template <typename K> struct Hash : std::hash<K> {};
+
+template <typename K> struct EqualTo : std::equal_to<K> {};
+
+namespace detail {
+
+// the high and low halves of a full 64x64 bit product xored together, every
+// output bit depends on every input bit
+inline std::uint64_t multiplyFold(std::uint64_t a, std::uint64_t b) {
+  const auto product = static_cast<unsigned __int128>(a) * b;
+  return std::uint64_t(product) ^ std::uint64_t(product >> 64);
+}
+
+template <typename U> U load(const unsigned char *bytes) {
+  U value;
+  std::memcpy(&value, bytes, sizeof(U));
+  return value;
+}
+
+// 8 bytes at a time, each folded into the hash with a multiply. the last
+// ones are read as one overlapping word (or for fewer than 8 bytes, two
+// overlapping halves or three single bytes), so there are no loops or
+// variable sized copies for the tail
+inline std::size_t hashBytes(const void *data, std::size_t size) {
+  constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15;
+  const auto bytes = static_cast<const unsigned char *>(data);
+  std::uint64_t hash = size, last = 0;
+  std::size_t i = 0;
+  for (; i + 8 < size; i += 8)
+    hash = multiplyFold(hash ^ load<std::uint64_t>(bytes + i), multiplier);
+  if (size >= 8)
+    last = load<std::uint64_t>(bytes + size - 8);
+  else if (size >= 4)
+    last = std::uint64_t(load<std::uint32_t>(bytes)) << 32 |
+           load<std::uint32_t>(bytes + size - 4);
+  else if (size > 0)
+    last = std::uint64_t(bytes[0]) << 16 | bytes[size / 2] << 8 |
+           bytes[size - 1];
+  return multiplyFold(hash ^ last, multiplier);
+}
+
+template <Char C> std::basic_string_view<C> charsOf(const BasicString<C> &s) {
+  return {s.data(), s.length()};
+}
+
+template <Char C> std::basic_string_view<C> charsOf(const C *s) { return s; }
+
+template <Char C>
+std::basic_string_view<C> charsOf(std::basic_string_view<C> s) {
+  return s;
+}
+
+} // namespace detail
+
+template <Char C> struct Hash<BasicString<C>> {
+  using is_transparent = void;
+
+  template <typename S> std::size_t operator()(const S &s) const {
+    const auto chars = detail::charsOf<C>(s);
+    return detail::hashBytes(chars.data(), chars.size() * sizeof(C));
+  }
+};
+
+template <Char C> struct EqualTo<BasicString<C>> {
+  using is_transparent = void;
+
+  template <typename S1, typename S2>
+  bool operator()(const S1 &a, const S2 &b) const {
+    return detail::charsOf<C>(a) == detail::charsOf<C>(b);
+  }
+};
+
+namespace detail {
+
+// 16 control bytes probed at once: with sse2 a compare and a movemask give a
+// bit per byte that matches, elsewhere a plain loop does
+class ControlGroup {
+public:
+  static constexpr std::size_t width = 16;
+
+  explicit ControlGroup(const std::int8_t *control) {
+#if defined(__SSE2__)
+    bytes_ = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control));
+#else
+    std::memcpy(bytes_, control, width);
+#endif
+  }
+
+  // the bytes equal to a full slot's hash bits
+  [[nodiscard]] std::uint32_t match(std::int8_t hashBits) const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hashBits), bytes_));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < width; ++i)
+      mask |= std::uint32_t(bytes_[i] == hashBits) << i;
+    return mask;
+#endif
+  }
+
+  // the empty bytes, the only ones with the sign bit set
+  [[nodiscard]] std::uint32_t matchEmpty() const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(bytes_);
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < width; ++i)
+      mask |= std::uint32_t(bytes_[i] < 0) << i;
+    return mask;
+#endif
+  }
+
+private:
+#if defined(__SSE2__)
+  __m128i bytes_;
+#else
+  std::int8_t bytes_[width];
+#endif
+};
+
+// how a table keeps its elements in the slots. a set's slot is just its key
+template <typename T> struct SlotPolicy {
+  using Slot = T;
+
+  static T *element(Slot *slot) { return slot; }
+
+  template <typename... Args>
+  static void construct(Slot *slot, Args &&...args) {
+    ::new (slot) T(std::forward<Args>(args)...);
+  }
+
+  static void destroy(Slot *slot) { std::destroy_at(slot); }
+
+  // into an empty slot, leaving from empty
+  static void relocate(Slot *from, Slot *to) {
+    if constexpr (type_traits::IsTriviallyRelocatableV<T>) {
+      std::memcpy(static_cast<void *>(to), from, sizeof(T));
+    } else {
+      ::new (to) T(std::move(*from));
+      std::destroy_at(from);
+    }
+  }
+};
+
+// a map's slot is a union of the pair it hands out and the same pair with a
+// mutable key, the way abseil does it. the pairs are built as the mutable one,
+// so moving the key out on relocation modifies a key that isn't actually
+// const, and both being standard layout, the const one reads the same bytes.
+// pairs that aren't standard layout are built const and relocation copies
+// their key
+template <typename K, typename V> struct SlotPolicy<std::pair<const K, V>> {
+  using Value = std::pair<const K, V>;
+  using MutableValue = std::pair<K, V>;
+
+  static constexpr bool mutableKeys = std::is_standard_layout_v<Value> &&
+                                      std::is_standard_layout_v<MutableValue>;
+
+  union Slot {
+    Value value;
+    MutableValue mutableValue;
+  };
+
+  static Value *element(Slot *slot) { return std::launder(&slot->value); }
+
+  template <typename... Args>
+  static void construct(Slot *slot, Args &&...args) {
+    if constexpr (mutableKeys)
+      ::new (&slot->mutableValue) MutableValue(std::forward<Args>(args)...);
+    else
+      ::new (&slot->value) Value(std::forward<Args>(args)...);
+  }
+
+  static void destroy(Slot *slot) {
+    if constexpr (mutableKeys)
+      std::destroy_at(&slot->mutableValue);
+    else
+      std::destroy_at(&slot->value);
+  }
+
+  static void relocate(Slot *from, Slot *to) {
+    if constexpr (type_traits::IsTriviallyRelocatableV<Value>) {
+      std::memcpy(static_cast<void *>(to), from, sizeof(Slot));
+    } else if constexpr (mutableKeys) {
+      ::new (&to->mutableValue) MutableValue(std::move(from->mutableValue));
+      std::destroy_at(&from->mutableValue);
+    } else {
+      ::new (&to->value)
+          Value(from->value.first, std::move(from->value.second));
+      std::destroy_at(&from->value);
+    }
+  }
+};
+
+template <typename H, typename E>
+concept TransparentLookup =
+    requires { typename H::is_transparent; typename E::is_transparent; };
+
+// the open addressing table under FlatHashSet and FlatHashMap, in the style
+// of abseil's swiss tables: a control byte per slot holds either "empty" or
+// the low 7 bits of the slot's hash, so a probe checks 16 slots with a couple
+// of instructions and only compares keys whose 7 bits match. probing is
+// linear, group after group from the slot the hash picks, which lets removal
+// shift the following elements back instead of leaving tombstones: a table
+// never fills up with deleted slots, and lookups never walk over them. the
+// control bytes of the first group are mirrored after the last one, so a
+// group can start at any slot and still be read with a single load. T is
+// what's stored, KeyOf gets the key out of it
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+class FlatHashTable {
+  // U is T or const T
+  template <typename U> class Iterator_ {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = U *;
+    using reference = U &;
+
+    Iterator_() = default;
+    Iterator_(const FlatHashTable *, std::size_t);
+
+    Iterator_ &operator++();
+    Iterator_ operator++(int);
+    U &operator*() const;
+    U *operator->() const;
+    bool operator==(const Iterator_ &) const;
+    bool operator!=(const Iterator_ &) const;
+
+  private:
+    // moves forward to the first full slot from index_ on
+    void skipEmpty_();
+
+    const FlatHashTable *table_{};
+    std::size_t index_{};
+  };
+
+public:
+  using Iterator = Iterator_<T>;
+  using ConstIterator = Iterator_<const T>;
+
+  explicit FlatHashTable(
+      memory::MemoryResource * = memory::defaultResource());
+  FlatHashTable(const FlatHashTable &,
+                memory::MemoryResource * = memory::defaultResource());
+  FlatHashTable(FlatHashTable &&) noexcept;
+
+  ~FlatHashTable();
+
+  // assignment keeps this table's resource, moving from a table with a
+  // different one moves the elements over one by one
+  FlatHashTable &operator=(const FlatHashTable &);
+  FlatHashTable &operator=(FlatHashTable &&);
+
+  // with a transparent Hash and EqualTo the lookups take anything they
+  // accept, otherwise keys
+  template <typename Q>
+    requires TransparentLookup<H, E>
+  [[nodiscard]] bool contains(const Q &) const;
+  [[nodiscard]] bool contains(const K &) const;
+  template <typename Q>
+    requires TransparentLookup<H, E>
+  [[nodiscard]] T *find(const Q &);
+  template <typename Q>
+    requires TransparentLookup<H, E>
+  [[nodiscard]] const T *find(const Q &) const;
+  [[nodiscard]] T *find(const K &);
+  [[nodiscard]] const T *find(const K &) const;
+  template <typename Q>
+    requires TransparentLookup<H, E>
+  bool remove(const Q &);
+  bool remove(const K &);
+
+  // makes room for that many elements without growing again
+  void reserve(std::size_t);
+  void clear();
+  [[nodiscard]] std::size_t size() const;
+  [[nodiscard]] std::size_t capacity() const;
+  [[nodiscard]] memory::MemoryResource *resource() const;
+
+  Iterator begin();
+  Iterator end();
+  ConstIterator begin() const;
+  ConstIterator end() const;
+
+protected:
+  // the element with key, built from args if there's none yet. the bool says
+  // whether it was inserted
+  template <typename Q, typename... Args>
+  std::pair<T *, bool> tryEmplace_(const Q &key, Args &&...args);
+
+private:
+  static constexpr std::int8_t empty_ = -128;
+  static constexpr std::size_t groupWidth_ = ControlGroup::width,
+                               minCapacity_ = groupWidth_, notFound_ = -1;
+
+  // spreads the hash over all bits, the low 7 go in the control byte and
+  // the rest pick the first slot
+  std::size_t hash_(const auto &key) const;
+  static std::int8_t hashBits_(std::size_t hash);
+  // at most 4/5 full, linear probing needs more empty slots than swiss
+  // tables' 7/8 to keep its clusters short
+  static std::size_t maxSize_(std::size_t capacity);
+
+  using Policy_ = SlotPolicy<T>;
+  using Slot_ = typename Policy_::Slot;
+
+  [[nodiscard]] T *element_(std::size_t index) const;
+
+  template <typename Q> std::size_t findIndex_(const Q &) const;
+  std::size_t findEmpty_(std::size_t hash) const;
+  void setControl_(std::size_t index, std::int8_t value);
+  void removeAt_(std::size_t index);
+  void rehash_(std::size_t newCapacity);
+  void allocate_(std::size_t capacity);
+  void release_() noexcept;
+  // marks every slot empty without destroying anything, for when the
+  // elements have been relocated or destroyed already
+  void forget_() noexcept;
+  // the block holds the control bytes and then the slots
+  [[nodiscard]] std::size_t blockBytes_() const;
+  [[nodiscard]] static std::size_t slotsOffset_(std::size_t capacity);
+
+  std::int8_t *control_;
+  Slot_ *slots_;
+  std::size_t capacity_, size_;
+  memory::MemoryResource *resource_;
+  [[no_unique_address]] H hasher_;
+  [[no_unique_address]] E equal_;
+};
+
+// iterator member functions
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::Iterator_(
+    const FlatHashTable *table, std::size_t index)
+    : table_(table), index_(index) {
+  skipEmpty_();
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U> &
+FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::operator++() {
+  ++index_;
+  skipEmpty_();
+  return *this;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>
+FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::operator++(int) {
+  const auto result = *this;
+  operator++();
+  return result;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+U &FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::operator*() const {
+  return *table_->element_(index_);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+U *FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::operator->() const {
+  return table_->element_(index_);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+bool FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::operator==(
+    const Iterator_ &other) const {
+  return index_ == other.index_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+bool FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::operator!=(
+    const Iterator_ &other) const {
+  return !operator==(other);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename U>
+void FlatHashTable<T, K, KeyOf, H, E>::Iterator_<U>::skipEmpty_() {
+  while (index_ < table_->capacity_ && table_->control_[index_] < 0)
+    ++index_;
+}
+
+// member functions
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::FlatHashTable(
+    memory::MemoryResource *resource)
+    : control_(nullptr), slots_(nullptr), capacity_(0), size_(0),
+      resource_(resource), hasher_(), equal_() {}
+
+// same capacity means same positions, so the control bytes are copied as
+// they are and every element is copied into its slot, no rehashing
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::FlatHashTable(
+    const FlatHashTable &other, memory::MemoryResource *resource)
+    : FlatHashTable(resource) {
+  if (other.size_ == 0)
+    return;
+  allocate_(other.capacity_);
+  std::size_t copied = 0;
+  try {
+    for (; copied < capacity_; ++copied)
+      if (other.control_[copied] >= 0)
+        Policy_::construct(slots_ + copied, *other.element_(copied));
+  } catch (...) {
+    for (std::size_t i = 0; i < copied; ++i)
+      if (other.control_[i] >= 0)
+        Policy_::destroy(slots_ + i);
+    forget_();
+    release_();
+    throw;
+  }
+  std::copy_n(other.control_, capacity_ + groupWidth_, control_);
+  size_ = other.size_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::FlatHashTable(FlatHashTable &&other) noexcept
+    : control_(std::exchange(other.control_, nullptr)),
+      slots_(std::exchange(other.slots_, nullptr)),
+      capacity_(std::exchange(other.capacity_, 0)),
+      size_(std::exchange(other.size_, 0)), resource_(other.resource_),
+      hasher_(other.hasher_), equal_(other.equal_) {}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::~FlatHashTable() {
+  release_();
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E> &
+FlatHashTable<T, K, KeyOf, H, E>::operator=(const FlatHashTable &other) {
+  if (this == &other)
+    goto skipCopy;
+  {
+    // built aside first, so a throwing copy leaves this untouched
+    FlatHashTable copy(other, resource_);
+    *this = std::move(copy);
+  }
+skipCopy:
+  return *this;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E> &
+FlatHashTable<T, K, KeyOf, H, E>::operator=(FlatHashTable &&other) {
+  if (this == &other)
+    goto skipMove;
+  if (resource_ != other.resource_) {
+    FlatHashTable moved(resource_);
+    moved.reserve(other.size_);
+    for (std::size_t i = 0; i < other.capacity_; ++i) {
+      if (other.control_[i] < 0)
+        continue;
+      const auto hash = hash_(KeyOf()(*other.element_(i)));
+      const auto index = moved.findEmpty_(hash);
+      Policy_::relocate(other.slots_ + i, moved.slots_ + index);
+      moved.setControl_(index, other.control_[i]);
+      ++moved.size_;
+    }
+    other.forget_();
+    *this = std::move(moved);
+    goto skipMove;
+  }
+  release_();
+  control_ = std::exchange(other.control_, nullptr);
+  slots_ = std::exchange(other.slots_, nullptr);
+  capacity_ = std::exchange(other.capacity_, 0);
+  size_ = std::exchange(other.size_, 0);
+skipMove:
+  return *this;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename Q>
+  requires TransparentLookup<H, E>
+bool FlatHashTable<T, K, KeyOf, H, E>::contains(const Q &key) const {
+  return findIndex_(key) != notFound_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+bool FlatHashTable<T, K, KeyOf, H, E>::contains(const K &key) const {
+  return findIndex_(key) != notFound_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename Q>
+  requires TransparentLookup<H, E>
+T *FlatHashTable<T, K, KeyOf, H, E>::find(const Q &key) {
+  const auto index = findIndex_(key);
+  return index == notFound_ ? nullptr : element_(index);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename Q>
+  requires TransparentLookup<H, E>
+const T *FlatHashTable<T, K, KeyOf, H, E>::find(const Q &key) const {
+  return const_cast<FlatHashTable *>(this)->find(key);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+T *FlatHashTable<T, K, KeyOf, H, E>::find(const K &key) {
+  const auto index = findIndex_(key);
+  return index == notFound_ ? nullptr : element_(index);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+const T *FlatHashTable<T, K, KeyOf, H, E>::find(const K &key) const {
+  return const_cast<FlatHashTable *>(this)->find(key);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename Q>
+  requires TransparentLookup<H, E>
+bool FlatHashTable<T, K, KeyOf, H, E>::remove(const Q &key) {
+  const auto index = findIndex_(key);
+  if (index == notFound_)
+    return false;
+  removeAt_(index);
+  return true;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+bool FlatHashTable<T, K, KeyOf, H, E>::remove(const K &key) {
+  const auto index = findIndex_(key);
+  if (index == notFound_)
+    return false;
+  removeAt_(index);
+  return true;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::reserve(std::size_t count) {
+  auto capacity = std::max(capacity_, minCapacity_);
+  while (maxSize_(capacity) < count)
+    capacity *= 2;
+  if (capacity != capacity_)
+    rehash_(capacity);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::clear() {
+  release_();
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t FlatHashTable<T, K, KeyOf, H, E>::size() const {
+  return size_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t FlatHashTable<T, K, KeyOf, H, E>::capacity() const {
+  return capacity_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+memory::MemoryResource *FlatHashTable<T, K, KeyOf, H, E>::resource() const {
+  return resource_;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::Iterator
+FlatHashTable<T, K, KeyOf, H, E>::begin() {
+  return Iterator(this, 0);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::Iterator
+FlatHashTable<T, K, KeyOf, H, E>::end() {
+  return Iterator(this, capacity_);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::ConstIterator
+FlatHashTable<T, K, KeyOf, H, E>::begin() const {
+  return ConstIterator(this, 0);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+FlatHashTable<T, K, KeyOf, H, E>::ConstIterator
+FlatHashTable<T, K, KeyOf, H, E>::end() const {
+  return ConstIterator(this, capacity_);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename Q, typename... Args>
+std::pair<T *, bool>
+FlatHashTable<T, K, KeyOf, H, E>::tryEmplace_(const Q &key, Args &&...args) {
+  const auto hash = hash_(key);
+  if (capacity_ != 0) {
+    const auto index = findIndex_(key);
+    if (index != notFound_)
+      return {element_(index), false};
+  }
+  if (size_ + 1 > maxSize_(capacity_))
+    rehash_(std::max(capacity_ * 2, minCapacity_));
+  const auto index = findEmpty_(hash);
+  Policy_::construct(slots_ + index, std::forward<Args>(args)...);
+  setControl_(index, hashBits_(hash));
+  ++size_;
+  return {element_(index), true};
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t FlatHashTable<T, K, KeyOf, H, E>::hash_(const auto &key) const {
+  return multiplyFold(hasher_(key), 0x9e3779b97f4a7c15);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::int8_t FlatHashTable<T, K, KeyOf, H, E>::hashBits_(std::size_t hash) {
+  return std::int8_t(hash & 0x7f);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t FlatHashTable<T, K, KeyOf, H, E>::maxSize_(std::size_t capacity) {
+  return capacity / 5 * 4;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+template <typename Q>
+std::size_t FlatHashTable<T, K, KeyOf, H, E>::findIndex_(const Q &key) const {
+  if (size_ == 0)
+    return notFound_;
+  const auto hash = hash_(key);
+  const auto bits = hashBits_(hash);
+  const auto mask = capacity_ - 1;
+  // a 4/5 full table always has an empty slot to stop at
+  for (auto group = (hash >> 7) & mask;; group = (group + groupWidth_) & mask) {
+    const ControlGroup control(control_ + group);
+    for (auto matches = control.match(bits); matches;
+         matches &= matches - 1) {
+      const auto index = (group + std::countr_zero(matches)) & mask;
+      if (equal_(KeyOf()(*element_(index)), key))
+        return index;
+    }
+    if (control.matchEmpty())
+      return notFound_;
+  }
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t
+FlatHashTable<T, K, KeyOf, H, E>::findEmpty_(std::size_t hash) const {
+  const auto mask = capacity_ - 1;
+  for (auto group = (hash >> 7) & mask;; group = (group + groupWidth_) & mask)
+    if (const auto empty = ControlGroup(control_ + group).matchEmpty())
+      return (group + std::countr_zero(empty)) & mask;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::setControl_(std::size_t index,
+                                                   std::int8_t value) {
+  control_[index] = value;
+  if (index < groupWidth_)
+    control_[capacity_ + index] = value;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+T *FlatHashTable<T, K, KeyOf, H, E>::element_(std::size_t index) const {
+  return Policy_::element(slots_ + index);
+}
+
+// backward shift: every element after the hole, up to the next empty slot,
+// moves into the hole if the hole lies between its first probed slot and
+// where it is now, and leaves a new hole behind
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::removeAt_(std::size_t index) {
+  const auto mask = capacity_ - 1;
+  Policy_::destroy(slots_ + index);
+  auto hole = index;
+  for (auto next = (index + 1) & mask; control_[next] >= 0;
+       next = (next + 1) & mask) {
+    const auto home = (hash_(KeyOf()(*element_(next))) >> 7) & mask;
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      Policy_::relocate(slots_ + next, slots_ + hole);
+      setControl_(hole, control_[next]);
+      hole = next;
+    }
+  }
+  setControl_(hole, empty_);
+  --size_;
+}
+
+// the new block is allocated before anything moves, so if that throws the
+// table is left as it was
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::rehash_(std::size_t newCapacity) {
+  assert(std::has_single_bit(newCapacity) && maxSize_(newCapacity) >= size_);
+  const auto oldControl = control_;
+  const auto oldSlots = slots_;
+  const auto oldCapacity = capacity_, oldBytes = blockBytes_();
+  allocate_(newCapacity);
+  for (std::size_t i = 0; i < oldCapacity; ++i) {
+    if (oldControl[i] < 0)
+      continue;
+    const auto hash = hash_(KeyOf()(*Policy_::element(oldSlots + i)));
+    const auto index = findEmpty_(hash);
+    Policy_::relocate(oldSlots + i, slots_ + index);
+    setControl_(index, hashBits_(hash));
+  }
+  if (oldControl)
+    resource_->deallocate(oldControl, oldBytes,
+                          std::max(alignof(Slot_), groupWidth_));
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::allocate_(std::size_t capacity) {
+  const auto block = static_cast<std::byte *>(resource_->allocate(
+      slotsOffset_(capacity) + capacity * sizeof(Slot_),
+      std::max(alignof(Slot_), groupWidth_)));
+  control_ = reinterpret_cast<std::int8_t *>(block);
+  slots_ = reinterpret_cast<Slot_ *>(block + slotsOffset_(capacity));
+  capacity_ = capacity;
+  std::fill_n(control_, capacity_ + groupWidth_, empty_);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::release_() noexcept {
+  if (!control_)
+    return;
+  for (std::size_t i = 0; i < capacity_; ++i)
+    if (control_[i] >= 0)
+      Policy_::destroy(slots_ + i);
+  resource_->deallocate(control_, blockBytes_(),
+                        std::max(alignof(Slot_), groupWidth_));
+  control_ = nullptr;
+  slots_ = nullptr;
+  capacity_ = size_ = 0;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+void FlatHashTable<T, K, KeyOf, H, E>::forget_() noexcept {
+  if (control_)
+    std::fill_n(control_, capacity_ + groupWidth_, empty_);
+  size_ = 0;
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t FlatHashTable<T, K, KeyOf, H, E>::blockBytes_() const {
+  return slotsOffset_(capacity_) + capacity_ * sizeof(Slot_);
+}
+
+template <typename T, typename K, typename KeyOf, typename H, typename E>
+std::size_t
+FlatHashTable<T, K, KeyOf, H, E>::slotsOffset_(std::size_t capacity) {
+  const auto control = capacity + groupWidth_;
+  return (control + alignof(Slot_) - 1) / alignof(Slot_) * alignof(Slot_);
+}
+
+struct IdentityKey {
+  template <typename T> const T &operator()(const T &value) const {
+    return value;
+  }
+};
+
+struct FirstKey {
+  template <typename P> const auto &operator()(const P &pair) const {
+    return pair.first;
+  }
+};
+
+} // namespace detail
+
+// a hash set of K stored inline in one flat block, see detail::FlatHashTable.
+// iteration yields the keys in no particular order; inserting or removing
+// moves elements, so pointers into the set don't survive either
+template <typename K, typename H = Hash<K>, typename E = EqualTo<K>>
+class FlatHashSet
+    : public detail::FlatHashTable<K, K, detail::IdentityKey, H, E> {
+  using Table_ = detail::FlatHashTable<K, K, detail::IdentityKey, H, E>;
+
+public:
+  using Table_::Table_;
+
+  FlatHashSet(const std::initializer_list<K> &,
+              memory::MemoryResource * = memory::defaultResource());
+
+  // whether the key wasn't there yet
+  bool insert(const K &);
+  bool insert(K &&);
+};
+
+template <typename K, typename H, typename E>
+FlatHashSet<K, H, E>::FlatHashSet(const std::initializer_list<K> &list,
+                                  memory::MemoryResource *resource)
+    : Table_(resource) {
+  this->reserve(list.size());
+  for (const auto &key : list)
+    insert(key);
+}
+
+template <typename K, typename H, typename E>
+bool FlatHashSet<K, H, E>::insert(const K &key) {
+  return this->tryEmplace_(key, key).second;
+}
+
+template <typename K, typename H, typename E>
+bool FlatHashSet<K, H, E>::insert(K &&key) {
+  return this->tryEmplace_(key, std::move(key)).second;
+}
+
+// a hash map from K to V, storing std::pair<const K, V> inline in one flat
+// block, see detail::FlatHashTable. find gives a pointer to the pair, or
+// nullptr; like the set, inserting or removing moves the pairs around
+template <typename K, typename V, typename H = Hash<K>,
+          typename E = EqualTo<K>>
+class FlatHashMap : public detail::FlatHashTable<std::pair<const K, V>, K,
+                                                 detail::FirstKey, H, E> {
+  using Table_ =
+      detail::FlatHashTable<std::pair<const K, V>, K, detail::FirstKey, H, E>;
+
+public:
+  using Table_::Table_;
+
+  // whether the key wasn't there yet, an existing value is left alone
+  bool insert(const K &, const V &);
+  bool insert(K &&, V &&);
+  // the value of key, default constructed if it wasn't there
+  V &operator[](const K &);
+  V &operator[](K &&);
+  // the value of key, which must be there
+  template <typename Q> [[nodiscard]] V &at(const Q &);
+  template <typename Q> [[nodiscard]] const V &at(const Q &) const;
+
+private:
+  static constexpr auto outOfRangeMsg_ = "key not found";
+};
+
+template <typename K, typename V, typename H, typename E>
+bool FlatHashMap<K, V, H, E>::insert(const K &key, const V &value) {
+  return this->tryEmplace_(key, key, value).second;
+}
+
+template <typename K, typename V, typename H, typename E>
+bool FlatHashMap<K, V, H, E>::insert(K &&key, V &&value) {
+  return this->tryEmplace_(key, std::move(key), std::move(value)).second;
+}
+
+template <typename K, typename V, typename H, typename E>
+V &FlatHashMap<K, V, H, E>::operator[](const K &key) {
+  return this->tryEmplace_(key, std::piecewise_construct,
+                           std::forward_as_tuple(key), std::tuple<>())
+      .first->second;
+}
+
+template <typename K, typename V, typename H, typename E>
+V &FlatHashMap<K, V, H, E>::operator[](K &&key) {
+  return this->tryEmplace_(key, std::piecewise_construct,
+                           std::forward_as_tuple(std::move(key)),
+                           std::tuple<>())
+      .first->second;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename Q>
+V &FlatHashMap<K, V, H, E>::at(const Q &key) {
+  const auto pair = this->find(key);
+  if (!pair)
+    throw std::out_of_range(outOfRangeMsg_);
+  return pair->second;
+}
+
+template <typename K, typename V, typename H, typename E>
+template <typename Q>
+const V &FlatHashMap<K, V, H, E>::at(const Q &key) const {
+  return const_cast<FlatHashMap *>(this)->at(key);
+}
+
+// non-member functions
+
+template <typename K, typename H, typename E>
+std::ostream &operator<<(std::ostream &stream,
+                         const FlatHashSet<K, H, E> &set) {
+  stream << '{';
+  std::copy(std::cbegin(set), std::cend(set),
+            std::ostream_iterator<K>(stream, ","));
+  if (set.size() != 0)
+    stream << '\b';
+  return stream << '}';
+}
+
+} // namespace mcpp::data_structures
+
+#endif // MODERN_CPP_INC_DATA_STRUCTURES_FLAT_HASH_TABLE_HPP
@@ -1,12 +1,16 @@
 #ifndef MODERN_CPP_INC_DATA_STRUCTURES_LINKED_LIST_HPP
 #define MODERN_CPP_INC_DATA_STRUCTURES_LINKED_LIST_HPP
 
+#include "memory/memory_resource.hpp"
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
+#include <memory>
 
 namespace mcpp::data_structures {
 
+// nodes come from a memory resource, a PoolResource suits them well since
+// they're all the same size
 template <typename T> class LinkedList {
 private:
   struct Node {
@@ -36,6 +40,7 @@ public:
   };
 
   LinkedList();
+  explicit LinkedList(memory::MemoryResource *);
 
   ~LinkedList();
 
@@ -44,6 +49,7 @@ public:
   [[maybe_unused]] auto contains(const T &) const;
   auto clear();
   [[maybe_unused]] auto size() const;
+  [[nodiscard]] memory::MemoryResource *resource() const;
 
   auto begin();
   auto end();
@@ -51,8 +57,11 @@ public:
   auto end() const;
 
 private:
+  void destroy_(Node *);
+
   Node *head_, *tail_;
   std::size_t size_;
+  memory::MemoryResource *resource_;
 };
 
 // iterator member functions
@@ -114,12 +123,24 @@ bool LinkedList<T>::Iterator::operator!=(
 
 // member functions
 
-template <typename T> LinkedList<T>::LinkedList() : head_(), tail_(), size_() {}
+template <typename T>
+LinkedList<T>::LinkedList() : LinkedList(memory::defaultResource()) {}
+
+template <typename T>
+LinkedList<T>::LinkedList(memory::MemoryResource *resource)
+    : head_(), tail_(), size_(), resource_(resource) {}
 
 template <typename T> LinkedList<T>::~LinkedList() { clear(); }
 
 template <typename T> auto LinkedList<T>::push(const T &value) {
-  auto newNode = new Node{value, nullptr};
+  const auto memory = resource_->allocate(sizeof(Node), alignof(Node));
+  Node *newNode;
+  try {
+    newNode = ::new (memory) Node{value, nullptr};
+  } catch (...) {
+    resource_->deallocate(memory, sizeof(Node), alignof(Node));
+    throw;
+  }
   if (head_)
     tail_ = tail_->next = newNode;
   else
@@ -128,12 +149,13 @@ template <typename T> auto LinkedList<T>::push(const T &value) {
 }
 
 template <typename T> auto LinkedList<T>::remove(const T &value) {
-  for (auto it = head_; it && it->next; it = it->next) {
-    if (it->next->value == value) {
-      auto tmp = it->next;
-      it->next = it->next->next;
-
-      delete tmp;
+  for (Node *prev = nullptr, *it = head_; it; prev = it, it = it->next) {
+    if (it->value == value) {
+      (prev ? prev->next : head_) = it->next;
+      if (it == tail_)
+        tail_ = prev;
+      destroy_(it);
+      --size_;
       return true;
     }
   }
@@ -150,9 +172,10 @@ template <typename T> auto LinkedList<T>::clear() {
   Node *tmp;
   while (head_) {
     tmp = head_->next;
-    delete head_;
+    destroy_(head_);
     head_ = tmp;
   }
+  tail_ = nullptr;
   size_ = 0;
 }
 
@@ -160,6 +183,11 @@ template <typename T> [[maybe_unused]] auto LinkedList<T>::size() const {
   return size_;
 }
 
+template <typename T>
+memory::MemoryResource *LinkedList<T>::resource() const {
+  return resource_;
+}
+
 template <typename T> auto LinkedList<T>::begin() { return Iterator(head_); }
 
 template <typename T> auto LinkedList<T>::end() { return Iterator(); }
@@ -170,6 +198,11 @@ template <typename T> auto LinkedList<T>::begin() const {
 
 template <typename T> auto LinkedList<T>::end() const { return Iterator(); }
 
+template <typename T> void LinkedList<T>::destroy_(Node *node) {
+  std::destroy_at(node);
+  resource_->deallocate(node, sizeof(Node), alignof(Node));
+}
+
 } // namespace mcpp::data_structures
 
 #endif // MODERN_CPP_INC_DATA_STRUCTURES_LINKED_LIST_HPP
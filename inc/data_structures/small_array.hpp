@@ -0,0 +1,311 @@
+#ifndef MODERN_CPP_INC_DATA_STRUCTURES_SMALL_ARRAY_HPP
+#define MODERN_CPP_INC_DATA_STRUCTURES_SMALL_ARRAY_HPP
+
+#include "data_structures/dynamic_array.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace mcpp::data_structures {
+
+// an Array that keeps up to N elements in an inline buffer, like BasicString
+// does with buf_, and only goes to the heap once it outgrows it. data_ points
+// at whichever buffer is in use. moving a small array that's still inline
+// moves its elements one by one instead of stealing a pointer. the heap buffer
+// comes from a memory resource, kept for life like Array does
+template <typename T, std::size_t N> class SmallArray {
+  static_assert(N > 0, "use Array for arrays without inline storage");
+
+public:
+  using Iterator = T *;
+  using ConstIterator = const T *;
+
+  SmallArray();
+  explicit SmallArray(memory::MemoryResource *);
+  explicit SmallArray(std::size_t,
+                      memory::MemoryResource * = memory::defaultResource());
+  SmallArray(const std::initializer_list<T> &,
+             memory::MemoryResource * = memory::defaultResource());
+  SmallArray(const SmallArray &,
+             memory::MemoryResource * = memory::defaultResource());
+  SmallArray(SmallArray &&) noexcept(std::is_nothrow_move_constructible_v<T>);
+
+  ~SmallArray();
+
+  // assignment keeps this array's resource, a heap buffer from another one
+  // gets its elements moved over instead of stolen
+  SmallArray &operator=(const SmallArray &);
+  SmallArray &operator=(SmallArray &&);
+
+  auto push(const T &);
+  auto push(T &&);
+  // constructs the element in place, the arguments may refer to elements of
+  // this array even if it has to grow
+  template <typename... Args> T &emplace(Args &&...);
+  // makes room for at least that many elements without changing the size
+  auto reserve(std::size_t);
+  auto remove(const T &);
+  [[nodiscard]] auto contains(const T &) const;
+  // also gives the heap buffer back, if there is one
+  auto clear();
+  [[nodiscard]] auto size() const;
+  [[nodiscard]] auto capacity() const;
+  // whether the elements are still in the inline buffer
+  [[nodiscard]] bool isInline() const;
+  [[nodiscard]] memory::MemoryResource *resource() const;
+
+  [[nodiscard]] const auto &operator[](std::size_t) const;
+  auto &operator[](std::size_t);
+
+  Iterator begin();
+  Iterator end();
+
+  ConstIterator begin() const;
+  ConstIterator end() const;
+
+private:
+  using Storage_ = detail::ArrayStorage<T>;
+
+  [[nodiscard]] T *buf_();
+  auto reallocate_(std::size_t);
+  // back to an empty inline buffer, freeing the heap one
+  void release_() noexcept;
+  // takes over other's elements, other is left empty and inline
+  void steal_(SmallArray &other);
+
+  static constexpr auto outOfRangeMsg_ = "out of range";
+
+  T *data_;
+  std::size_t capacity_, size_;
+  memory::MemoryResource *resource_;
+  alignas(T) unsigned char storage_[N * sizeof(T)];
+};
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::SmallArray() : SmallArray(memory::defaultResource()) {}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::SmallArray(memory::MemoryResource *resource)
+    : data_(buf_()), capacity_(N), size_(0), resource_(resource) {}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::SmallArray(std::size_t initialCapacity,
+                             memory::MemoryResource *resource)
+    : SmallArray(resource) {
+  reserve(initialCapacity);
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::SmallArray(const std::initializer_list<T> &list,
+                             memory::MemoryResource *resource)
+    : SmallArray(list.size(), resource) {
+  std::uninitialized_copy(std::cbegin(list), std::cend(list), data_);
+  size_ = list.size();
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::SmallArray(const SmallArray &other,
+                             memory::MemoryResource *resource)
+    : SmallArray(other.size_, resource) {
+  std::uninitialized_copy(other.data_, other.data_ + other.size_, data_);
+  size_ = other.size_;
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::SmallArray(SmallArray &&other) noexcept(
+    std::is_nothrow_move_constructible_v<T>)
+    : SmallArray(other.resource_) {
+  steal_(other);
+}
+
+template <typename T, std::size_t N> SmallArray<T, N>::~SmallArray() {
+  release_();
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N> &SmallArray<T, N>::operator=(const SmallArray &other) {
+  if (this == &other)
+    goto skipCopy;
+  {
+    // built aside first, so a throwing copy leaves this untouched
+    SmallArray copy(other, resource_);
+    *this = std::move(copy);
+  }
+skipCopy:
+  return *this;
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N> &SmallArray<T, N>::operator=(SmallArray &&other) {
+  if (this == &other)
+    goto skipMove;
+  if (resource_ != other.resource_ && !other.isInline()) {
+    SmallArray moved(other.size_, resource_);
+    for (auto &element : other)
+      moved.emplace(std::move(element));
+    other.release_();
+    *this = std::move(moved);
+    goto skipMove;
+  }
+  release_();
+  steal_(other);
+skipMove:
+  return *this;
+}
+
+template <typename T, std::size_t N>
+auto SmallArray<T, N>::push(const T &value) {
+  emplace(value);
+}
+
+template <typename T, std::size_t N> auto SmallArray<T, N>::push(T &&value) {
+  emplace(std::move(value));
+}
+
+template <typename T, std::size_t N>
+template <typename... Args>
+T &SmallArray<T, N>::emplace(Args &&...args) {
+  if (size_ != capacity_)
+    return *::new (data_ + size_++) T(std::forward<Args>(args)...);
+  const auto newCapacity = Storage_::grownCapacity(capacity_);
+  data_ = Storage_::emplaceGrowing(data_, size_, capacity_, newCapacity,
+                                   resource_, !isInline(),
+                                   std::forward<Args>(args)...);
+  capacity_ = newCapacity;
+  return data_[size_++];
+}
+
+template <typename T, std::size_t N>
+auto SmallArray<T, N>::reserve(std::size_t capacity) {
+  if (capacity > capacity_)
+    reallocate_(capacity);
+}
+
+template <typename T, std::size_t N>
+auto SmallArray<T, N>::remove(const T &value) {
+  const auto newEnd = std::remove(begin(), end(), value);
+  if (newEnd == end())
+    return false;
+  std::destroy(newEnd, end());
+  size_ = newEnd - data_;
+  return true;
+}
+
+template <typename T, std::size_t N>
+auto SmallArray<T, N>::contains(const T &value) const {
+  const auto end = data_ + size_;
+  return std::find(data_, end, value) != end;
+}
+
+template <typename T, std::size_t N> auto SmallArray<T, N>::clear() {
+  release_();
+}
+
+template <typename T, std::size_t N> auto SmallArray<T, N>::size() const {
+  return size_;
+}
+
+template <typename T, std::size_t N> auto SmallArray<T, N>::capacity() const {
+  return capacity_;
+}
+
+template <typename T, std::size_t N>
+bool SmallArray<T, N>::isInline() const {
+  return capacity_ == N;
+}
+
+template <typename T, std::size_t N>
+memory::MemoryResource *SmallArray<T, N>::resource() const {
+  return resource_;
+}
+
+template <typename T, std::size_t N>
+const auto &SmallArray<T, N>::operator[](std::size_t index) const {
+  return const_cast<SmallArray *>(this)->operator[](index);
+}
+
+template <typename T, std::size_t N>
+auto &SmallArray<T, N>::operator[](std::size_t index) {
+  if (index >= size_)
+    throw std::out_of_range(outOfRangeMsg_);
+  return data_[index];
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::Iterator SmallArray<T, N>::begin() {
+  return data_;
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::Iterator SmallArray<T, N>::end() {
+  return data_ + size_;
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::ConstIterator SmallArray<T, N>::begin() const {
+  return data_;
+}
+
+template <typename T, std::size_t N>
+SmallArray<T, N>::ConstIterator SmallArray<T, N>::end() const {
+  return data_ + size_;
+}
+
+template <typename T, std::size_t N> T *SmallArray<T, N>::buf_() {
+  return reinterpret_cast<T *>(storage_);
+}
+
+// only ever grows, so a heap buffer never goes back inline here
+template <typename T, std::size_t N>
+auto SmallArray<T, N>::reallocate_(std::size_t newCapacity) {
+  assert(newCapacity > N && newCapacity >= size_);
+  data_ = Storage_::reallocate(data_, size_, capacity_, newCapacity,
+                               resource_, !isInline());
+  capacity_ = newCapacity;
+}
+
+template <typename T, std::size_t N>
+void SmallArray<T, N>::release_() noexcept {
+  std::destroy_n(data_, size_);
+  if (!isInline())
+    Storage_::deallocate(data_, capacity_, resource_);
+  data_ = buf_();
+  capacity_ = N;
+  size_ = 0;
+}
+
+template <typename T, std::size_t N>
+void SmallArray<T, N>::steal_(SmallArray &other) {
+  if (other.isInline()) {
+    Storage_::relocate(other.data_, other.size_, data_);
+    size_ = other.size_;
+    other.size_ = 0;
+    return;
+  }
+  data_ = std::exchange(other.data_, other.buf_());
+  capacity_ = std::exchange(other.capacity_, N);
+  size_ = std::exchange(other.size_, 0);
+}
+
+// non-member functions
+
+template <typename T, std::size_t N>
+std::ostream &operator<<(std::ostream &stream,
+                         const SmallArray<T, N> &array) {
+  stream << '[';
+  std::copy(std::cbegin(array), std::cend(array),
+            std::ostream_iterator<T>(stream, ","));
+  if (array.size() != 0)
+    stream << '\b';
+  return stream << ']';
+}
+
+} // namespace mcpp::data_structures
+
+#endif // MODERN_CPP_INC_DATA_STRUCTURES_SMALL_ARRAY_HPP
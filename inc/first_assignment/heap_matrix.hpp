@@ -2,15 +2,62 @@
 #define MODERN_CPP_INC_FIRST_ASSIGNMENT_HEAP_MATRIX_HPP
 
 #include "math/matrix.hpp"
+#include <atomic>
 #include <memory>
+#include <utility>
 
 namespace mcpp::math::p1 {
 
+// a handle to a reference counted DMatrix with copy-on-write semantics:
+// copies share the elements and are as cheap as copying a shared_ptr, the
+// first write through a handle whose buffer is shared gives it a private copy.
+// copies can be handed to other threads and read or written there freely,
+// as long as each handle object is only used by one thread at a time.
+// the non-const operator() returns an Element proxy rather than a reference:
+// reading through it never copies, only assigning to it detaches. elementwise
+// arithmetic reuses the buffer of an rvalue operand that isn't
+// shared instead of allocating
 template <std::floating_point T> class HeapMatrix {
 public:
+  // one element of a handle, read like a T. assigning to it detaches the
+  // handle first if its buffer is shared. it refers to the handle, not the
+  // buffer, so it stays valid across detaches but not past the handle
+  class Element {
+  public:
+    operator T() const { return std::as_const(handle_)(row_, column_); }
+
+    Element &operator=(T value) {
+      handle_.detach_();
+      handle_.matrix_->operator()(row_, column_) = value;
+      return *this;
+    }
+
+    Element &operator=(const Element &other) { return *this = T(other); }
+
+    Element &operator+=(T value) { return *this = T(*this) + value; }
+    Element &operator-=(T value) { return *this = T(*this) - value; }
+    Element &operator*=(T value) { return *this = T(*this) * value; }
+    Element &operator/=(T value) { return *this = T(*this) / value; }
+
+  private:
+    friend class HeapMatrix;
+
+    Element(HeapMatrix &handle, std::size_t row, std::size_t column)
+        : handle_(handle), row_(row), column_(column) {}
+
+    HeapMatrix &handle_;
+    std::size_t row_, column_;
+  };
+
   HeapMatrix(std::size_t width, std::size_t height)
       : matrix_(std::make_shared<DMatrix<T>>(width, height)) {}
 
+  explicit HeapMatrix(const DMatrix<T> &dMatrix)
+      : matrix_(std::make_shared<DMatrix<T>>(dMatrix)) {}
+
+  explicit HeapMatrix(DMatrix<T> &&dMatrix)
+      : matrix_(std::make_shared<DMatrix<T>>(std::move(dMatrix))) {}
+
   HeapMatrix(const HeapMatrix &other) : matrix_(other.matrix_) {}
 
   HeapMatrix(HeapMatrix &&other) noexcept : matrix_(std::move(other.matrix_)) {}
@@ -35,30 +82,154 @@ public:
     return matrix_->operator()(row, column);
   }
 
-  T &operator()(std::size_t row, std::size_t column) {
-    return matrix_->operator()(row, column);
+  // reads don't detach, writes through the Element do
+  Element operator()(std::size_t row, std::size_t column) {
+    return Element(*this, row, column);
+  }
+
+  [[nodiscard]] bool operator==(const HeapMatrix &other) const {
+    return matrix_ == other.matrix_ || *matrix_ == *other.matrix_;
+  }
+
+  [[nodiscard]] bool operator!=(const HeapMatrix &other) const {
+    return !operator==(other);
   }
 
+  // a copy that never shares its buffer, not even before the first write
   static HeapMatrix clone(const HeapMatrix &source) {
-    HeapMatrix result;
-    result.matrix_ = std::make_shared<DMatrix<T>>(source.matrix_->width(),
-                                                  source.matrix_->height());
-    std::copy(source.matrix_->begin(), source.matrix_->end(),
-              result.matrix_->begin());
-    return result;
+    return HeapMatrix(*source.matrix_);
+  }
+
+  HeapMatrix &operator+=(const HeapMatrix &other) {
+    update_([&](const DMatrix<T> &m) { return m + *other.matrix_; });
+    return *this;
+  }
+
+  HeapMatrix &operator-=(const HeapMatrix &other) {
+    update_([&](const DMatrix<T> &m) { return m - *other.matrix_; });
+    return *this;
+  }
+
+  HeapMatrix &operator*=(T scalar) {
+    update_([&](const DMatrix<T> &m) { return m * scalar; });
+    return *this;
+  }
+
+  HeapMatrix &operator/=(T scalar) {
+    update_([&](const DMatrix<T> &m) { return m / scalar; });
+    return *this;
+  }
+
+  // products can't be computed in place, so this always allocates
+  HeapMatrix &operator*=(const HeapMatrix &other) {
+    return *this = *this * other;
+  }
+
+  // lhs is taken by value: an rvalue is moved in and, unless shared, updated
+  // in place. an rvalue on the right is reused through the overloads below
+  friend HeapMatrix operator+(HeapMatrix lhs, const HeapMatrix &rhs) {
+    lhs += rhs;
+    return lhs;
+  }
+
+  friend HeapMatrix operator+(const HeapMatrix &lhs, HeapMatrix &&rhs) {
+    rhs.update_([&](const DMatrix<T> &m) { return *lhs.matrix_ + m; });
+    return std::move(rhs);
+  }
+
+  friend HeapMatrix operator-(HeapMatrix lhs, const HeapMatrix &rhs) {
+    lhs -= rhs;
+    return lhs;
+  }
+
+  friend HeapMatrix operator-(const HeapMatrix &lhs, HeapMatrix &&rhs) {
+    rhs.update_([&](const DMatrix<T> &m) { return *lhs.matrix_ - m; });
+    return std::move(rhs);
+  }
+
+  friend HeapMatrix operator-(HeapMatrix m) {
+    m.update_([](const DMatrix<T> &e) { return -e; });
+    return m;
+  }
+
+  friend HeapMatrix operator*(HeapMatrix m, T scalar) {
+    m *= scalar;
+    return m;
+  }
+
+  friend HeapMatrix operator*(T scalar, HeapMatrix m) {
+    m *= scalar;
+    return m;
+  }
+
+  friend HeapMatrix operator/(HeapMatrix m, T scalar) {
+    m /= scalar;
+    return m;
   }
 
-  HeapMatrix operator+(const HeapMatrix &other) const {
-    return HeapMatrix(matrix_->operator+(*other.matrix_.get()));
+  friend HeapMatrix operator*(const HeapMatrix &lhs, const HeapMatrix &rhs) {
+    return HeapMatrix(*lhs.matrix_ * *rhs.matrix_);
   }
 
-  // TODO: finish implementing relevant methods
+  // multithreaded product, see DMatrix::multiply
+  HeapMatrix multiply(const HeapMatrix &other,
+                      concurrency::ThreadPool &pool =
+                          concurrency::defaultThreadPool()) const {
+    return HeapMatrix(matrix_->multiply(*other.matrix_.get(), pool));
+  }
+
+  [[nodiscard]] HeapMatrix transposed() const {
+    return HeapMatrix(matrix_->transposed());
+  }
+
+  // in place when the buffer isn't shared and the matrix is square
+  void transpose() {
+    if (matrix_->width() == matrix_->height() && unique_())
+      matrix_->transpose();
+    else
+      matrix_ = std::make_shared<DMatrix<T>>(matrix_->transposed());
+  }
+
+  [[nodiscard]] std::size_t width() const { return matrix_->width(); }
+
+  [[nodiscard]] std::size_t height() const { return matrix_->height(); }
+
+  // read-only access to the shared elements, never detaches
+  [[nodiscard]] const DMatrix<T> &matrix() const { return *matrix_; }
+
+  // whether writes would currently need a copy first
+  [[nodiscard]] bool shared() const { return !unique_(); }
 
 private:
   HeapMatrix() = default;
 
-  explicit HeapMatrix(const DMatrix<T> &dMatrix)
-      : matrix_(std::make_shared<DMatrix<T>>(dMatrix)) {}
+  // use_count is a relaxed load. the acquire fence after seeing 1 pairs with
+  // the release of the decrement done by whichever thread dropped the last
+  // other handle, so everything that thread did with the buffer happens
+  // before our writes to it. a count of 1 can't go up behind our back, the
+  // only way to get another handle is copying this one
+  [[nodiscard]] bool unique_() const {
+    if (matrix_.use_count() != 1)
+      return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+  }
+
+  void detach_() {
+    if (!unique_())
+      matrix_ = std::make_shared<DMatrix<T>>(*matrix_);
+  }
+
+  // assigns an elementwise expression of the current elements, evaluated in
+  // a single pass: in place when the buffer is ours alone, into a new buffer
+  // (leaving the shared one untouched) otherwise
+  template <typename F> void update_(F expression) {
+    const DMatrix<T> &current = *matrix_;
+    if (unique_())
+      *matrix_ = expression(current);
+    else
+      matrix_ = std::make_shared<DMatrix<T>>(expression(current));
+  }
 
   std::shared_ptr<DMatrix<T>> matrix_ = nullptr;
 };
@@ -0,0 +1,91 @@
+#ifndef MODERN_CPP_INC_MATH_BLAS_HPP
+#define MODERN_CPP_INC_MATH_BLAS_HPP
+
+#include "math/kernels/gemm.hpp"
+#include "math/kernels/gemv.hpp"
+#include "math/kernels/simd.hpp"
+#include "math/matrix.hpp"
+#include "math/matrix_view.hpp"
+#include <concepts>
+#include <type_traits>
+
+// blas-flavoured updates that write into storage the caller already owns.
+// axpy never allocates. gemm packs its operands and gemv gathers strided
+// vectors into a kernels::Workspace, which only allocates when a call needs
+// more scratch than any call before it. pass one in to own that memory, or
+// leave it out to use the calling thread's, which lives as long as the thread.
+// either way a solver repeating products of the same sizes stops allocating
+// after its first iteration. operands are taken as views, so whole matrices,
+// blocks, rows and columns all work. outputs must not overlap the inputs
+// unless stated otherwise
+
+namespace mcpp::math {
+
+template <typename T>
+using ConstViewArg = std::type_identity_t<MatrixView<const T>>;
+template <typename T> using ViewArg = std::type_identity_t<MatrixView<T>>;
+
+// level 1: y += alpha * x. x and y may be the same matrix
+template <MatrixElement T>
+void axpy(T alpha, ConstViewArg<T> x, ViewArg<T> y) {
+  assert(x.width() == y.width() && x.height() == y.height());
+  const auto &kernels = kernels::simdKernels<T>();
+  if (x.contiguous() && y.contiguous())
+    kernels.axpy(x.width() * x.height(), alpha, x.data(), y.data());
+  else
+    for (std::size_t i = 0; i < x.height(); ++i)
+      kernels.axpy(x.width(), alpha, x.row(i).data(), y.row(i).data());
+}
+
+// level 2: y = alpha * a * x + beta * y, with x and y column vectors. a is
+// streamed row by row through the gemv kernel. when beta is zero y is never
+// read
+template <MatrixElement T>
+void gemv(T alpha, ConstViewArg<T> a, ConstViewArg<T> x, T beta,
+          ViewArg<T> y,
+          kernels::Workspace &workspace = kernels::threadWorkspace()) {
+  assert(x.width() == 1 && y.width() == 1 && a.width() == x.height() &&
+         a.height() == y.height());
+  if constexpr (std::floating_point<T>)
+    kernels::gemv(a.height(), a.width(), alpha, a.data(), a.stride(),
+                  x.data(), x.stride(), beta, y.data(), y.stride(), workspace);
+  else
+    kernels::gemm(a.height(), 1, a.width(), alpha, a.data(), a.stride(), 1,
+                  x.data(), x.stride(), 1, beta, y.data(), y.stride(),
+                  workspace);
+}
+
+// level 2: y = alpha * a^T * x + beta * y, with x and y column vectors. a is
+// still read row by row, never down its columns
+template <MatrixElement T>
+void gemvTransposed(T alpha, ConstViewArg<T> a, ConstViewArg<T> x, T beta,
+                    ViewArg<T> y,
+                    kernels::Workspace &workspace =
+                        kernels::threadWorkspace()) {
+  assert(x.width() == 1 && y.width() == 1 && a.height() == x.height() &&
+         a.width() == y.height());
+  if constexpr (std::floating_point<T>)
+    kernels::gemvTransposed(a.height(), a.width(), alpha, a.data(),
+                            a.stride(), x.data(), x.stride(), beta, y.data(),
+                            y.stride(), workspace);
+  else
+    kernels::gemm(a.width(), 1, a.height(), alpha, a.data(), 1, a.stride(),
+                  x.data(), x.stride(), 1, beta, y.data(), y.stride(),
+                  workspace);
+}
+
+// level 3: c = alpha * a * b + beta * c. when beta is zero c is never read
+template <MatrixElement T>
+void gemm(T alpha, ConstViewArg<T> a, ConstViewArg<T> b, T beta,
+          ViewArg<T> c,
+          kernels::Workspace &workspace = kernels::threadWorkspace()) {
+  assert(a.width() == b.height() && c.height() == a.height() &&
+         c.width() == b.width());
+  kernels::gemm(a.height(), b.width(), a.width(), alpha, a.data(), a.stride(),
+                1, b.data(), b.stride(), 1, beta, c.data(), c.stride(),
+                workspace);
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_BLAS_HPP
@@ -0,0 +1,369 @@
+#ifndef MODERN_CPP_INC_MATH_DECOMPOSITION_HPP
+#define MODERN_CPP_INC_MATH_DECOMPOSITION_HPP
+
+#include "math/blas.hpp"
+#include "math/kernels/simd.hpp"
+#include "math/matrix.hpp"
+#include "math/matrix_view.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// lu and cholesky factorizations of dynamic matrices, plus what's built on top
+// of them: solving linear systems, inverses and determinants. both are
+// right-looking and blocked: a narrow panel of columns is factored with
+// level-1 operations, then the rest of the matrix gets a single gemm update,
+// which is where nearly all the flops go. fixed-size 3x3 and 4x4 matrices
+// have unrolled closed-form versions at the bottom
+
+namespace mcpp::math {
+
+class SingularMatrixError : public std::runtime_error {
+public:
+  SingularMatrixError() : std::runtime_error("matrix is singular") {}
+};
+
+class NotPositiveDefiniteError : public std::runtime_error {
+public:
+  NotPositiveDefiniteError()
+      : std::runtime_error("matrix is not positive definite") {}
+};
+
+// columns factored per panel. the trailing gemm only gets efficient once its
+// inner dimension is a decent fraction of the kernel's own blocking
+constexpr std::size_t factorizationBlock = 64;
+
+// overwrites a square a with l and u such that p * a = l * u, l unit lower
+// triangular (its diagonal isn't stored) and u upper triangular. pivots[i] is
+// the row that was swapped with row i at step i. returns false if a is
+// singular, in which case the factorization is still completed but u has a
+// zero on its diagonal
+template <std::floating_point T>
+bool luFactorInPlace(ViewArg<T> a, std::size_t *pivots) {
+  assert(a.width() == a.height());
+  const auto n = a.width();
+  const auto &kernels = kernels::simdKernels<T>();
+  auto nonsingular = true;
+
+  for (std::size_t k = 0; k < n; k += factorizationBlock) {
+    const auto panel = std::min(factorizationBlock, n - k);
+
+    // unblocked lu of the n - k x panel column block. whole rows are swapped,
+    // which applies every pivot to the already factored columns on the left
+    // and to the not yet updated ones on the right in one go
+    for (std::size_t j = k; j < k + panel; ++j) {
+      auto pivot = j;
+      for (std::size_t i = j + 1; i < n; ++i)
+        if (std::abs(a(i, j)) > std::abs(a(pivot, j)))
+          pivot = i;
+      pivots[j] = pivot;
+      if (a(pivot, j) == T()) {
+        nonsingular = false;
+        continue;
+      }
+      if (pivot != j)
+        std::swap_ranges(a.row(j).data(), a.row(j).data() + n,
+                         a.row(pivot).data());
+      const auto inverse = T(1) / a(j, j);
+      const auto rest = k + panel - j - 1;
+      for (std::size_t i = j + 1; i < n; ++i) {
+        a(i, j) *= inverse;
+        kernels.axpy(rest, -a(i, j), a.row(j).data() + j + 1,
+                     a.row(i).data() + j + 1);
+      }
+    }
+
+    const auto trailing = n - k - panel;
+    if (trailing == 0)
+      break;
+
+    // u12 = l11^-1 * a12, l11 being unit lower triangular
+    const auto u12 = a.block(k, k + panel, trailing, panel);
+    for (std::size_t i = 1; i < panel; ++i)
+      for (std::size_t j = 0; j < i; ++j)
+        kernels.axpy(trailing, -a(k + i, k + j), u12.row(j).data(),
+                     u12.row(i).data());
+
+    // a22 -= l21 * u12
+    gemm(T(-1), a.block(k + panel, k, panel, trailing), u12, T(1),
+         a.block(k + panel, k + panel, trailing, trailing));
+  }
+  return nonsingular;
+}
+
+// overwrites the lower triangle of a symmetric positive definite a with l such
+// that a = l * l^t, and zeroes the upper one. only the lower triangle of a is
+// read. throws NotPositiveDefiniteError if a isn't positive definite
+template <std::floating_point T> void choleskyInPlace(ViewArg<T> a) {
+  assert(a.width() == a.height());
+  const auto n = a.width();
+  const auto &kernels = kernels::simdKernels<T>();
+
+  for (std::size_t k = 0; k < n; k += factorizationBlock) {
+    const auto panel = std::min(factorizationBlock, n - k);
+
+    // l11 = cholesky(a11), row by row so every dot is over contiguous rows
+    for (std::size_t i = k; i < k + panel; ++i) {
+      for (std::size_t j = k; j < i; ++j)
+        a(i, j) = (a(i, j) - kernels.dot(j - k, &a(i, k), &a(j, k))) / a(j, j);
+      const auto d = a(i, i) - kernels.dot(i - k, &a(i, k), &a(i, k));
+      if (!(d > T()))
+        throw NotPositiveDefiniteError();
+      a(i, i) = std::sqrt(d);
+    }
+
+    const auto trailing = n - k - panel;
+    if (trailing == 0)
+      break;
+
+    // l21 = a21 * l11^-t, one row of a21 at a time
+    for (std::size_t i = k + panel; i < n; ++i)
+      for (std::size_t j = k; j < k + panel; ++j)
+        a(i, j) = (a(i, j) - kernels.dot(j - k, &a(i, k), &a(j, k))) / a(j, j);
+
+    // a22 -= l21 * l21^t. l21^t is l21 read with its strides swapped, so it
+    // goes to the kernel as is. the whole block is updated even though only
+    // its lower half is used, which keeps it a single gemm
+    const auto l21 = a.block(k + panel, k, panel, trailing);
+    kernels::gemm(trailing, trailing, panel, T(-1), l21.data(), l21.stride(),
+                  1, l21.data(), 1, l21.stride(), T(1),
+                  &a(k + panel, k + panel), a.stride());
+  }
+
+  for (std::size_t i = 0; i < n; ++i)
+    std::fill(a.row(i).data() + i + 1, a.row(i).data() + n, T());
+}
+
+// p * a = l * u of a square dynamic matrix, see luFactorInPlace
+template <std::floating_point T> class LuDecomposition {
+public:
+  explicit LuDecomposition(DMatrix<T> a)
+      : lu_(std::move(a)), pivots_(lu_.height()) {
+    nonsingular_ = luFactorInPlace<T>(lu_.view(), pivots_.data());
+  }
+
+  // x such that a * x = b, b having any number of columns
+  [[nodiscard]] DMatrix<T> solve(DMatrix<T> b) const {
+    assert(b.height() == lu_.height());
+    if (!nonsingular_)
+      throw SingularMatrixError();
+    const auto n = lu_.height(), columns = b.width();
+    const auto &kernels = kernels::simdKernels<T>();
+    const auto x = b.view();
+    for (std::size_t i = 0; i < n; ++i)
+      if (pivots_[i] != i)
+        std::swap_ranges(x.row(i).data(), x.row(i).data() + columns,
+                         x.row(pivots_[i]).data());
+    // forward substitution with the unit lower l, then backward with u
+    for (std::size_t i = 1; i < n; ++i)
+      for (std::size_t j = 0; j < i; ++j)
+        kernels.axpy(columns, -lu_(i, j), x.row(j).data(), x.row(i).data());
+    for (std::size_t i = n; i-- > 0;) {
+      for (std::size_t j = i + 1; j < n; ++j)
+        kernels.axpy(columns, -lu_(i, j), x.row(j).data(), x.row(i).data());
+      kernels.scale(columns, x.row(i).data(), T(1) / lu_(i, i),
+                    x.row(i).data());
+    }
+    return b;
+  }
+
+  [[nodiscard]] DMatrix<T> inverse() const {
+    return solve(identity_(lu_.height()));
+  }
+
+  [[nodiscard]] T determinant() const {
+    T result = T(1);
+    for (std::size_t i = 0; i < lu_.height(); ++i)
+      result *= pivots_[i] == i ? lu_(i, i) : -lu_(i, i);
+    return result;
+  }
+
+  [[nodiscard]] bool singular() const { return !nonsingular_; }
+
+  // l below the diagonal (unit diagonal implied), u on and above it
+  [[nodiscard]] const DMatrix<T> &factors() const { return lu_; }
+
+  [[nodiscard]] const std::vector<std::size_t> &pivots() const {
+    return pivots_;
+  }
+
+private:
+  static DMatrix<T> identity_(std::size_t n) {
+    DMatrix<T> result(n, n);
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t j = 0; j < n; ++j)
+        result(i, j) = i == j ? T(1) : T();
+    return result;
+  }
+
+  DMatrix<T> lu_;
+  std::vector<std::size_t> pivots_;
+  bool nonsingular_;
+
+  template <std::floating_point> friend class CholeskyDecomposition;
+};
+
+// a = l * l^t of a symmetric positive definite dynamic matrix, roughly half
+// the work of lu and no pivoting. throws NotPositiveDefiniteError on
+// construction if a isn't positive definite
+template <std::floating_point T> class CholeskyDecomposition {
+public:
+  explicit CholeskyDecomposition(DMatrix<T> a) : l_(std::move(a)) {
+    choleskyInPlace<T>(l_.view());
+  }
+
+  [[nodiscard]] DMatrix<T> solve(DMatrix<T> b) const {
+    assert(b.height() == l_.height());
+    const auto n = l_.height(), columns = b.width();
+    const auto &kernels = kernels::simdKernels<T>();
+    const auto x = b.view();
+    // l * y = b, then l^t * x = y
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t j = 0; j < i; ++j)
+        kernels.axpy(columns, -l_(i, j), x.row(j).data(), x.row(i).data());
+      kernels.scale(columns, x.row(i).data(), T(1) / l_(i, i),
+                    x.row(i).data());
+    }
+    for (std::size_t i = n; i-- > 0;) {
+      for (std::size_t j = i + 1; j < n; ++j)
+        kernels.axpy(columns, -l_(j, i), x.row(j).data(), x.row(i).data());
+      kernels.scale(columns, x.row(i).data(), T(1) / l_(i, i),
+                    x.row(i).data());
+    }
+    return b;
+  }
+
+  [[nodiscard]] DMatrix<T> inverse() const {
+    return solve(LuDecomposition<T>::identity_(l_.height()));
+  }
+
+  [[nodiscard]] T determinant() const {
+    T result = T(1);
+    for (std::size_t i = 0; i < l_.height(); ++i)
+      result *= l_(i, i);
+    return result * result;
+  }
+
+  // lower triangular, zeros above the diagonal
+  [[nodiscard]] const DMatrix<T> &factor() const { return l_; }
+
+private:
+  DMatrix<T> l_;
+};
+
+// one-off versions of the above, all through lu
+
+template <std::floating_point T>
+[[nodiscard]] DMatrix<T> solve(const DMatrix<T> &a, const DMatrix<T> &b) {
+  return LuDecomposition<T>(a).solve(b);
+}
+
+template <std::floating_point T>
+[[nodiscard]] DMatrix<T> inverse(const DMatrix<T> &a) {
+  return LuDecomposition<T>(a).inverse();
+}
+
+template <std::floating_point T>
+[[nodiscard]] T determinant(const DMatrix<T> &a) {
+  return LuDecomposition<T>(a).determinant();
+}
+
+// fixed-size 3x3 and 4x4: cofactor expansions, unrolled and branch-free apart
+// from the singularity check
+
+template <std::floating_point T>
+[[nodiscard]] T determinant(const Matrix<T, 3, 3> &m) {
+  return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1)) -
+         m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0)) +
+         m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+}
+
+template <std::floating_point T>
+[[nodiscard]] Matrix<T, 3, 3> inverse(const Matrix<T, 3, 3> &m) {
+  const auto c00 = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1),
+             c01 = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2),
+             c02 = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+  const auto det = m(0, 0) * c00 + m(0, 1) * c01 + m(0, 2) * c02;
+  if (det == T())
+    throw SingularMatrixError();
+  const auto s = T(1) / det;
+  return {{c00 * s, (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * s,
+           (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * s},
+          {c01 * s, (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * s,
+           (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * s},
+          {c02 * s, (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * s,
+           (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * s}};
+}
+
+// the 4x4 ones share the 2x2 minors of the top two rows (s) and of the bottom
+// two (c), twelve products instead of the naive expansion's many more
+template <std::floating_point T>
+[[nodiscard]] T determinant(const Matrix<T, 4, 4> &m) {
+  const auto s0 = m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1),
+             s1 = m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2),
+             s2 = m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3),
+             s3 = m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2),
+             s4 = m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3),
+             s5 = m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3);
+  const auto c5 = m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3),
+             c4 = m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3),
+             c3 = m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2),
+             c2 = m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3),
+             c1 = m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2),
+             c0 = m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1);
+  return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+template <std::floating_point T>
+[[nodiscard]] Matrix<T, 4, 4> inverse(const Matrix<T, 4, 4> &m) {
+  const auto s0 = m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1),
+             s1 = m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2),
+             s2 = m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3),
+             s3 = m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2),
+             s4 = m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3),
+             s5 = m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3);
+  const auto c5 = m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3),
+             c4 = m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3),
+             c3 = m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2),
+             c2 = m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3),
+             c1 = m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2),
+             c0 = m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1);
+  const auto det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  if (det == T())
+    throw SingularMatrixError();
+  const auto s = T(1) / det;
+  Matrix<T, 4, 4> r(0);
+  r(0, 0) = (m(1, 1) * c5 - m(1, 2) * c4 + m(1, 3) * c3) * s;
+  r(0, 1) = (-m(0, 1) * c5 + m(0, 2) * c4 - m(0, 3) * c3) * s;
+  r(0, 2) = (m(3, 1) * s5 - m(3, 2) * s4 + m(3, 3) * s3) * s;
+  r(0, 3) = (-m(2, 1) * s5 + m(2, 2) * s4 - m(2, 3) * s3) * s;
+  r(1, 0) = (-m(1, 0) * c5 + m(1, 2) * c2 - m(1, 3) * c1) * s;
+  r(1, 1) = (m(0, 0) * c5 - m(0, 2) * c2 + m(0, 3) * c1) * s;
+  r(1, 2) = (-m(3, 0) * s5 + m(3, 2) * s2 - m(3, 3) * s1) * s;
+  r(1, 3) = (m(2, 0) * s5 - m(2, 2) * s2 + m(2, 3) * s1) * s;
+  r(2, 0) = (m(1, 0) * c4 - m(1, 1) * c2 + m(1, 3) * c0) * s;
+  r(2, 1) = (-m(0, 0) * c4 + m(0, 1) * c2 - m(0, 3) * c0) * s;
+  r(2, 2) = (m(3, 0) * s4 - m(3, 1) * s2 + m(3, 3) * s0) * s;
+  r(2, 3) = (-m(2, 0) * s4 + m(2, 1) * s2 - m(2, 3) * s0) * s;
+  r(3, 0) = (-m(1, 0) * c3 + m(1, 1) * c1 - m(1, 2) * c0) * s;
+  r(3, 1) = (m(0, 0) * c3 - m(0, 1) * c1 + m(0, 2) * c0) * s;
+  r(3, 2) = (-m(3, 0) * s3 + m(3, 1) * s1 - m(3, 2) * s0) * s;
+  r(3, 3) = (m(2, 0) * s3 - m(2, 1) * s1 + m(2, 2) * s0) * s;
+  return r;
+}
+
+// a * x = b for fixed-size a, through the closed-form inverse
+template <std::floating_point T, std::size_t n, std::size_t w>
+  requires(n == 3 || n == 4)
+[[nodiscard]] Matrix<T, w, n> solve(const Matrix<T, n, n> &a,
+                                    const Matrix<T, w, n> &b) {
+  return inverse(a) * b;
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_DECOMPOSITION_HPP
@@ -0,0 +1,177 @@
+#ifndef MODERN_CPP_INC_MATH_HALF_HPP
+#define MODERN_CPP_INC_MATH_HALF_HPP
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+// 16 bit floating point element types, for matrices that are mostly moved
+// around rather than computed on: half the memory and bandwidth of float.
+// they're storage formats only, every operation converts to float, computes
+// there and rounds the result back to nearest even. products and reductions
+// over them accumulate in float (see AccumulatorOf) and only round once, at
+// the end. gcc 12 has no std::float16_t / std::bfloat16_t yet, hence the
+// library types; the bit layouts are the same
+
+namespace mcpp::math {
+
+namespace detail {
+
+constexpr float halfBitsToFloat(std::uint16_t bits) {
+  const auto sign = std::uint32_t(bits & 0x8000u) << 16;
+  const std::uint32_t exponent = (bits >> 10) & 0x1fu,
+                      mantissa = bits & 0x3ffu;
+  if (exponent == 0x1f) // inf and nan, the payload is kept
+    return std::bit_cast<float>(sign | 0x7f800000u | mantissa << 13);
+  if (exponent == 0) { // zero and subnormals, mantissa * 2^-24
+    const auto magnitude = float(mantissa) * 0x1p-24f;
+    return sign ? -magnitude : magnitude;
+  }
+  return std::bit_cast<float>(sign | (exponent + 112) << 23 | mantissa << 13);
+}
+
+// rounds to nearest even, like the f16c instructions do
+constexpr std::uint16_t floatToHalfBits(float value) {
+  const auto bits = std::bit_cast<std::uint32_t>(value);
+  const auto sign = std::uint16_t(bits >> 16 & 0x8000u);
+  const auto magnitude = bits & 0x7fffffffu;
+  const auto round = [](std::uint32_t kept, std::uint32_t dropped,
+                        std::uint32_t halfway) {
+    return kept + (dropped > halfway || (dropped == halfway && (kept & 1)));
+  };
+  if (magnitude > 0x7f800000u) // nan, quieted, top of the payload kept
+    return std::uint16_t(sign | 0x7e00u | (magnitude >> 13 & 0x3ffu));
+  if (magnitude >= 0x477ff000u) // rounds past 65504, including inf
+    return std::uint16_t(sign | 0x7c00u);
+  if (magnitude >= 0x38800000u) // normal, rebias the exponent from 127 to 15
+    return std::uint16_t(
+        sign | round((magnitude - 0x38000000u) >> 13, magnitude & 0x1fffu,
+                     0x1000u));
+  if (magnitude <= 0x33000000u) // 2^-25 and below round to zero
+    return sign;
+  // subnormal, the implicit bit becomes explicit and gets shifted down
+  const auto shift = 126 - (magnitude >> 23);
+  const auto mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+  return std::uint16_t(sign | round(mantissa >> shift,
+                                    mantissa & ((1u << shift) - 1),
+                                    1u << (shift - 1)));
+}
+
+constexpr float bfloat16BitsToFloat(std::uint16_t bits) {
+  return std::bit_cast<float>(std::uint32_t(bits) << 16);
+}
+
+// bfloat16 is the top half of a float, so this is a rounding shift
+constexpr std::uint16_t floatToBFloat16Bits(float value) {
+  const auto bits = std::bit_cast<std::uint32_t>(value);
+  if ((bits & 0x7fffffffu) > 0x7f800000u)
+    return std::uint16_t(bits >> 16 | 0x40u);
+  return std::uint16_t((bits + 0x7fffu + (bits >> 16 & 1)) >> 16);
+}
+
+} // namespace detail
+
+// the arithmetic is shared by both types: converting to float implicitly
+// makes `a + b` a float expression, compound assignment rounds it back
+template <typename Derived> class ReducedFloat {
+public:
+  constexpr Derived &operator+=(float other) {
+    return self_() = Derived(float(self_()) + other);
+  }
+
+  constexpr Derived &operator-=(float other) {
+    return self_() = Derived(float(self_()) - other);
+  }
+
+  constexpr Derived &operator*=(float other) {
+    return self_() = Derived(float(self_()) * other);
+  }
+
+  constexpr Derived &operator/=(float other) {
+    return self_() = Derived(float(self_()) / other);
+  }
+
+private:
+  constexpr Derived &self_() { return static_cast<Derived &>(*this); }
+};
+
+// ieee 754 binary16: 5 exponent bits, 10 mantissa bits, max 65504
+class Half : public ReducedFloat<Half> {
+public:
+  Half() = default;
+
+  constexpr Half(float value) : bits_(detail::floatToHalfBits(value)) {}
+
+  [[nodiscard]] static constexpr Half fromBits(std::uint16_t bits) {
+    Half result;
+    result.bits_ = bits;
+    return result;
+  }
+
+  constexpr operator float() const { return detail::halfBitsToFloat(bits_); }
+
+  [[nodiscard]] constexpr std::uint16_t bits() const { return bits_; }
+
+private:
+  std::uint16_t bits_;
+};
+
+// brain float: float's 8 exponent bits with 7 mantissa bits, so the same
+// range as float with about 3 significant digits
+class BFloat16 : public ReducedFloat<BFloat16> {
+public:
+  BFloat16() = default;
+
+  constexpr BFloat16(float value)
+      : bits_(detail::floatToBFloat16Bits(value)) {}
+
+  [[nodiscard]] static constexpr BFloat16 fromBits(std::uint16_t bits) {
+    BFloat16 result;
+    result.bits_ = bits;
+    return result;
+  }
+
+  constexpr operator float() const {
+    return detail::bfloat16BitsToFloat(bits_);
+  }
+
+  [[nodiscard]] constexpr std::uint16_t bits() const { return bits_; }
+
+private:
+  std::uint16_t bits_;
+};
+
+static_assert(sizeof(Half) == 2 && std::is_trivially_copyable_v<Half> &&
+              sizeof(BFloat16) == 2 &&
+              std::is_trivially_copyable_v<BFloat16>);
+
+template <typename T> struct IsReducedPrecision {
+  static constexpr const bool value = false;
+};
+
+template <> struct IsReducedPrecision<Half> {
+  static constexpr const bool value = true;
+};
+
+template <> struct IsReducedPrecision<BFloat16> {
+  static constexpr const bool value = true;
+};
+
+template <typename T>
+constexpr auto IsReducedPrecisionV = IsReducedPrecision<T>::value;
+
+template <typename T>
+concept ReducedPrecision = IsReducedPrecisionV<T>;
+
+// what matrices can hold
+template <typename T>
+concept MatrixElement = std::floating_point<T> || ReducedPrecision<T>;
+
+// the type sums and products of T are carried out in
+template <MatrixElement T>
+using AccumulatorOf = std::conditional_t<ReducedPrecision<T>, float, T>;
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_HALF_HPP
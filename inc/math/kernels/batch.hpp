@@ -0,0 +1,213 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_BATCH_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_BATCH_HPP
+
+#include "math/kernels/simd.hpp"
+#include <cmath>
+#include <cstddef>
+
+// kernels over batches of small vectors stored structure-of-arrays: every
+// component lives in its own array, so one simd register holds the same
+// component of several vectors and a 4x4 transform or a cross product is a
+// handful of lane-wise multiply-adds with no shuffling. dispatched the same
+// way as the kernels in math/kernels/simd.hpp
+
+namespace mcpp::math::kernels {
+
+// components are passed as `dim` pointers, one per component array. outputs
+// may alias inputs, every vector is fully loaded before it's written
+template <typename T, std::size_t dim> struct BatchKernels {
+  SimdLevel level;
+  // out = matrix * v, the matrix being 4x4 row-major. 3d vectors are extended
+  // with the given w (1 for points, 0 for directions) and the bottom row is
+  // dropped, so projective matrices need the 4d version
+  void (*transform)(std::size_t, const T *, const T *const *, T, T *const *);
+  // v /= |v|, zero vectors come out as nan
+  void (*normalize)(std::size_t, const T *const *, T *const *);
+  void (*dot)(std::size_t, const T *const *, const T *const *, T *);
+  // 4d vectors are crossed as 3d ones, w coming out as 0
+  void (*cross)(std::size_t, const T *const *, const T *const *, T *const *);
+};
+
+namespace batch {
+
+// the generic bodies walk the batch a register at a time, then finish the
+// tail one vector at a time
+template <typename T, std::size_t dim, std::size_t bytes>
+[[gnu::always_inline]] inline void transform(std::size_t n, const T *matrix,
+                                             const T *const *in, T w,
+                                             T *const *out) {
+  using V = simd::Vector<T, bytes>;
+  constexpr auto rows = dim == 4 ? 4 : 3;
+  typename V::Type m[16], v[4], r;
+  for (std::size_t k = 0; k < 16; ++k)
+    m[k] = typename V::Type{} + matrix[k];
+  v[3] = typename V::Type{} + w;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    for (std::size_t c = 0; c < dim; ++c)
+      V::load(v[c], in[c] + i);
+    for (std::size_t row = 0; row < rows; ++row) {
+      r = m[4 * row] * v[0] + m[4 * row + 1] * v[1] +
+          m[4 * row + 2] * v[2] + m[4 * row + 3] * v[3];
+      V::store(out[row] + i, r);
+    }
+  }
+  for (; i < n; ++i) {
+    T x[4] = {T(), T(), T(), w};
+    for (std::size_t c = 0; c < dim; ++c)
+      x[c] = in[c][i];
+    for (std::size_t row = 0; row < rows; ++row)
+      out[row][i] = matrix[4 * row] * x[0] + matrix[4 * row + 1] * x[1] +
+                    matrix[4 * row + 2] * x[2] + matrix[4 * row + 3] * x[3];
+  }
+}
+
+template <typename T, std::size_t dim, std::size_t bytes>
+[[gnu::always_inline]] inline void normalize(std::size_t n,
+                                             const T *const *in,
+                                             T *const *out) {
+  using V = simd::Vector<T, bytes>;
+  typename V::Type v[dim], squared, inverse{};
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    squared = typename V::Type{};
+    for (std::size_t c = 0; c < dim; ++c) {
+      V::load(v[c], in[c] + i);
+      squared += v[c] * v[c];
+    }
+    // no portable vector sqrt, the lanes get a scalar one each and the
+    // divisions stay vectorized
+    for (std::size_t lane = 0; lane < V::lanes; ++lane)
+      inverse[lane] = std::sqrt(squared[lane]);
+    inverse = T(1) / inverse;
+    for (std::size_t c = 0; c < dim; ++c) {
+      v[c] *= inverse;
+      V::store(out[c] + i, v[c]);
+    }
+  }
+  for (; i < n; ++i) {
+    T squaredLength = T();
+    for (std::size_t c = 0; c < dim; ++c)
+      squaredLength += in[c][i] * in[c][i];
+    const auto inverseLength = T(1) / std::sqrt(squaredLength);
+    for (std::size_t c = 0; c < dim; ++c)
+      out[c][i] = in[c][i] * inverseLength;
+  }
+}
+
+template <typename T, std::size_t dim, std::size_t bytes>
+[[gnu::always_inline]] inline void dot(std::size_t n, const T *const *a,
+                                       const T *const *b, T *out) {
+  using V = simd::Vector<T, bytes>;
+  typename V::Type x, y, acc;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    acc = typename V::Type{};
+    for (std::size_t c = 0; c < dim; ++c) {
+      V::load(x, a[c] + i);
+      V::load(y, b[c] + i);
+      acc += x * y;
+    }
+    V::store(out + i, acc);
+  }
+  for (; i < n; ++i) {
+    T result = T();
+    for (std::size_t c = 0; c < dim; ++c)
+      result += a[c][i] * b[c][i];
+    out[i] = result;
+  }
+}
+
+template <typename T, std::size_t dim, std::size_t bytes>
+[[gnu::always_inline]] inline void cross(std::size_t n, const T *const *a,
+                                         const T *const *b, T *const *out) {
+  using V = simd::Vector<T, bytes>;
+  typename V::Type x[3], y[3], r[3];
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    for (std::size_t c = 0; c < 3; ++c) {
+      V::load(x[c], a[c] + i);
+      V::load(y[c], b[c] + i);
+    }
+    r[0] = x[1] * y[2] - x[2] * y[1];
+    r[1] = x[2] * y[0] - x[0] * y[2];
+    r[2] = x[0] * y[1] - x[1] * y[0];
+    for (std::size_t c = 0; c < 3; ++c)
+      V::store(out[c] + i, r[c]);
+  }
+  for (; i < n; ++i) {
+    const T x0 = a[0][i], x1 = a[1][i], x2 = a[2][i];
+    const T y0 = b[0][i], y1 = b[1][i], y2 = b[2][i];
+    out[0][i] = x1 * y2 - x2 * y1;
+    out[1][i] = x2 * y0 - x0 * y2;
+    out[2][i] = x0 * y1 - x1 * y0;
+  }
+  if constexpr (dim == 4)
+    for (std::size_t j = 0; j < n; ++j)
+      out[3][j] = T();
+}
+
+#define MCPP_BATCH_ENTRY_POINTS(prefix, attributes, bytes)                     \
+  template <typename T, std::size_t dim>                                       \
+  attributes void prefix##Transform(std::size_t n, const T *matrix,            \
+                                    const T *const *in, T w, T *const *out) {  \
+    transform<T, dim, bytes>(n, matrix, in, w, out);                           \
+  }                                                                            \
+  template <typename T, std::size_t dim>                                       \
+  attributes void prefix##Normalize(std::size_t n, const T *const *in,         \
+                                    T *const *out) {                           \
+    normalize<T, dim, bytes>(n, in, out);                                      \
+  }                                                                            \
+  template <typename T, std::size_t dim>                                       \
+  attributes void prefix##Dot(std::size_t n, const T *const *a,                \
+                              const T *const *b, T *out) {                     \
+    dot<T, dim, bytes>(n, a, b, out);                                          \
+  }                                                                            \
+  template <typename T, std::size_t dim>                                       \
+  attributes void prefix##Cross(std::size_t n, const T *const *a,              \
+                                const T *const *b, T *const *out) {            \
+    cross<T, dim, bytes>(n, a, b, out);                                        \
+  }                                                                            \
+  template <typename T, std::size_t dim>                                       \
+  BatchKernels<T, dim> prefix##Kernels(SimdLevel level) {                      \
+    return {level, prefix##Transform<T, dim>, prefix##Normalize<T, dim>,       \
+            prefix##Dot<T, dim>, prefix##Cross<T, dim>};                       \
+  }
+
+MCPP_BATCH_ENTRY_POINTS(scalar, , sizeof(T))
+#if MCPP_SIMD_X86
+MCPP_BATCH_ENTRY_POINTS(sse2, [[gnu::target("sse2")]], 16)
+MCPP_BATCH_ENTRY_POINTS(avx2, [[gnu::target("avx2,fma")]], 32)
+MCPP_BATCH_ENTRY_POINTS(avx512, [[gnu::target("avx512f")]], 64)
+#endif
+
+#undef MCPP_BATCH_ENTRY_POINTS
+
+} // namespace batch
+
+// kernels for a specific level, which must not exceed detectSimdLevel()
+template <typename T, std::size_t dim>
+BatchKernels<T, dim> batchKernelsFor(SimdLevel level) {
+  switch (level) {
+#if MCPP_SIMD_X86
+  case SimdLevel::avx512:
+    return batch::avx512Kernels<T, dim>(level);
+  case SimdLevel::avx2:
+    return batch::avx2Kernels<T, dim>(level);
+  case SimdLevel::sse2:
+    return batch::sse2Kernels<T, dim>(level);
+#endif
+  default:
+    return batch::scalarKernels<T, dim>(SimdLevel::scalar);
+  }
+}
+
+template <typename T, std::size_t dim>
+const BatchKernels<T, dim> &batchKernels() {
+  static const auto kernels = batchKernelsFor<T, dim>(detectSimdLevel());
+  return kernels;
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_BATCH_HPP
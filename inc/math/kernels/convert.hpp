@@ -0,0 +1,308 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_CONVERT_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_CONVERT_HPP
+
+#include "math/half.hpp"
+#include "math/kernels/simd.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if MCPP_SIMD_X86
+#include <immintrin.h>
+#endif
+
+// bulk conversions between the 16 bit element types and float, and the simd
+// kernels for those types built on top of them. half uses the f16c (or
+// avx-512) conversion instructions, bfloat16 only needs integer shifts, which
+// are written over vector extensions like the kernels in simd.hpp
+
+namespace mcpp::math::kernels {
+
+template <typename T> struct ConversionKernels {
+  SimdLevel level;
+  void (*toFloat)(std::size_t, const T *, float *);
+  void (*fromFloat)(std::size_t, const float *, T *);
+};
+
+namespace convert {
+
+template <typename T>
+void scalarToFloat(std::size_t n, const T *in, float *out) {
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = in[i];
+}
+
+template <typename T>
+void scalarFromFloat(std::size_t n, const float *in, T *out) {
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = in[i];
+}
+
+// the bits of `bytes` wide float vectors, and of the 16 bit ones they narrow to
+template <std::size_t bytes> struct BitVectors {
+  using Wide [[gnu::vector_size(bytes)]] = std::uint32_t;
+  using Narrow [[gnu::vector_size(bytes / 2)]] = std::uint16_t;
+};
+
+template <std::size_t bytes>
+[[gnu::always_inline]] inline void bfloat16ToFloat(std::size_t n,
+                                                   const BFloat16 *in,
+                                                   float *out) {
+  using Wide = typename BitVectors<bytes>::Wide;
+  using Narrow = typename BitVectors<bytes>::Narrow;
+  constexpr auto lanes = bytes / 4;
+  Narrow narrow;
+  Wide wide;
+  std::size_t i = 0;
+  for (; i + lanes <= n; i += lanes) {
+    std::memcpy(&narrow, static_cast<const void *>(in + i), bytes / 2);
+    wide = __builtin_convertvector(narrow, Wide) << 16;
+    std::memcpy(out + i, &wide, bytes);
+  }
+  for (; i < n; ++i)
+    out[i] = in[i];
+}
+
+template <std::size_t bytes>
+[[gnu::always_inline]] inline void bfloat16FromFloat(std::size_t n,
+                                                     const float *in,
+                                                     BFloat16 *out) {
+  using Wide = typename BitVectors<bytes>::Wide;
+  using Narrow = typename BitVectors<bytes>::Narrow;
+  constexpr auto lanes = bytes / 4;
+  Wide wide, rounded, quiet, nan;
+  Narrow narrow;
+  std::size_t i = 0;
+  for (; i + lanes <= n; i += lanes) {
+    std::memcpy(&wide, in + i, bytes);
+    // same rounding as detail::floatToBFloat16Bits, blended by mask
+    rounded = (wide + 0x7fffu + (wide >> 16 & 1)) >> 16;
+    quiet = wide >> 16 | 0x40u;
+    nan = (Wide)((wide & 0x7fffffffu) > 0x7f800000u);
+    narrow = __builtin_convertvector((rounded & ~nan) | (quiet & nan), Narrow);
+    std::memcpy(static_cast<void *>(out + i), &narrow, bytes / 2);
+  }
+  for (; i < n; ++i)
+    out[i] = in[i];
+}
+
+#define MCPP_BFLOAT16_ENTRY_POINTS(prefix, attributes, bytes)                  \
+  attributes inline void prefix##ToFloat(std::size_t n, const BFloat16 *in,    \
+                                         float *out) {                         \
+    bfloat16ToFloat<bytes>(n, in, out);                                        \
+  }                                                                            \
+  attributes inline void prefix##FromFloat(std::size_t n, const float *in,     \
+                                           BFloat16 *out) {                    \
+    bfloat16FromFloat<bytes>(n, in, out);                                      \
+  }
+
+#if MCPP_SIMD_X86
+MCPP_BFLOAT16_ENTRY_POINTS(sse2BFloat16, [[gnu::target("sse2")]], 16)
+MCPP_BFLOAT16_ENTRY_POINTS(avx2BFloat16, [[gnu::target("avx2")]], 32)
+MCPP_BFLOAT16_ENTRY_POINTS(avx512BFloat16, [[gnu::target("avx512f")]], 64)
+
+#undef MCPP_BFLOAT16_ENTRY_POINTS
+
+// rounding to nearest even, exceptions masked. the tails go through the
+// software conversion, which rounds the same way
+[[gnu::target("avx,f16c")]] inline void f16cHalfToFloat(std::size_t n,
+                                                         const Half *in,
+                                                         float *out) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(
+                                  reinterpret_cast<const __m128i *>(in + i))));
+  scalarToFloat(n - i, in + i, out + i);
+}
+
+[[gnu::target("avx,f16c")]] inline void
+f16cHalfFromFloat(std::size_t n, const float *in, Half *out) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm256_cvtps_ph(_mm256_loadu_ps(in + i),
+                                     _MM_FROUND_TO_NEAREST_INT |
+                                         _MM_FROUND_NO_EXC));
+  scalarFromFloat(n - i, in + i, out + i);
+}
+
+// the zero-masked conversions with every lane selected: the plain ones start
+// from an undefined vector, which gcc 12 takes for an uninitialized one
+constexpr __mmask16 allLanes = 0xffff;
+
+[[gnu::target("avx512f")]] inline void
+avx512HalfToFloat(std::size_t n, const Half *in, float *out) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const auto halves =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    _mm512_storeu_ps(out + i, _mm512_maskz_cvtph_ps(allLanes, halves));
+  }
+  scalarToFloat(n - i, in + i, out + i);
+}
+
+[[gnu::target("avx512f")]] inline void
+avx512HalfFromFloat(std::size_t n, const float *in, Half *out) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm512_maskz_cvtps_ph(allLanes,
+                                              _mm512_loadu_ps(in + i),
+                                              _MM_FROUND_TO_NEAREST_INT |
+                                                  _MM_FROUND_NO_EXC));
+  scalarFromFloat(n - i, in + i, out + i);
+}
+#endif
+
+} // namespace convert
+
+// conversions for a specific level, which must not exceed detectSimdLevel().
+// half has nothing below f16c, which comes with every avx2 cpu but is still
+// checked for
+template <ReducedPrecision T>
+ConversionKernels<T> conversionKernelsFor(SimdLevel level) {
+  using namespace convert;
+#if MCPP_SIMD_X86
+  if constexpr (std::is_same_v<T, Half>) {
+    if (level == SimdLevel::avx512)
+      return {level, avx512HalfToFloat, avx512HalfFromFloat};
+    if (level == SimdLevel::avx2 && __builtin_cpu_supports("f16c"))
+      return {level, f16cHalfToFloat, f16cHalfFromFloat};
+  } else {
+    switch (level) {
+    case SimdLevel::avx512:
+      return {level, avx512BFloat16ToFloat, avx512BFloat16FromFloat};
+    case SimdLevel::avx2:
+      return {level, avx2BFloat16ToFloat, avx2BFloat16FromFloat};
+    case SimdLevel::sse2:
+      return {level, sse2BFloat16ToFloat, sse2BFloat16FromFloat};
+    default:
+      break;
+    }
+  }
+#endif
+  return {SimdLevel::scalar, scalarToFloat<T>, scalarFromFloat<T>};
+}
+
+template <ReducedPrecision T> const ConversionKernels<T> &conversionKernels() {
+  static const auto kernels = conversionKernelsFor<T>(detectSimdLevel());
+  return kernels;
+}
+
+// the simd kernels of the 16 bit types convert chunks of their operands into
+// float buffers on the stack, run the float kernels on them and round the
+// results back. dot and sum accumulate in float across the whole array and
+// return the float, rounding is left to the caller
+namespace widened {
+
+constexpr std::size_t chunk = 256;
+
+template <typename T, typename Op>
+void binary(std::size_t n, const T *a, const T *b, T *out, Op op) {
+  const auto &convert = conversionKernels<T>();
+  float x[chunk], y[chunk];
+  for (std::size_t i = 0; i < n; i += chunk) {
+    const auto length = std::min(chunk, n - i);
+    convert.toFloat(length, a + i, x);
+    convert.toFloat(length, b + i, y);
+    op(length, x, y);
+    convert.fromFloat(length, x, out + i);
+  }
+}
+
+template <typename T>
+void add(std::size_t n, const T *a, const T *b, T *out) {
+  binary(n, a, b, out, [](std::size_t length, float *x, const float *y) {
+    simdKernels<float>().add(length, x, y, x);
+  });
+}
+
+template <typename T>
+void subtract(std::size_t n, const T *a, const T *b, T *out) {
+  binary(n, a, b, out, [](std::size_t length, float *x, const float *y) {
+    simdKernels<float>().subtract(length, x, y, x);
+  });
+}
+
+template <typename T>
+void scale(std::size_t n, const T *a, T scalar, T *out) {
+  const auto &convert = conversionKernels<T>();
+  float x[chunk];
+  for (std::size_t i = 0; i < n; i += chunk) {
+    const auto length = std::min(chunk, n - i);
+    convert.toFloat(length, a + i, x);
+    simdKernels<float>().scale(length, x, scalar, x);
+    convert.fromFloat(length, x, out + i);
+  }
+}
+
+template <typename T> void axpy(std::size_t n, T alpha, const T *x, T *y) {
+  binary(n, y, x, y, [alpha](std::size_t length, float *u, const float *v) {
+    simdKernels<float>().axpy(length, alpha, v, u);
+  });
+}
+
+template <typename T> float dot(std::size_t n, const T *a, const T *b) {
+  const auto &convert = conversionKernels<T>();
+  float x[chunk], y[chunk], result = 0;
+  for (std::size_t i = 0; i < n; i += chunk) {
+    const auto length = std::min(chunk, n - i);
+    convert.toFloat(length, a + i, x);
+    convert.toFloat(length, b + i, y);
+    result += simdKernels<float>().dot(length, x, y);
+  }
+  return result;
+}
+
+template <typename T> float sum(std::size_t n, const T *a) {
+  const auto &convert = conversionKernels<T>();
+  float x[chunk], result = 0;
+  for (std::size_t i = 0; i < n; i += chunk) {
+    const auto length = std::min(chunk, n - i);
+    convert.toFloat(length, a + i, x);
+    result += simdKernels<float>().sum(length, x);
+  }
+  return result;
+}
+
+// compared as floats, so 0 == -0 and nan != nan like for the other types
+template <typename T> bool equal(std::size_t n, const T *a, const T *b) {
+  const auto &convert = conversionKernels<T>();
+  float x[chunk], y[chunk];
+  for (std::size_t i = 0; i < n; i += chunk) {
+    const auto length = std::min(chunk, n - i);
+    convert.toFloat(length, a + i, x);
+    convert.toFloat(length, b + i, y);
+    if (!simdKernels<float>().equal(length, x, y))
+      return false;
+  }
+  return true;
+}
+
+template <typename T> SimdKernels<T> kernels() {
+  return {conversionKernels<T>().level,
+          add<T>,
+          subtract<T>,
+          scale<T>,
+          axpy<T>,
+          dot<T>,
+          sum<T>,
+          equal<T>};
+}
+
+} // namespace widened
+
+template <> inline const SimdKernels<Half> &simdKernels<Half>() {
+  static const auto kernels = widened::kernels<Half>();
+  return kernels;
+}
+
+template <> inline const SimdKernels<BFloat16> &simdKernels<BFloat16>() {
+  static const auto kernels = widened::kernels<BFloat16>();
+  return kernels;
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_CONVERT_HPP
@@ -0,0 +1,324 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_GEMM_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_GEMM_HPP
+
+#include "math/half.hpp"
+#include "math/kernels/convert.hpp"
+#include "memory/aligned.hpp"
+#include "memory/memory_resource.hpp"
+#include <algorithm>
+#include <cstddef>
+
+namespace mcpp::math::kernels {
+
+// blocking parameters for the goto-style gemm below. mr x nr is the register
+// tile computed by the micro-kernel, kc x nr panels of b are meant to stay in
+// l1, mc x kc blocks of a in l2 and kc x nc panels of b in l3
+template <typename T> struct GemmBlocking {
+  static constexpr std::size_t mr = 4, nr = 64 / sizeof(T) / 2;
+  static constexpr std::size_t kc = 256, mc = 128 * 4 / sizeof(T) / mr * mr,
+                               nc = 4096;
+  // below this many multiply-adds packing costs more than it saves
+  static constexpr std::size_t smallProduct = 32 * 32 * 32;
+};
+
+// cache line aligned scratch memory for the packed panels
+template <typename T> class PackBuffer {
+public:
+  explicit PackBuffer(std::size_t size)
+      : data_(memory::allocateAligned<T>(size)) {}
+
+  PackBuffer(const PackBuffer &) = delete;
+  PackBuffer &operator=(const PackBuffer &) = delete;
+
+  ~PackBuffer() { memory::deallocateAligned(data_); }
+
+  [[nodiscard]] T *get() const { return data_; }
+
+private:
+  T *data_;
+};
+
+// grow-only scratch memory for the kernels that need some: gemm packs its
+// panels into it and strided gemv gathers its vectors there. it only goes to
+// its resource when a call needs more than every call before it, so a caller
+// that keeps one around runs repeated products without allocating
+class Workspace {
+public:
+  explicit Workspace(
+      memory::MemoryResource *resource = memory::heapResource())
+      : resource_(resource) {}
+
+  Workspace(const Workspace &) = delete;
+  Workspace &operator=(const Workspace &) = delete;
+
+  ~Workspace() { release_(); }
+
+  // cache line aligned room for count objects of T. what was there before is
+  // lost if the block has to grow
+  template <typename T> [[nodiscard]] T *reserve(std::size_t count) {
+    const auto bytes = count * sizeof(T);
+    if (bytes > capacity_) {
+      release_();
+      data_ = resource_->allocate(bytes, memory::cacheLineSize);
+      capacity_ = bytes;
+    }
+    return static_cast<T *>(data_);
+  }
+
+  [[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+private:
+  void release_() noexcept {
+    if (data_)
+      resource_->deallocate(data_, capacity_, memory::cacheLineSize);
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+
+  memory::MemoryResource *resource_;
+  void *data_ = nullptr;
+  std::size_t capacity_ = 0;
+};
+
+// the workspace the kernels use when the caller doesn't pass one, one per
+// thread and kept until the thread exits
+[[nodiscard]] inline Workspace &threadWorkspace() {
+  static thread_local Workspace workspace;
+  return workspace;
+}
+
+// element counts rounded up to whole cache lines, so blocks carved out of one
+// workspace one after the other all stay aligned
+template <typename T>
+[[nodiscard]] constexpr std::size_t alignedCount(std::size_t count) {
+  constexpr auto line = memory::cacheLineSize / sizeof(T);
+  return (count + line - 1) / line * line;
+}
+
+// copies an mc x kc block of a into row panels mr tall, each stored k-major so
+// the micro-kernel reads it sequentially. alpha is folded in here and rows past
+// mc are zero-filled so the micro-kernel never needs edge cases
+template <typename T>
+void packA(std::size_t mc, std::size_t kc, T alpha, const T *a,
+           std::size_t rowStride, std::size_t colStride, T *packed) {
+  constexpr auto mr = GemmBlocking<T>::mr;
+  for (std::size_t i = 0; i < mc; i += mr) {
+    const auto rows = std::min(mr, mc - i);
+    for (std::size_t p = 0; p < kc; ++p) {
+      std::size_t r = 0;
+      for (; r < rows; ++r)
+        *packed++ = alpha * a[(i + r) * rowStride + p * colStride];
+      for (; r < mr; ++r)
+        *packed++ = T();
+    }
+  }
+}
+
+// copies a kc x nc panel of b into column panels nr wide, stored k-major
+template <typename T>
+void packB(std::size_t kc, std::size_t nc, const T *b, std::size_t rowStride,
+           std::size_t colStride, T *packed) {
+  constexpr auto nr = GemmBlocking<T>::nr;
+  for (std::size_t j = 0; j < nc; j += nr) {
+    const auto columns = std::min(nr, nc - j);
+    for (std::size_t p = 0; p < kc; ++p) {
+      const auto row = b + p * rowStride + j * colStride;
+      std::size_t c = 0;
+      if (colStride == 1)
+        for (; c < columns; ++c)
+          *packed++ = row[c];
+      else
+        for (; c < columns; ++c)
+          *packed++ = row[c * colStride];
+      for (; c < nr; ++c)
+        *packed++ = T();
+    }
+  }
+}
+
+// c[0:rows, 0:columns] = beta * c + a_panel * b_panel. the accumulators are a
+// fixed mr x nr array with constant trip counts, which the compiler keeps in
+// vector registers
+template <typename T>
+void microKernel(std::size_t kc, const T *__restrict a, const T *__restrict b,
+                 T beta, T *c, std::size_t ldc, std::size_t rows,
+                 std::size_t columns) {
+  constexpr auto mr = GemmBlocking<T>::mr, nr = GemmBlocking<T>::nr;
+  T acc[mr][nr]{};
+  for (std::size_t p = 0; p < kc; ++p, a += mr, b += nr)
+    for (std::size_t i = 0; i < mr; ++i)
+      for (std::size_t j = 0; j < nr; ++j)
+        acc[i][j] += a[i] * b[j];
+
+  for (std::size_t i = 0; i < rows; ++i, c += ldc) {
+    if (beta == T())
+      for (std::size_t j = 0; j < columns; ++j)
+        c[j] = acc[i][j];
+    else
+      for (std::size_t j = 0; j < columns; ++j)
+        c[j] = beta * c[j] + acc[i][j];
+  }
+}
+
+// plain i-k-j loop for products too small to be worth packing
+template <typename T>
+void gemmSmall(std::size_t m, std::size_t n, std::size_t k, T alpha,
+               const T *a, std::size_t rsA, std::size_t csA, const T *b,
+               std::size_t rsB, std::size_t csB, T beta, T *c,
+               std::size_t ldc) {
+  for (std::size_t i = 0; i < m; ++i) {
+    auto row = c + i * ldc;
+    if (beta == T())
+      std::fill_n(row, n, T());
+    else if (beta != T(1))
+      for (std::size_t j = 0; j < n; ++j)
+        row[j] *= beta;
+    for (std::size_t p = 0; p < k; ++p) {
+      const auto scaled = alpha * a[i * rsA + p * csA];
+      for (std::size_t j = 0; j < n; ++j)
+        row[j] += scaled * b[p * rsB + j * csB];
+    }
+  }
+}
+
+// c = alpha * a * b + beta * c, with a being m x k, b k x n and c m x n. a and
+// b are addressed through arbitrary row/column strides (so transposed operands
+// cost nothing extra, packing absorbs the layout), c is row-major with leading
+// dimension ldc. when beta is zero c is never read. the packed panels live in
+// workspace
+template <typename T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *a,
+          std::size_t rsA, std::size_t csA, const T *b, std::size_t rsB,
+          std::size_t csB, T beta, T *c, std::size_t ldc,
+          Workspace &workspace = threadWorkspace()) {
+  using Blocking = GemmBlocking<T>;
+  constexpr auto mr = Blocking::mr, nr = Blocking::nr;
+
+  if (m == 0 || n == 0)
+    return;
+  if (k == 0 || alpha == T() || m * n * k <= Blocking::smallProduct) {
+    gemmSmall(m, n, alpha == T() ? 0 : k, alpha, a, rsA, csA, b, rsB, csB,
+              beta, c, ldc);
+    return;
+  }
+
+  const auto roundUp = [](std::size_t x, std::size_t to) {
+    return (x + to - 1) / to * to;
+  };
+  const auto kcMax = std::min(Blocking::kc, k),
+             mcMax = std::min(Blocking::mc, roundUp(m, mr)),
+             ncMax = std::min(Blocking::nc, roundUp(n, nr));
+  const auto sizeA = alignedCount<T>(mcMax * kcMax);
+  const auto packedA = workspace.reserve<T>(sizeA + kcMax * ncMax),
+             packedB = packedA + sizeA;
+
+  for (std::size_t jc = 0; jc < n; jc += Blocking::nc) {
+    const auto nc = std::min(Blocking::nc, n - jc);
+    for (std::size_t pc = 0; pc < k; pc += Blocking::kc) {
+      const auto kc = std::min(Blocking::kc, k - pc);
+      // only the first slice along k applies the caller's beta, the rest
+      // accumulate onto it
+      const auto blockBeta = pc == 0 ? beta : T(1);
+      packB(kc, nc, b + pc * rsB + jc * csB, rsB, csB, packedB);
+      for (std::size_t ic = 0; ic < m; ic += Blocking::mc) {
+        const auto mc = std::min(Blocking::mc, m - ic);
+        packA(mc, kc, alpha, a + ic * rsA + pc * csA, rsA, csA,
+              packedA);
+        for (std::size_t jr = 0; jr < nc; jr += nr)
+          for (std::size_t ir = 0; ir < mc; ir += mr)
+            microKernel(kc, packedA + ir * kc, packedB + jr * kc,
+                        blockBeta, c + (ic + ir) * ldc + jc + jr, ldc,
+                        std::min(mr, mc - ir), std::min(nr, nc - jr));
+      }
+    }
+  }
+}
+
+// the 16 bit types run the float micro-kernel: blocks of a and b are widened
+// into float rows right before being packed, and each mc x nc block of c is
+// accumulated in a float tile over the whole of k, so it only gets rounded
+// once. the tile is what bounds nc here
+template <ReducedPrecision T>
+void gemm(std::size_t m, std::size_t n, std::size_t k, T alpha, const T *a,
+          std::size_t rsA, std::size_t csA, const T *b, std::size_t rsB,
+          std::size_t csB, T beta, T *c, std::size_t ldc,
+          Workspace &workspace = threadWorkspace()) {
+  using Blocking = GemmBlocking<float>;
+  constexpr auto mr = Blocking::mr, nr = Blocking::nr;
+  constexpr std::size_t ncTile = 1024;
+  const float wideAlpha = alpha, wideBeta = beta;
+
+  if (m == 0 || n == 0)
+    return;
+  if (k == 0 || wideAlpha == 0 || m * n * k <= Blocking::smallProduct) {
+    const auto depth = wideAlpha == 0 ? 0 : k;
+    for (std::size_t i = 0; i < m; ++i)
+      for (std::size_t j = 0; j < n; ++j) {
+        float sum = 0;
+        for (std::size_t p = 0; p < depth; ++p)
+          sum += float(a[i * rsA + p * csA]) * float(b[p * rsB + j * csB]);
+        auto &out = c[i * ldc + j];
+        out = wideBeta == 0 ? wideAlpha * sum
+                            : wideAlpha * sum + wideBeta * float(out);
+      }
+    return;
+  }
+
+  const auto &convert = conversionKernels<T>();
+  // rows x columns of any layout into a row-major float block
+  const auto widen = [&](std::size_t rows, std::size_t columns, const T *from,
+                         std::size_t rowStride, std::size_t colStride,
+                         float *to) {
+    for (std::size_t i = 0; i < rows; ++i, to += columns) {
+      const auto row = from + i * rowStride;
+      if (colStride == 1)
+        convert.toFloat(columns, row, to);
+      else
+        for (std::size_t j = 0; j < columns; ++j)
+          to[j] = row[j * colStride];
+    }
+  };
+
+  const auto roundUp = [](std::size_t x, std::size_t to) {
+    return (x + to - 1) / to * to;
+  };
+  const auto kcMax = std::min(Blocking::kc, k),
+             mcMax = std::min(Blocking::mc, roundUp(m, mr)),
+             ncMax = std::min(ncTile, roundUp(n, nr));
+  const auto sizeA = alignedCount<float>(mcMax * kcMax),
+             sizeB = alignedCount<float>(kcMax * ncMax);
+  const auto wideA = workspace.reserve<float>(2 * sizeA + 2 * sizeB +
+                                              mcMax * ncMax),
+             wideB = wideA + sizeA, packedA = wideB + sizeB,
+             packedB = packedA + sizeA, tile = packedB + sizeB;
+
+  for (std::size_t jc = 0; jc < n; jc += ncTile) {
+    const auto nc = std::min(ncTile, n - jc);
+    for (std::size_t ic = 0; ic < m; ic += Blocking::mc) {
+      const auto mc = std::min(Blocking::mc, m - ic);
+      if (wideBeta != 0)
+        widen(mc, nc, c + ic * ldc + jc, ldc, 1, tile);
+      for (std::size_t pc = 0; pc < k; pc += Blocking::kc) {
+        const auto kc = std::min(Blocking::kc, k - pc);
+        const auto blockBeta = pc == 0 ? wideBeta : 1.f;
+        // b panels get widened again for every block of a, a cheap price
+        // next to the 2 * mc flops each of their elements feeds
+        widen(kc, nc, b + pc * rsB + jc * csB, rsB, csB, wideB);
+        packB(kc, nc, wideB, nc, 1, packedB);
+        widen(mc, kc, a + ic * rsA + pc * csA, rsA, csA, wideA);
+        packA(mc, kc, wideAlpha, wideA, kc, 1, packedA);
+        for (std::size_t jr = 0; jr < nc; jr += nr)
+          for (std::size_t ir = 0; ir < mc; ir += mr)
+            microKernel(kc, packedA + ir * kc, packedB + jr * kc,
+                        blockBeta, tile + ir * nc + jr, nc,
+                        std::min(mr, mc - ir), std::min(nr, nc - jr));
+      }
+      for (std::size_t i = 0; i < mc; ++i)
+        convert.fromFloat(nc, tile + i * nc, c + (ic + i) * ldc + jc);
+    }
+  }
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_GEMM_HPP
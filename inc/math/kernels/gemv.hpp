@@ -0,0 +1,306 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_GEMV_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_GEMV_HPP
+
+#include "concurrency/thread_pool.hpp"
+#include "math/kernels/gemm.hpp"
+#include "math/kernels/parallel_gemm.hpp"
+#include "math/kernels/simd.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+
+// matrix-vector products. they're memory bound, each element of the matrix is
+// used exactly once, so what matters is streaming a's rows in order and doing
+// enough independent work per element loaded to keep up with memory. both
+// kernels walk a row-major a row by row, several rows at a time:
+// - gemv computes a block of rows' dot products with x together, so each
+//   vector of x is loaded once per block and every row has its own
+//   accumulator chain
+// - gemvTransposed folds a block of rows into y at once, so each vector of y
+//   is loaded and stored once per block instead of once per row
+
+namespace mcpp::math::kernels {
+
+template <typename T> struct GemvKernels {
+  SimdLevel level;
+  // y = alpha * a * x + beta * y, a m x n with leading dimension lda, x and y
+  // contiguous. when beta is zero y is never read
+  void (*gemv)(std::size_t m, std::size_t n, T alpha, const T *a,
+               std::size_t lda, const T *x, T beta, T *y);
+  // y = alpha * a^T * x + beta * y, same a, x of length m and y of length n
+  void (*gemvTransposed)(std::size_t m, std::size_t n, T alpha, const T *a,
+                         std::size_t lda, const T *x, T beta, T *y);
+};
+
+namespace matvec {
+
+// rows handled together, each with its own accumulators
+constexpr std::size_t rowBlock = 4;
+
+template <typename T>
+[[gnu::always_inline]] inline void store(T *y, T alpha, T sum, T beta) {
+  *y = beta == T() ? alpha * sum : alpha * sum + beta * *y;
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline void rows(std::size_t m, std::size_t n,
+                                        T alpha, const T *a, std::size_t lda,
+                                        const T *x, T beta, T *y) {
+  using V = simd::Vector<T, bytes>;
+  std::size_t i = 0;
+  for (; i + rowBlock <= m; i += rowBlock) {
+    typename V::Type acc[rowBlock]{}, u, v;
+    std::size_t j = 0;
+    for (; j + V::lanes <= n; j += V::lanes) {
+      V::load(v, x + j);
+      for (std::size_t r = 0; r < rowBlock; ++r) {
+        V::load(u, a + (i + r) * lda + j);
+        acc[r] += u * v;
+      }
+    }
+    for (std::size_t r = 0; r < rowBlock; ++r) {
+      auto sum = V::horizontalSum(acc[r]);
+      for (auto k = j; k < n; ++k)
+        sum += a[(i + r) * lda + k] * x[k];
+      store(y + i + r, alpha, sum, beta);
+    }
+  }
+  // leftover rows on their own, with the four accumulators of the dot kernel
+  for (; i < m; ++i)
+    store(y + i, alpha, simd::dot<T, bytes>(n, a + i * lda, x), beta);
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline void
+transposedRows(std::size_t m, std::size_t n, T alpha, const T *a,
+               std::size_t lda, const T *x, T beta, T *y) {
+  using V = simd::Vector<T, bytes>;
+  if (beta == T())
+    std::fill_n(y, n, T());
+  else if (beta != T(1))
+    simd::scale<T, bytes>(n, y, beta, y);
+  std::size_t i = 0;
+  for (; i + rowBlock <= m; i += rowBlock) {
+    T scales[rowBlock];
+    for (std::size_t r = 0; r < rowBlock; ++r)
+      scales[r] = alpha * x[i + r];
+    typename V::Type u, v;
+    std::size_t j = 0;
+    for (; j + V::lanes <= n; j += V::lanes) {
+      V::load(v, y + j);
+      for (std::size_t r = 0; r < rowBlock; ++r) {
+        V::load(u, a + (i + r) * lda + j);
+        v += scales[r] * u;
+      }
+      V::store(y + j, v);
+    }
+    for (; j < n; ++j)
+      for (std::size_t r = 0; r < rowBlock; ++r)
+        y[j] += scales[r] * a[(i + r) * lda + j];
+  }
+  for (; i < m; ++i)
+    simd::axpy<T, bytes>(n, alpha * x[i], a + i * lda, y);
+}
+
+#define MCPP_GEMV_ENTRY_POINTS(prefix, attributes, bytes)                      \
+  template <typename T>                                                        \
+  attributes void prefix##Gemv(std::size_t m, std::size_t n, T alpha,          \
+                               const T *a, std::size_t lda, const T *x,        \
+                               T beta, T *y) {                                 \
+    rows<T, bytes>(m, n, alpha, a, lda, x, beta, y);                           \
+  }                                                                            \
+  template <typename T>                                                        \
+  attributes void prefix##GemvTransposed(std::size_t m, std::size_t n,         \
+                                         T alpha, const T *a, std::size_t lda, \
+                                         const T *x, T beta, T *y) {           \
+    transposedRows<T, bytes>(m, n, alpha, a, lda, x, beta, y);                 \
+  }                                                                            \
+  template <typename T> GemvKernels<T> prefix##Kernels(SimdLevel level) {      \
+    return {level, prefix##Gemv<T>, prefix##GemvTransposed<T>};                \
+  }
+
+MCPP_GEMV_ENTRY_POINTS(scalar, , sizeof(T))
+#if MCPP_SIMD_X86
+MCPP_GEMV_ENTRY_POINTS(sse2, [[gnu::target("sse2")]], 16)
+MCPP_GEMV_ENTRY_POINTS(avx2, [[gnu::target("avx2,fma")]], 32)
+MCPP_GEMV_ENTRY_POINTS(avx512, [[gnu::target("avx512f")]], 64)
+#endif
+
+#undef MCPP_GEMV_ENTRY_POINTS
+
+} // namespace matvec
+
+// kernels for a specific level, which must not exceed detectSimdLevel()
+template <std::floating_point T>
+GemvKernels<T> gemvKernelsFor(SimdLevel level) {
+  switch (level) {
+#if MCPP_SIMD_X86
+  case SimdLevel::avx512:
+    return matvec::avx512Kernels<T>(level);
+  case SimdLevel::avx2:
+    return matvec::avx2Kernels<T>(level);
+  case SimdLevel::sse2:
+    return matvec::sse2Kernels<T>(level);
+#endif
+  default:
+    return matvec::scalarKernels<T>(SimdLevel::scalar);
+  }
+}
+
+template <std::floating_point T> const GemvKernels<T> &gemvKernels() {
+  static const auto kernels = gemvKernelsFor<T>(detectSimdLevel());
+  return kernels;
+}
+
+namespace matvec {
+
+// runs a contiguous-vector kernel on strided vectors by gathering x, and y
+// too when it gets read, into the workspace and scattering y back
+template <typename T, typename Kernel>
+void strided(std::size_t xLength, std::size_t yLength, const T *x,
+             std::size_t incx, T beta, T *y, std::size_t incy,
+             Workspace &workspace, Kernel kernel) {
+  if (incx == 1 && incy == 1) {
+    kernel(x, y);
+    return;
+  }
+  const auto sizeX = incx == 1 ? 0 : alignedCount<T>(xLength);
+  const auto xs = workspace.reserve<T>(sizeX + (incy == 1 ? 0 : yLength)),
+             ys = xs + sizeX;
+  if (incx != 1)
+    for (std::size_t i = 0; i < xLength; ++i)
+      xs[i] = x[i * incx];
+  if (incy != 1 && beta != T())
+    for (std::size_t i = 0; i < yLength; ++i)
+      ys[i] = y[i * incy];
+  kernel(incx == 1 ? x : xs, incy == 1 ? y : ys);
+  if (incy != 1)
+    for (std::size_t i = 0; i < yLength; ++i)
+      y[i * incy] = ys[i];
+}
+
+// elements of a a single task gets in the parallel versions. like gemm's
+// tiles the split doesn't depend on the pool, so results don't either
+constexpr std::size_t parallelGrain = 1 << 15;
+
+} // namespace matvec
+
+// y = alpha * a * x + beta * y, a m x n row-major with leading dimension lda,
+// x and y strided by incx and incy (a column of a row-major matrix has its
+// stride as increment). when beta is zero y is never read. strided vectors
+// get gathered into workspace
+template <std::floating_point T>
+void gemv(std::size_t m, std::size_t n, T alpha, const T *a, std::size_t lda,
+          const T *x, std::size_t incx, T beta, T *y, std::size_t incy,
+          Workspace &workspace = threadWorkspace()) {
+  matvec::strided(n, m, x, incx, beta, y, incy, workspace,
+                  [&](const T *xs, T *ys) {
+                    gemvKernels<T>().gemv(m, n, alpha, a, lda, xs, beta, ys);
+                  });
+}
+
+// y = alpha * a^T * x + beta * y, with the same a as gemv, x of length m and y
+// of length n. a is still read row by row, never down its columns
+template <std::floating_point T>
+void gemvTransposed(std::size_t m, std::size_t n, T alpha, const T *a,
+                    std::size_t lda, const T *x, std::size_t incx, T beta,
+                    T *y, std::size_t incy,
+                    Workspace &workspace = threadWorkspace()) {
+  matvec::strided(m, n, x, incx, beta, y, incy, workspace,
+                  [&](const T *xs, T *ys) {
+                    gemvKernels<T>().gemvTransposed(m, n, alpha, a, lda, xs,
+                                                    beta, ys);
+                  });
+}
+
+// gemv with the rows of a (and y) split into tasks on the pool
+template <std::floating_point T>
+void parallelGemv(concurrency::ThreadPool &pool, std::size_t m,
+                  std::size_t n, T alpha, const T *a, std::size_t lda,
+                  const T *x, std::size_t incx, T beta, T *y,
+                  std::size_t incy) {
+  constexpr auto block = matvec::rowBlock;
+  const auto rows =
+      std::max(matvec::parallelGrain / std::max(n, std::size_t(1)), block) /
+      block * block;
+  if (rows >= m) {
+    gemv(m, n, alpha, a, lda, x, incx, beta, y, incy);
+    return;
+  }
+  const auto split = [&](const T *xs, T *ys) {
+    pool.parallelFor((m + rows - 1) / rows, [&](std::size_t task) {
+      const auto i = task * rows;
+      gemvKernels<T>().gemv(std::min(rows, m - i), n, alpha, a + i * lda, lda,
+                            xs, beta, ys + i);
+    });
+  };
+  matvec::strided(n, m, x, incx, beta, y, incy, threadWorkspace(), split);
+}
+
+// gemvTransposed with the columns of a (and y) split into tasks on the pool,
+// every task still streams over all the rows of its slice
+template <std::floating_point T>
+void parallelGemvTransposed(concurrency::ThreadPool &pool, std::size_t m,
+                            std::size_t n, T alpha, const T *a,
+                            std::size_t lda, const T *x, std::size_t incx,
+                            T beta, T *y, std::size_t incy) {
+  // whole cache lines of y per task
+  constexpr auto line = memory::cacheLineSize / sizeof(T);
+  const auto columns =
+      std::max(matvec::parallelGrain / std::max(m, std::size_t(1)), line) /
+      line * line;
+  if (columns >= n) {
+    gemvTransposed(m, n, alpha, a, lda, x, incx, beta, y, incy);
+    return;
+  }
+  const auto split = [&](const T *xs, T *ys) {
+    pool.parallelFor((n + columns - 1) / columns, [&](std::size_t task) {
+      const auto j = task * columns;
+      gemvKernels<T>().gemvTransposed(m, std::min(columns, n - j), alpha,
+                                      a + j, lda, xs, beta, ys + j);
+    });
+  };
+  matvec::strided(m, n, x, incx, beta, y, incy, threadWorkspace(), split);
+}
+
+// c = a * b for row-major a (m x k) and b (k x n), going through gemv when
+// either side is a vector and gemm otherwise. c is never read
+template <typename T>
+void product(std::size_t m, std::size_t n, std::size_t k, const T *a,
+             std::size_t lda, const T *b, std::size_t ldb, T *c,
+             std::size_t ldc) {
+  if constexpr (std::floating_point<T>) {
+    if (n == 1) {
+      gemv(m, k, T(1), a, lda, b, ldb, T(), c, ldc);
+      return;
+    }
+    if (m == 1) {
+      gemvTransposed(k, n, T(1), b, ldb, a, 1, T(), c, 1);
+      return;
+    }
+  }
+  gemm(m, n, k, T(1), a, lda, 1, b, ldb, 1, T(), c, ldc);
+}
+
+// product on the pool, see parallelGemm and the parallel gemv above
+template <typename T>
+void parallelProduct(concurrency::ThreadPool &pool, std::size_t m,
+                     std::size_t n, std::size_t k, const T *a,
+                     std::size_t lda, const T *b, std::size_t ldb, T *c,
+                     std::size_t ldc) {
+  if constexpr (std::floating_point<T>) {
+    if (n == 1) {
+      parallelGemv(pool, m, k, T(1), a, lda, b, ldb, T(), c, ldc);
+      return;
+    }
+    if (m == 1) {
+      parallelGemvTransposed(pool, k, n, T(1), b, ldb, a, 1, T(), c, 1);
+      return;
+    }
+  }
+  parallelGemm(pool, m, n, k, T(1), a, lda, 1, b, ldb, 1, T(), c, ldc);
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_GEMV_HPP
@@ -0,0 +1,39 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_PARALLEL_GEMM_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_PARALLEL_GEMM_HPP
+
+#include "concurrency/thread_pool.hpp"
+#include "math/kernels/gemm.hpp"
+
+namespace mcpp::math::kernels {
+
+// output tile handed to a single task. it doesn't depend on the pool size, so
+// every element is always computed by the same sequence of operations and the
+// result is bit-for-bit the same no matter how many threads run it
+template <typename T> struct GemmTiling {
+  static constexpr std::size_t rows = GemmBlocking<T>::mc,
+                               columns = 32 * GemmBlocking<T>::nr;
+};
+
+// same contract as gemm, with c split into independent tiles that are spread
+// over the pool. tasks only share read-only a and b and pack into their own
+// buffers
+template <typename T>
+void parallelGemm(concurrency::ThreadPool &pool, std::size_t m, std::size_t n,
+                  std::size_t k, T alpha, const T *a, std::size_t rsA,
+                  std::size_t csA, const T *b, std::size_t rsB,
+                  std::size_t csB, T beta, T *c, std::size_t ldc) {
+  using Tiling = GemmTiling<T>;
+  const auto rowTiles = (m + Tiling::rows - 1) / Tiling::rows,
+             columnTiles = (n + Tiling::columns - 1) / Tiling::columns;
+  pool.parallelFor(rowTiles * columnTiles, [&](std::size_t tile) {
+    const auto i = tile / columnTiles * Tiling::rows,
+               j = tile % columnTiles * Tiling::columns;
+    gemm(std::min(Tiling::rows, m - i), std::min(Tiling::columns, n - j), k,
+         alpha, a + i * rsA, rsA, csA, b + j * csB, rsB, csB, beta,
+         c + i * ldc + j, ldc);
+  });
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_PARALLEL_GEMM_HPP
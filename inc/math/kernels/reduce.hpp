@@ -0,0 +1,549 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_REDUCE_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_REDUCE_HPP
+
+#include "concurrency/thread_pool.hpp"
+#include "math/half.hpp"
+#include "math/kernels/convert.hpp"
+#include "math/kernels/simd.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// whole-matrix, row-wise and column-wise reductions over row-major storage.
+// the per-array kernels are written over vector extensions and dispatched per
+// instruction set like the ones in simd.hpp. on top of them the drivers below
+// cut the matrix into pieces of a fixed size, reduce the pieces (on a pool
+// when there are enough of them) and combine the partial results. the cut
+// doesn't depend on the pool, so neither does the result. nans aren't given
+// any special treatment, a reduction over them has an unspecified result
+
+namespace mcpp::math {
+
+// what gets computed: sums of the elements, of their magnitudes or of their
+// squares, or the smallest, largest or largest magnitude element
+enum class Reduction { sum, sumAbs, sumSquares, min, max, maxAbs };
+
+// how sums accumulate. plain is the fastest, with an error that grows
+// linearly with the number of elements. pairwise sums blocks of them plainly
+// and adds the block sums up in a balanced tree, so the error grows with the
+// log of the count for almost no cost. kahan carries a compensation term per
+// simd lane, which makes the error independent of the count at about twice
+// the cost of plain
+enum class Summation { plain, pairwise, kahan };
+
+struct MatrixIndex {
+  std::size_t row, column;
+};
+
+namespace kernels {
+
+constexpr bool isSum(Reduction kind) {
+  return kind == Reduction::sum || kind == Reduction::sumAbs ||
+         kind == Reduction::sumSquares;
+}
+
+template <typename T> struct ReductionKernels {
+  SimdLevel level;
+  // all indexed by Reduction. reduce is plain summation, kahan only has the
+  // sums, n must not be zero for the others
+  T (*reduce[6])(std::size_t n, const T *a);
+  T (*kahan[3])(std::size_t n, const T *a);
+  // out = f(row), and out = out op f(row), elementwise
+  void (*firstRow[6])(std::size_t n, const T *row, T *out);
+  void (*accumulateRow[6])(std::size_t n, const T *row, T *out);
+  // out + compensation = out + compensation + f(row), kahan style
+  void (*kahanRow[3])(std::size_t n, const T *row, T *out, T *compensation);
+};
+
+namespace reduce {
+
+// x = f(x) and acc = acc op x, for scalars and vectors alike. vectors are only
+// passed by reference, see simd.hpp
+template <Reduction kind, typename X>
+[[gnu::always_inline]] inline void map(X &x) {
+  if constexpr (kind == Reduction::sumAbs || kind == Reduction::maxAbs)
+    x = x < 0 ? -x : x;
+  else if constexpr (kind == Reduction::sumSquares)
+    x = x * x;
+}
+
+template <Reduction kind, typename X>
+[[gnu::always_inline]] inline void combine(X &acc, const X &x) {
+  if constexpr (isSum(kind))
+    acc += x;
+  else if constexpr (kind == Reduction::min)
+    acc = x < acc ? x : acc;
+  else
+    acc = acc < x ? x : acc;
+}
+
+template <typename T, std::size_t bytes, Reduction kind>
+[[gnu::always_inline]] inline T plain(std::size_t n, const T *a) {
+  using V = simd::Vector<T, bytes>;
+  T result = T();
+  std::size_t i = 0;
+  if (n >= 4 * V::lanes) {
+    // four independent accumulators, started off with the first elements so
+    // min and max need no identity
+    typename V::Type acc[4], x;
+    for (std::size_t j = 0; j < 4; ++j) {
+      V::load(acc[j], a + j * V::lanes);
+      map<kind>(acc[j]);
+    }
+    for (i = 4 * V::lanes; i + 4 * V::lanes <= n; i += 4 * V::lanes)
+      for (std::size_t j = 0; j < 4; ++j) {
+        V::load(x, a + i + j * V::lanes);
+        map<kind>(x);
+        combine<kind>(acc[j], x);
+      }
+    combine<kind>(acc[0], acc[1]);
+    combine<kind>(acc[2], acc[3]);
+    combine<kind>(acc[0], acc[2]);
+    result = acc[0][0];
+    for (std::size_t lane = 1; lane < V::lanes; ++lane) {
+      T value = acc[0][lane];
+      combine<kind>(result, value);
+    }
+  } else if (!isSum(kind)) {
+    assert(n > 0);
+    result = a[0];
+    map<kind>(result);
+    i = 1;
+  }
+  for (; i < n; ++i) {
+    auto value = a[i];
+    map<kind>(value);
+    combine<kind>(result, value);
+  }
+  return result;
+}
+
+template <typename T>
+[[gnu::always_inline]] inline void kahanAdd(T &sum, T &compensation,
+                                            T value) {
+  const auto y = value - compensation;
+  const auto t = sum + y;
+  compensation = (t - sum) - y;
+  sum = t;
+}
+
+template <typename T, std::size_t bytes, Reduction kind>
+[[gnu::always_inline]] inline T kahan(std::size_t n, const T *a) {
+  using V = simd::Vector<T, bytes>;
+  typename V::Type sums{}, compensations{}, x, y, t;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(x, a + i);
+    map<kind>(x);
+    y = x - compensations;
+    t = sums + y;
+    compensations = (t - sums) - y;
+    sums = t;
+  }
+  // the lanes hold sum - compensation each, folded in still compensated
+  T sum = T(), compensation = T();
+  for (std::size_t lane = 0; lane < V::lanes; ++lane) {
+    kahanAdd<T>(sum, compensation, sums[lane]);
+    kahanAdd<T>(sum, compensation, -compensations[lane]);
+  }
+  for (; i < n; ++i) {
+    auto value = a[i];
+    map<kind>(value);
+    kahanAdd(sum, compensation, value);
+  }
+  return sum - compensation;
+}
+
+template <typename T, std::size_t bytes, Reduction kind, bool first>
+[[gnu::always_inline]] inline void row(std::size_t n, const T *row, T *out) {
+  using V = simd::Vector<T, bytes>;
+  typename V::Type x, acc;
+  std::size_t j = 0;
+  for (; j + V::lanes <= n; j += V::lanes) {
+    V::load(x, row + j);
+    map<kind>(x);
+    if constexpr (!first) {
+      V::load(acc, out + j);
+      combine<kind>(acc, x);
+      V::store(out + j, acc);
+    } else {
+      V::store(out + j, x);
+    }
+  }
+  for (; j < n; ++j) {
+    auto value = row[j];
+    map<kind>(value);
+    if constexpr (first)
+      out[j] = value;
+    else
+      combine<kind>(out[j], value);
+  }
+}
+
+template <typename T, std::size_t bytes, Reduction kind>
+[[gnu::always_inline]] inline void kahanRow(std::size_t n, const T *row,
+                                            T *out, T *compensation) {
+  using V = simd::Vector<T, bytes>;
+  typename V::Type x, sums, compensations, y, t;
+  std::size_t j = 0;
+  for (; j + V::lanes <= n; j += V::lanes) {
+    V::load(x, row + j);
+    V::load(sums, out + j);
+    V::load(compensations, compensation + j);
+    map<kind>(x);
+    y = x - compensations;
+    t = sums + y;
+    compensations = (t - sums) - y;
+    V::store(out + j, t);
+    V::store(compensation + j, compensations);
+  }
+  for (; j < n; ++j) {
+    auto value = row[j];
+    map<kind>(value);
+    kahanAdd(out[j], compensation[j], value);
+  }
+}
+
+#define MCPP_REDUCE_ENTRY_POINTS(prefix, attributes, bytes)                    \
+  template <typename T, Reduction kind>                                        \
+  attributes T prefix##Reduce(std::size_t n, const T *a) {                     \
+    return plain<T, bytes, kind>(n, a);                                        \
+  }                                                                            \
+  template <typename T, Reduction kind>                                        \
+  attributes T prefix##Kahan(std::size_t n, const T *a) {                      \
+    return kahan<T, bytes, kind>(n, a);                                        \
+  }                                                                            \
+  template <typename T, Reduction kind, bool first>                            \
+  attributes void prefix##Row(std::size_t n, const T *in, T *out) {            \
+    row<T, bytes, kind, first>(n, in, out);                                    \
+  }                                                                            \
+  template <typename T, Reduction kind>                                        \
+  attributes void prefix##KahanRow(std::size_t n, const T *in, T *out,         \
+                                   T *compensation) {                          \
+    kahanRow<T, bytes, kind>(n, in, out, compensation);                        \
+  }                                                                            \
+  template <typename T>                                                        \
+  ReductionKernels<T> prefix##Kernels(SimdLevel level) {                       \
+    using enum Reduction;                                                      \
+    return {level,                                                             \
+            {prefix##Reduce<T, sum>, prefix##Reduce<T, sumAbs>,                \
+             prefix##Reduce<T, sumSquares>, prefix##Reduce<T, min>,            \
+             prefix##Reduce<T, max>, prefix##Reduce<T, maxAbs>},               \
+            {prefix##Kahan<T, sum>, prefix##Kahan<T, sumAbs>,                  \
+             prefix##Kahan<T, sumSquares>},                                    \
+            {prefix##Row<T, sum, true>, prefix##Row<T, sumAbs, true>,          \
+             prefix##Row<T, sumSquares, true>, prefix##Row<T, min, true>,      \
+             prefix##Row<T, max, true>, prefix##Row<T, maxAbs, true>},         \
+            {prefix##Row<T, sum, false>, prefix##Row<T, sumAbs, false>,        \
+             prefix##Row<T, sumSquares, false>, prefix##Row<T, min, false>,    \
+             prefix##Row<T, max, false>, prefix##Row<T, maxAbs, false>},       \
+            {prefix##KahanRow<T, sum>, prefix##KahanRow<T, sumAbs>,            \
+             prefix##KahanRow<T, sumSquares>}};                                \
+  }
+
+MCPP_REDUCE_ENTRY_POINTS(scalar, , sizeof(T))
+#if MCPP_SIMD_X86
+MCPP_REDUCE_ENTRY_POINTS(sse2, [[gnu::target("sse2")]], 16)
+MCPP_REDUCE_ENTRY_POINTS(avx2, [[gnu::target("avx2,fma")]], 32)
+MCPP_REDUCE_ENTRY_POINTS(avx512, [[gnu::target("avx512f")]], 64)
+#endif
+
+#undef MCPP_REDUCE_ENTRY_POINTS
+
+} // namespace reduce
+
+// kernels for a specific level, which must not exceed detectSimdLevel()
+template <std::floating_point T>
+ReductionKernels<T> reductionKernelsFor(SimdLevel level) {
+  switch (level) {
+#if MCPP_SIMD_X86
+  case SimdLevel::avx512:
+    return reduce::avx512Kernels<T>(level);
+  case SimdLevel::avx2:
+    return reduce::avx2Kernels<T>(level);
+  case SimdLevel::sse2:
+    return reduce::sse2Kernels<T>(level);
+#endif
+  default:
+    return reduce::scalarKernels<T>(SimdLevel::scalar);
+  }
+}
+
+template <std::floating_point T>
+const ReductionKernels<T> &reductionKernels() {
+  static const auto kernels = reductionKernelsFor<T>(detectSimdLevel());
+  return kernels;
+}
+
+namespace reduce {
+
+// elements reduced as one piece, the unit of work of the parallel drivers
+constexpr std::size_t pieceSize = 1 << 16;
+// below this many elements everything stays on the calling thread
+constexpr std::size_t parallelThreshold = 1 << 20;
+// blocks the pairwise sums are built from, and rows per block for columns
+constexpr std::size_t pairwiseBlock = 512, pairwiseRows = 64;
+
+template <typename T> T sumPairwise(std::size_t n, const T *a, auto leaf) {
+  if (n <= pairwiseBlock)
+    return leaf(n, a);
+  const auto half = (n / 2 + pairwiseBlock - 1) / pairwiseBlock * pairwiseBlock;
+  return sumPairwise(half, a, leaf) + sumPairwise(n - half, a + half, leaf);
+}
+
+// folds partial results into one, the same way the elements were
+template <typename A>
+A combinePartials(Reduction kind, Summation summation, std::size_t n,
+                  const A *partials) {
+  if (n == 0)
+    return A();
+  if (!isSum(kind)) {
+    auto result = partials[0];
+    for (std::size_t i = 1; i < n; ++i)
+      result = kind == Reduction::min ? std::min(result, partials[i])
+                                      : std::max(result, partials[i]);
+    return result;
+  }
+  if (summation == Summation::kahan) {
+    A sum = A(), compensation = A();
+    for (std::size_t i = 0; i < n; ++i)
+      kahanAdd(sum, compensation, partials[i]);
+    return sum - compensation;
+  }
+  const auto leaf = [](std::size_t count, const A *p) {
+    A sum = A();
+    for (std::size_t i = 0; i < count; ++i)
+      sum += p[i];
+    return sum;
+  };
+  return summation == Summation::pairwise ? sumPairwise(n, partials, leaf)
+                                          : leaf(n, partials);
+}
+
+// one contiguous array of floating point elements
+template <std::floating_point T>
+T reduceArray(Reduction kind, Summation summation, std::size_t n,
+              const T *a) {
+  const auto &kernels = reductionKernels<T>();
+  const auto index = std::size_t(kind);
+  if (!isSum(kind) || summation == Summation::plain)
+    return kernels.reduce[index](n, a);
+  if (summation == Summation::kahan)
+    return kernels.kahan[index](n, a);
+  return sumPairwise(n, a, kernels.reduce[index]);
+}
+
+// the 16 bit types are widened a block at a time and reduced in float
+template <ReducedPrecision T>
+float reduceArray(Reduction kind, Summation summation, std::size_t n,
+                  const T *a) {
+  const auto &convert = conversionKernels<T>();
+  constexpr auto block = pairwiseBlock;
+  float widened[block], partials[pieceSize / block + 1];
+  assert(n <= pieceSize);
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; i += block, ++count) {
+    const auto length = std::min(block, n - i);
+    convert.toFloat(length, a + i, widened);
+    partials[count] = reduceArray(kind, summation, length, widened);
+  }
+  return combinePartials(kind, summation, count, partials);
+}
+
+} // namespace reduce
+
+// reduces a height x width matrix with rows stride elements apart. sums and
+// minima/maxima of the 16 bit types are computed in float
+template <MatrixElement T>
+AccumulatorOf<T> reduceMatrix(Reduction kind, Summation summation,
+                              const T *data, std::size_t width,
+                              std::size_t height, std::size_t stride,
+                              concurrency::ThreadPool *pool = nullptr) {
+  using A = AccumulatorOf<T>;
+  using reduce::pieceSize;
+  assert(isSum(kind) || width * height > 0);
+  // unpadded matrices are one long row
+  const auto contiguous = stride == width || height <= 1;
+  const auto length = contiguous ? width * height : width,
+             rows = contiguous ? std::size_t(1) : height;
+  if (length == 0 || rows == 0)
+    return A();
+  // long rows are cut into pieces, short ones grouped into tasks of about a
+  // piece worth of elements
+  const auto piecesPerRow = (length + pieceSize - 1) / pieceSize;
+  const auto rowsPerTask = length >= pieceSize ? 1 : pieceSize / length;
+  const auto tasks = length >= pieceSize
+                         ? rows * piecesPerRow
+                         : (rows + rowsPerTask - 1) / rowsPerTask;
+  std::vector<A> partials(tasks);
+  const auto task = [&](std::size_t t) {
+    if (length >= pieceSize) {
+      const auto begin = t % piecesPerRow * pieceSize;
+      partials[t] = reduce::reduceArray(kind, summation,
+                                        std::min(pieceSize, length - begin),
+                                        data + t / piecesPerRow * stride +
+                                            begin);
+      return;
+    }
+    const auto first = t * rowsPerTask,
+               last = std::min(rows, first + rowsPerTask);
+    std::vector<A> rowPartials(last - first);
+    for (auto i = first; i < last; ++i)
+      rowPartials[i - first] =
+          reduce::reduceArray(kind, summation, length, data + i * stride);
+    partials[t] = reduce::combinePartials(kind, summation, rowPartials.size(),
+                                          rowPartials.data());
+  };
+  if (pool && tasks > 1 && width * height >= reduce::parallelThreshold)
+    pool->parallelFor(tasks, task);
+  else
+    for (std::size_t t = 0; t < tasks; ++t)
+      task(t);
+  return reduce::combinePartials(kind, summation, tasks, partials.data());
+}
+
+// out[i] = the reduction of row i
+template <MatrixElement T>
+void reduceRows(Reduction kind, Summation summation, const T *data,
+                std::size_t width, std::size_t height, std::size_t stride,
+                AccumulatorOf<T> *out,
+                concurrency::ThreadPool *pool = nullptr) {
+  const auto rowsPerTask =
+      std::max(reduce::pieceSize / std::max(width, std::size_t(1)),
+               std::size_t(1));
+  const auto tasks = (height + rowsPerTask - 1) / rowsPerTask;
+  const auto task = [&](std::size_t t) {
+    for (auto i = t * rowsPerTask; i < std::min(height, (t + 1) * rowsPerTask);
+         ++i)
+      out[i] = reduceMatrix(kind, summation, data + i * stride, width, 1,
+                            width);
+  };
+  if (pool && tasks > 1 && width * height >= reduce::parallelThreshold)
+    pool->parallelFor(tasks, task);
+  else
+    for (std::size_t t = 0; t < tasks; ++t)
+      task(t);
+}
+
+namespace reduce {
+
+// columns [0, width) of rows [first, last) into out, rows streamed in order.
+// row(i, buffer) hands out row i as accumulator type elements
+template <typename A, typename Row>
+void reduceColumnBlock(Reduction kind, Summation summation, std::size_t width,
+                       std::size_t first, std::size_t last, Row row, A *out) {
+  const auto &kernels = reductionKernels<A>();
+  const auto index = std::size_t(kind);
+  if (isSum(kind) && summation == Summation::pairwise &&
+      last - first > pairwiseRows) {
+    const auto half = ((last - first) / 2 + pairwiseRows - 1) /
+                      pairwiseRows * pairwiseRows;
+    std::vector<A> second(width);
+    reduceColumnBlock(kind, summation, width, first, first + half, row, out);
+    reduceColumnBlock(kind, summation, width, first + half, last, row,
+                      second.data());
+    simdKernels<A>().add(width, out, second.data(), out);
+    return;
+  }
+  std::vector<A> buffer(width);
+  kernels.firstRow[index](width, row(first, buffer.data()), out);
+  if (isSum(kind) && summation == Summation::kahan) {
+    std::vector<A> compensation(width);
+    for (auto i = first + 1; i < last; ++i)
+      kernels.kahanRow[index](width, row(i, buffer.data()), out,
+                              compensation.data());
+    // the sums are out - compensation
+    simdKernels<A>().subtract(width, out, compensation.data(), out);
+    return;
+  }
+  for (auto i = first + 1; i < last; ++i)
+    kernels.accumulateRow[index](width, row(i, buffer.data()), out);
+}
+
+} // namespace reduce
+
+// out[j] = the reduction of column j. the columns are split into blocks, each
+// streaming over its rows. tall matrices are cut into blocks of rows as well,
+// of a fixed size so the result doesn't depend on the pool, and the partial
+// results of the row blocks are combined per column
+template <MatrixElement T>
+void reduceColumns(Reduction kind, Summation summation, const T *data,
+                   std::size_t width, std::size_t height, std::size_t stride,
+                   AccumulatorOf<T> *out,
+                   concurrency::ThreadPool *pool = nullptr) {
+  using A = AccumulatorOf<T>;
+  using reduce::pairwiseRows;
+  assert(isSum(kind) || height > 0);
+  if (height == 0) {
+    std::fill_n(out, width, A());
+    return;
+  }
+  constexpr std::size_t columnsPerBlock = 1024;
+  const auto columnBlocks = (width + columnsPerBlock - 1) / columnsPerBlock;
+  // about parallelThreshold elements per block, in whole pairwise row blocks
+  const auto blockWidth = std::clamp(width, std::size_t(1), columnsPerBlock);
+  const auto rowsPerBlock =
+      (std::max(reduce::parallelThreshold / blockWidth, pairwiseRows) +
+       pairwiseRows - 1) /
+      pairwiseRows * pairwiseRows;
+  const auto rowBlocks = (height + rowsPerBlock - 1) / rowsPerBlock;
+  // the first row block reduces straight into out, the others into partials
+  std::vector<A> partials((rowBlocks - 1) * width);
+  const auto tasks = rowBlocks * columnBlocks;
+  const auto task = [&](std::size_t t) {
+    const auto rowBlock = t / columnBlocks,
+               begin = t % columnBlocks * columnsPerBlock,
+               columns = std::min(columnsPerBlock, width - begin),
+               first = rowBlock * rowsPerBlock,
+               last = std::min(height, first + rowsPerBlock);
+    const auto row = [&](std::size_t i, A *buffer) -> const A * {
+      const auto source = data + i * stride + begin;
+      if constexpr (ReducedPrecision<T>) {
+        conversionKernels<T>().toFloat(columns, source, buffer);
+        return buffer;
+      } else {
+        return source;
+      }
+    };
+    const auto target = rowBlock == 0
+                            ? out + begin
+                            : partials.data() + (rowBlock - 1) * width + begin;
+    reduce::reduceColumnBlock(kind, summation, columns, first, last, row,
+                              target);
+  };
+  if (pool && tasks > 1 && width * height >= reduce::parallelThreshold)
+    pool->parallelFor(tasks, task);
+  else
+    for (std::size_t t = 0; t < tasks; ++t)
+      task(t);
+
+  if (rowBlocks == 1)
+    return;
+  std::vector<A> column(rowBlocks);
+  for (std::size_t j = 0; j < width; ++j) {
+    column[0] = out[j];
+    for (std::size_t b = 1; b < rowBlocks; ++b)
+      column[b] = partials[(b - 1) * width + j];
+    out[j] = reduce::combinePartials(kind, summation, rowBlocks, column.data());
+  }
+}
+
+// position of the first element equal to value, in row-major order
+template <MatrixElement T>
+MatrixIndex findElement(const T *data, std::size_t width, std::size_t height,
+                        std::size_t stride, T value) {
+  for (std::size_t i = 0; i < height; ++i) {
+    const auto row = data + i * stride;
+    const auto found = std::find(row, row + width, value);
+    if (found != row + width)
+      return {i, std::size_t(found - row)};
+  }
+  return {height, width};
+}
+
+} // namespace kernels
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_REDUCE_HPP
@@ -0,0 +1,291 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_SIMD_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_SIMD_HPP
+
+#include "math/half.hpp"
+#include <cstddef>
+#include <cstring>
+
+// elementwise and reduction kernels over contiguous arrays, compiled once per
+// instruction set and picked at runtime from cpuid. the binary itself stays
+// baseline x86-64 (or whatever the compiler targets), only the functions
+// tagged with a target attribute use wider instructions, and they're only
+// ever called after checking the cpu has them
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MCPP_SIMD_X86 1
+#else
+#define MCPP_SIMD_X86 0
+#endif
+
+namespace mcpp::math::kernels {
+
+enum class SimdLevel { scalar, sse2, avx2, avx512 };
+
+template <typename T> struct SimdKernels {
+  SimdLevel level;
+  // out = a + b, out = a - b, out = a * scalar
+  void (*add)(std::size_t, const T *, const T *, T *);
+  void (*subtract)(std::size_t, const T *, const T *, T *);
+  void (*scale)(std::size_t, const T *, T, T *);
+  // y += alpha * x
+  void (*axpy)(std::size_t, T, const T *, T *);
+  // in the accumulator type, the 16 bit types' results aren't rounded yet
+  AccumulatorOf<T> (*dot)(std::size_t, const T *, const T *);
+  AccumulatorOf<T> (*sum)(std::size_t, const T *);
+  bool (*equal)(std::size_t, const T *, const T *);
+};
+
+// the generic bodies are written once over gcc vector extensions, `bytes` wide
+// (bytes == sizeof(T) being the scalar version). they're force-inlined into
+// the target-tagged entry points below, which is what makes them compile to
+// sse/avx/avx-512 code
+namespace simd {
+
+// vectors are only ever passed by reference here: passing them by value to or
+// from a function not compiled for their width is an abi change gcc warns
+// about, even when everything ends up inlined
+template <typename T, std::size_t bytes> struct Vector {
+  using Type [[gnu::vector_size(bytes)]] = T;
+  static constexpr auto lanes = bytes / sizeof(T);
+
+  [[gnu::always_inline]] static void load(Type &v, const T *p) {
+    std::memcpy(&v, p, bytes);
+  }
+
+  [[gnu::always_inline]] static void store(T *p, const Type &v) {
+    std::memcpy(p, &v, bytes);
+  }
+
+  [[gnu::always_inline]] static T horizontalSum(const Type &v) {
+    T result = T();
+    for (std::size_t i = 0; i < lanes; ++i)
+      result += v[i];
+    return result;
+  }
+};
+
+// out = a op b, op updating its first argument in place
+template <typename T, std::size_t bytes, typename Op>
+[[gnu::always_inline]] inline void binary(std::size_t n, const T *a,
+                                          const T *b, T *out, Op op) {
+  using V = Vector<T, bytes>;
+  typename V::Type x, y;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(x, a + i);
+    V::load(y, b + i);
+    op(x, y);
+    V::store(out + i, x);
+  }
+  for (; i < n; ++i) {
+    auto scalar = a[i];
+    op(scalar, b[i]);
+    out[i] = scalar;
+  }
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline void add(std::size_t n, const T *a, const T *b,
+                                       T *out) {
+  binary<T, bytes>(n, a, b, out, [](auto &x, const auto &y) { x += y; });
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline void subtract(std::size_t n, const T *a,
+                                            const T *b, T *out) {
+  binary<T, bytes>(n, a, b, out, [](auto &x, const auto &y) { x -= y; });
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline void scale(std::size_t n, const T *a, T scalar,
+                                         T *out) {
+  using V = Vector<T, bytes>;
+  typename V::Type x;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(x, a + i);
+    x *= scalar;
+    V::store(out + i, x);
+  }
+  for (; i < n; ++i)
+    out[i] = a[i] * scalar;
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline void axpy(std::size_t n, T alpha, const T *x,
+                                        T *y) {
+  using V = Vector<T, bytes>;
+  typename V::Type u, v;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(u, x + i);
+    V::load(v, y + i);
+    v += alpha * u;
+    V::store(y + i, v);
+  }
+  for (; i < n; ++i)
+    y[i] += alpha * x[i];
+}
+
+// reductions keep four independent accumulators so consecutive iterations
+// don't wait on each other's adds
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline T dot(std::size_t n, const T *a, const T *b) {
+  using V = Vector<T, bytes>;
+  typename V::Type acc[4]{}, x, y;
+  std::size_t i = 0;
+  for (; i + 4 * V::lanes <= n; i += 4 * V::lanes)
+    for (std::size_t j = 0; j < 4; ++j) {
+      V::load(x, a + i + j * V::lanes);
+      V::load(y, b + i + j * V::lanes);
+      acc[j] += x * y;
+    }
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(x, a + i);
+    V::load(y, b + i);
+    acc[0] += x * y;
+  }
+  acc[0] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+  auto result = V::horizontalSum(acc[0]);
+  for (; i < n; ++i)
+    result += a[i] * b[i];
+  return result;
+}
+
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline T sum(std::size_t n, const T *a) {
+  using V = Vector<T, bytes>;
+  typename V::Type acc[4]{}, x;
+  std::size_t i = 0;
+  for (; i + 4 * V::lanes <= n; i += 4 * V::lanes)
+    for (std::size_t j = 0; j < 4; ++j) {
+      V::load(x, a + i + j * V::lanes);
+      acc[j] += x;
+    }
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(x, a + i);
+    acc[0] += x;
+  }
+  acc[0] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+  auto result = V::horizontalSum(acc[0]);
+  for (; i < n; ++i)
+    result += a[i];
+  return result;
+}
+
+// same semantics as std::equal with ==, so 0 == -0 and nan != nan
+template <typename T, std::size_t bytes>
+[[gnu::always_inline]] inline bool equal(std::size_t n, const T *a,
+                                         const T *b) {
+  using V = Vector<T, bytes>;
+  typename V::Type x, y;
+  std::size_t i = 0;
+  for (; i + V::lanes <= n; i += V::lanes) {
+    V::load(x, a + i);
+    V::load(y, b + i);
+    const auto different = x != y;
+    for (std::size_t lane = 0; lane < V::lanes; ++lane)
+      if (different[lane])
+        return false;
+  }
+  for (; i < n; ++i)
+    if (a[i] != b[i])
+      return false;
+  return true;
+}
+
+// one set of entry points per instruction set
+#define MCPP_SIMD_ENTRY_POINTS(prefix, attributes, bytes)                      \
+  template <typename T>                                                        \
+  attributes void prefix##Add(std::size_t n, const T *a, const T *b, T *out) { \
+    add<T, bytes>(n, a, b, out);                                               \
+  }                                                                            \
+  template <typename T>                                                        \
+  attributes void prefix##Subtract(std::size_t n, const T *a, const T *b,      \
+                                   T *out) {                                   \
+    subtract<T, bytes>(n, a, b, out);                                          \
+  }                                                                            \
+  template <typename T>                                                        \
+  attributes void prefix##Scale(std::size_t n, const T *a, T s, T *out) {      \
+    scale<T, bytes>(n, a, s, out);                                             \
+  }                                                                            \
+  template <typename T>                                                        \
+  attributes void prefix##Axpy(std::size_t n, T alpha, const T *x, T *y) {     \
+    axpy<T, bytes>(n, alpha, x, y);                                            \
+  }                                                                            \
+  template <typename T>                                                        \
+  attributes T prefix##Dot(std::size_t n, const T *a, const T *b) {            \
+    return dot<T, bytes>(n, a, b);                                             \
+  }                                                                            \
+  template <typename T> attributes T prefix##Sum(std::size_t n, const T *a) {  \
+    return sum<T, bytes>(n, a);                                                \
+  }                                                                            \
+  template <typename T>                                                        \
+  attributes bool prefix##Equal(std::size_t n, const T *a, const T *b) {       \
+    return equal<T, bytes>(n, a, b);                                           \
+  }                                                                            \
+  template <typename T> SimdKernels<T> prefix##Kernels(SimdLevel level) {      \
+    return {level,           prefix##Add<T>,  prefix##Subtract<T>,             \
+            prefix##Scale<T>, prefix##Axpy<T>, prefix##Dot<T>,                 \
+            prefix##Sum<T>,   prefix##Equal<T>};                               \
+  }
+
+MCPP_SIMD_ENTRY_POINTS(scalar, , sizeof(T))
+#if MCPP_SIMD_X86
+MCPP_SIMD_ENTRY_POINTS(sse2, [[gnu::target("sse2")]], 16)
+MCPP_SIMD_ENTRY_POINTS(avx2, [[gnu::target("avx2,fma")]], 32)
+MCPP_SIMD_ENTRY_POINTS(avx512, [[gnu::target("avx512f")]], 64)
+#endif
+
+#undef MCPP_SIMD_ENTRY_POINTS
+
+} // namespace simd
+
+// the best level this cpu supports, checked once
+inline SimdLevel detectSimdLevel() {
+#if MCPP_SIMD_X86
+  static const auto level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+      return SimdLevel::avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      return SimdLevel::avx2;
+    if (__builtin_cpu_supports("sse2"))
+      return SimdLevel::sse2;
+    return SimdLevel::scalar;
+  }();
+  return level;
+#else
+  return SimdLevel::scalar;
+#endif
+}
+
+// kernels for a specific level, which must not exceed detectSimdLevel()
+template <typename T> SimdKernels<T> simdKernelsFor(SimdLevel level) {
+  switch (level) {
+#if MCPP_SIMD_X86
+  case SimdLevel::avx512:
+    return simd::avx512Kernels<T>(level);
+  case SimdLevel::avx2:
+    return simd::avx2Kernels<T>(level);
+  case SimdLevel::sse2:
+    return simd::sse2Kernels<T>(level);
+#endif
+  default:
+    return simd::scalarKernels<T>(SimdLevel::scalar);
+  }
+}
+
+// the kernels everything should call, resolved on first use
+template <typename T> const SimdKernels<T> &simdKernels() {
+  static const auto kernels = simdKernelsFor<T>(detectSimdLevel());
+  return kernels;
+}
+
+// below this many elements the indirect call costs more than the wide loop
+// saves, so callers with tiny fixed-size operands keep a plain loop
+constexpr std::size_t simdDispatchThreshold = 32;
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_SIMD_HPP
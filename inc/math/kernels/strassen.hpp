@@ -0,0 +1,93 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_STRASSEN_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_STRASSEN_HPP
+
+#include "math/kernels/gemm.hpp"
+#include "math/kernels/simd.hpp"
+#include <algorithm>
+#include <cstddef>
+
+// strassen-winograd: 7 half-size products and 15 additions per level instead
+// of 8 products. operands are row-major with unit column stride, and every
+// dimension must be divisible by 2^levels (the caller pads). each level only
+// needs two temporaries, x and y, thanks to the schedule of boyer, dumas,
+// pernet and zhou, which parks intermediate products in the quadrants of c
+
+namespace mcpp::math::kernels {
+
+// scratch elements all the levels of one product need, the temporaries of a
+// level being reused by every product one level below it
+inline std::size_t strassenScratchSize(std::size_t m, std::size_t n,
+                                       std::size_t k, std::size_t levels) {
+  std::size_t size = 0;
+  for (; levels > 0; --levels) {
+    m /= 2, n /= 2, k /= 2;
+    size += m * std::max(k, n) + k * n;
+  }
+  return size;
+}
+
+namespace strassen {
+
+// out = a + b or a - b over rows x columns blocks
+template <typename T>
+void combine(std::size_t rows, std::size_t columns, const T *a,
+             std::size_t lda, const T *b, std::size_t ldb, T *out,
+             std::size_t ldo, bool subtract) {
+  const auto &kernels = simdKernels<T>();
+  const auto op = subtract ? kernels.subtract : kernels.add;
+  for (std::size_t i = 0; i < rows; ++i)
+    op(columns, a + i * lda, b + i * ldb, out + i * ldo);
+}
+
+} // namespace strassen
+
+// c = a * b, c m x n, a m x k, b k x n. c is never read
+template <typename T>
+void strassenGemm(std::size_t m, std::size_t n, std::size_t k, const T *a,
+                  std::size_t lda, const T *b, std::size_t ldb, T *c,
+                  std::size_t ldc, std::size_t levels, T *scratch) {
+  if (levels == 0) {
+    gemm(m, n, k, T(1), a, lda, 1, b, ldb, 1, T(), c, ldc);
+    return;
+  }
+  using strassen::combine;
+  constexpr auto add = false, subtract = true;
+  const auto hm = m / 2, hn = n / 2, hk = k / 2;
+  const auto a11 = a, a12 = a + hk, a21 = a + hm * lda, a22 = a21 + hk;
+  const auto b11 = b, b12 = b + hn, b21 = b + hk * ldb, b22 = b21 + hn;
+  const auto c11 = c, c12 = c + hn, c21 = c + hm * ldc, c22 = c21 + hn;
+  // x holds hm x hk sums of a, and later the hm x hn product p1
+  const auto x = scratch, y = x + hm * std::max(hk, hn);
+  const auto next = y + hk * hn;
+  const auto product = [&](const T *l, std::size_t ldl, const T *r,
+                           std::size_t ldr, T *out, std::size_t ldo) {
+    strassenGemm(hm, hn, hk, l, ldl, r, ldr, out, ldo, levels - 1, next);
+  };
+
+  combine(hm, hk, a11, lda, a21, lda, x, hk, subtract); // s3
+  combine(hk, hn, b22, ldb, b12, ldb, y, hn, subtract); // t3
+  product(x, hk, y, hn, c21, ldc);                      // p7
+  combine(hm, hk, a21, lda, a22, lda, x, hk, add);      // s1
+  combine(hk, hn, b12, ldb, b11, ldb, y, hn, subtract); // t1
+  product(x, hk, y, hn, c22, ldc);                      // p5
+  combine(hm, hk, x, hk, a11, lda, x, hk, subtract);    // s2
+  combine(hk, hn, b22, ldb, y, hn, y, hn, subtract);    // t2
+  product(x, hk, y, hn, c12, ldc);                      // p6
+  combine(hm, hk, a12, lda, x, hk, x, hk, subtract);    // s4
+  product(x, hk, b22, ldb, c11, ldc);                   // p3
+  product(a11, lda, b11, ldb, x, hn);                   // p1
+  combine(hm, hn, x, hn, c12, ldc, c12, ldc, add);      // u2 = p1 + p6
+  combine(hm, hn, c12, ldc, c21, ldc, c21, ldc, add);   // u3 = u2 + p7
+  combine(hm, hn, c12, ldc, c22, ldc, c12, ldc, add);   // u4 = u2 + p5
+  combine(hm, hn, c21, ldc, c22, ldc, c22, ldc, add);   // u7 = u3 + p5
+  combine(hm, hn, c12, ldc, c11, ldc, c12, ldc, add);   // u5 = u4 + p3
+  combine(hk, hn, y, hn, b21, ldb, y, hn, subtract);    // t4 = t2 - b21
+  product(a22, lda, y, hn, c11, ldc);                   // p4
+  combine(hm, hn, c21, ldc, c11, ldc, c21, ldc, subtract); // u6 = u3 - p4
+  product(a12, lda, b21, ldb, c11, ldc);                // p2
+  combine(hm, hn, x, hn, c11, ldc, c11, ldc, add);      // u1 = p1 + p2
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_STRASSEN_HPP
@@ -0,0 +1,185 @@
+#ifndef MODERN_CPP_INC_MATH_KERNELS_TRANSPOSE_HPP
+#define MODERN_CPP_INC_MATH_KERNELS_TRANSPOSE_HPP
+
+#include "math/kernels/simd.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#if MCPP_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace mcpp::math::kernels {
+
+// transposes a size x size block, dst(j, i) = src(i, j), with the whole block
+// held in registers in between
+template <typename T>
+using TransposeBlock = void (*)(const T *, std::size_t, T *, std::size_t);
+
+template <typename T> struct TransposeKernel {
+  std::size_t size;
+  TransposeBlock<T> run;
+};
+
+namespace transpose_blocks {
+
+template <typename T, std::size_t size>
+void scalar(const T *src, std::size_t lds, T *dst, std::size_t ldd) {
+  for (std::size_t i = 0; i < size; ++i)
+    for (std::size_t j = 0; j < size; ++j)
+      dst[j * ldd + i] = src[i * lds + j];
+}
+
+#if MCPP_SIMD_X86
+[[gnu::target("sse2")]] inline void sse4x4(const float *src, std::size_t lds,
+                                           float *dst, std::size_t ldd) {
+  auto r0 = _mm_loadu_ps(src), r1 = _mm_loadu_ps(src + lds),
+       r2 = _mm_loadu_ps(src + 2 * lds), r3 = _mm_loadu_ps(src + 3 * lds);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  _mm_storeu_ps(dst, r0);
+  _mm_storeu_ps(dst + ldd, r1);
+  _mm_storeu_ps(dst + 2 * ldd, r2);
+  _mm_storeu_ps(dst + 3 * ldd, r3);
+}
+
+[[gnu::target("avx")]] inline void avx8x8(const float *src, std::size_t lds,
+                                          float *dst, std::size_t ldd) {
+  __m256 r[8], t[8];
+  for (std::size_t i = 0; i < 8; ++i)
+    r[i] = _mm256_loadu_ps(src + i * lds);
+  // interleave pairs of rows, then pairs of pairs, then swap 128-bit halves
+  for (std::size_t i = 0; i < 8; i += 2) {
+    t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+    t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+  }
+  for (std::size_t i = 0; i < 8; i += 4) {
+    r[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+    r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+    r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+    r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  for (std::size_t i = 0; i < 4; ++i) {
+    _mm256_storeu_ps(dst + i * ldd,
+                     _mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+    _mm256_storeu_ps(dst + (i + 4) * ldd,
+                     _mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+  }
+}
+
+[[gnu::target("sse2")]] inline void sse2x2(const double *src, std::size_t lds,
+                                           double *dst, std::size_t ldd) {
+  const auto r0 = _mm_loadu_pd(src), r1 = _mm_loadu_pd(src + lds);
+  _mm_storeu_pd(dst, _mm_unpacklo_pd(r0, r1));
+  _mm_storeu_pd(dst + ldd, _mm_unpackhi_pd(r0, r1));
+}
+
+[[gnu::target("avx")]] inline void avx4x4(const double *src, std::size_t lds,
+                                          double *dst, std::size_t ldd) {
+  const auto r0 = _mm256_loadu_pd(src), r1 = _mm256_loadu_pd(src + lds),
+             r2 = _mm256_loadu_pd(src + 2 * lds),
+             r3 = _mm256_loadu_pd(src + 3 * lds);
+  const auto t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1),
+             t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+  _mm256_storeu_pd(dst, _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd(dst + ldd, _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd(dst + 2 * ldd, _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd(dst + 3 * ldd, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+#endif
+
+} // namespace transpose_blocks
+
+template <typename T> TransposeKernel<T> transposeKernelFor(SimdLevel level) {
+#if MCPP_SIMD_X86
+  if constexpr (std::is_same_v<T, float>) {
+    if (level >= SimdLevel::avx2)
+      return {8, transpose_blocks::avx8x8};
+    if (level >= SimdLevel::sse2)
+      return {4, transpose_blocks::sse4x4};
+  } else if constexpr (std::is_same_v<T, double>) {
+    if (level >= SimdLevel::avx2)
+      return {4, transpose_blocks::avx4x4};
+    if (level >= SimdLevel::sse2)
+      return {2, transpose_blocks::sse2x2};
+  }
+#endif
+  (void)level;
+  return {4, transpose_blocks::scalar<T, 4>};
+}
+
+template <typename T> const TransposeKernel<T> &transposeKernel() {
+  static const auto kernel = transposeKernelFor<T>(detectSimdLevel());
+  return kernel;
+}
+
+// tiles small enough that source and destination both sit in l1
+constexpr std::size_t transposeTile = 32;
+
+// rows x cols block of src into cols x rows of dst, register blocks first and
+// whatever doesn't fill one element by element
+template <typename T>
+void transposeTileOf(std::size_t rows, std::size_t cols, const T *src,
+                     std::size_t lds, T *dst, std::size_t ldd) {
+  const auto &kernel = transposeKernel<T>();
+  const auto b = kernel.size, fullRows = rows / b * b, fullCols = cols / b * b;
+  for (std::size_t i = 0; i < fullRows; i += b)
+    for (std::size_t j = 0; j < fullCols; j += b)
+      kernel.run(src + i * lds + j, lds, dst + j * ldd + i, ldd);
+  for (std::size_t i = 0; i < rows; ++i)
+    for (std::size_t j = i < fullRows ? fullCols : 0; j < cols; ++j)
+      dst[j * ldd + i] = src[i * lds + j];
+}
+
+// dst = src^T for a row-major rows x cols src. cache-oblivious: halves the
+// longer side until a piece fits a tile, so every level of the hierarchy gets
+// reused without knowing its size. the split points stay multiples of the
+// register block
+template <typename T>
+void transpose(std::size_t rows, std::size_t cols, const T *src,
+               std::size_t lds, T *dst, std::size_t ldd) {
+  if (rows <= transposeTile && cols <= transposeTile) {
+    transposeTileOf(rows, cols, src, lds, dst, ldd);
+    return;
+  }
+  const auto b = transposeKernel<T>().size;
+  if (rows >= cols) {
+    const auto half = std::max(b, rows / 2 / b * b);
+    transpose(half, cols, src, lds, dst, ldd);
+    transpose(rows - half, cols, src + half * lds, lds, dst + half, ldd);
+  } else {
+    const auto half = std::max(b, cols / 2 / b * b);
+    transpose(rows, half, src, lds, dst, ldd);
+    transpose(rows, cols - half, src + half, lds, dst + half * ldd, ldd);
+  }
+}
+
+// in-place transpose of an n x n matrix. tiles mirrored across the diagonal
+// are swapped pairwise through one tile of stack scratch, tiles on it are
+// transposed with element swaps
+template <typename T>
+void transposeInPlace(std::size_t n, T *data, std::size_t ld) {
+  constexpr auto tile = transposeTile;
+  alignas(64) T scratch[tile * tile];
+  for (std::size_t bi = 0; bi < n; bi += tile) {
+    const auto rows = std::min(tile, n - bi);
+    auto diagonal = data + bi * ld + bi;
+    for (std::size_t i = 0; i < rows; ++i)
+      for (std::size_t j = i + 1; j < rows; ++j)
+        std::swap(diagonal[i * ld + j], diagonal[j * ld + i]);
+
+    for (std::size_t bj = bi + tile; bj < n; bj += tile) {
+      const auto cols = std::min(tile, n - bj);
+      auto upper = data + bi * ld + bj, lower = data + bj * ld + bi;
+      transposeTileOf(rows, cols, upper, ld, scratch, rows);
+      transposeTileOf(cols, rows, lower, ld, upper, ld);
+      for (std::size_t i = 0; i < cols; ++i)
+        std::copy_n(scratch + i * rows, rows, lower + i * ld);
+    }
+  }
+}
+
+} // namespace mcpp::math::kernels
+
+#endif // MODERN_CPP_INC_MATH_KERNELS_TRANSPOSE_HPP
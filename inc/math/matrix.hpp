@@ -1,82 +1,138 @@
 #ifndef MODERN_CPP_INC_MATH_MATRIX_HPP
 #define MODERN_CPP_INC_MATH_MATRIX_HPP
 
+#include "math/kernels/gemm.hpp"
+#include "math/kernels/gemv.hpp"
+#include "math/kernels/parallel_gemm.hpp"
+#include "math/kernels/reduce.hpp"
+#include "math/kernels/simd.hpp"
+#include "math/kernels/transpose.hpp"
 #include "math/static_matrix.hpp"
+#include "memory/aligned.hpp"
+#include "memory/memory_resource.hpp"
+#include "type_traits/type_traits.hpp"
 
 namespace mcpp::math {
 
-// template spec for dynamic matrix (dimensions unknown @ compile time)
-template <std::floating_point T> class Matrix<T, 0, 0> {
+// how far apart the rows of a dynamic matrix start. with cacheLine every row
+// is rounded up to whole cache lines, so rows begin on aligned boundaries and
+// threads working on different rows never share a line
+enum class Padding { none, cacheLine };
+
+// template spec for dynamic matrix (dimensions unknown @ compile time). the
+// buffer is always cache line aligned and holds height rows of stride
+// elements, of which the first width are the matrix (stride == width unless
+// padded, the padding is zeroed). the buffer comes from a memory resource,
+// kept for life like the data structures do
+template <MatrixElement T> class Matrix<T, 0, 0> {
   using MatrixInitList = std::initializer_list<std::initializer_list<T>>;
 
 public:
-  Matrix(std::size_t width, std::size_t height)
-      : width_(width), height_(height), data_(new T[width * height]) {}
+  Matrix(std::size_t width, std::size_t height,
+         Padding padding = Padding::none,
+         memory::MemoryResource *resource = memory::defaultResource())
+      : width_(width), height_(height), stride_(strideFor_(width, padding)),
+        resource_(resource), data_(allocate_(stride_ * height_)) {
+    zeroPadding_();
+  }
+
+  Matrix(std::size_t width, std::size_t height,
+         memory::MemoryResource *resource)
+      : Matrix(width, height, Padding::none, resource) {}
+
+  Matrix(const Matrix &other,
+         memory::MemoryResource *resource = memory::defaultResource())
+      : width_(other.width_), height_(other.height_), stride_(other.stride_),
+        resource_(resource), data_(allocate_(stride_ * height_)) {
+    std::copy_n(other.data_, stride_ * height_, data_);
+  }
+
+  Matrix(Matrix &&other) noexcept
+      : width_(other.width_), height_(other.height_), stride_(other.stride_),
+        resource_(other.resource_), data_(other.data_) {
+    other.width_ = other.height_ = other.stride_ = 0;
+    other.data_ = nullptr;
+  }
 
   template <std::size_t w, std::size_t h>
   explicit Matrix(const Matrix<T, w, h> &other)
-      : width_(other.width()), height_(other.height()),
-        data_(new T[width_ * height_]) {
-    std::copy_n(other.data_, width_ * height_, data_);
+      : Matrix(other.width(), other.height()) {
+    copyRows_(other);
   }
 
+  // fixed-size matrices keep their elements inline, there's nothing to steal
+  // from them so they just get copied
   template <std::size_t w, std::size_t h>
-  explicit Matrix(Matrix<T, w, h> &&other) noexcept
-      : width_(other.width()), height_(other.height()), data_(other.data_) {
-    if constexpr (w == 0 || h == 0)
-      other.width_ = other.height_ = 0;
-    other.data_ = nullptr;
+  explicit Matrix(Matrix<T, w, h> &&other) : Matrix(other) {}
+
+  template <MatrixExpression E>
+  Matrix(const E &e) : Matrix(e.width(), e.height()) {
+    assignExpression(data_, stride_, e);
   }
 
+  // copies the elements a view looks at into a new matrix
+  template <typename U>
+  explicit Matrix(const MatrixView<U> &view) : Matrix(asExpression(view)) {}
+
   Matrix(const MatrixInitList &initList)
-      : width_(initList.begin()->size()), height_(initList.size()),
-        data_(new T[width_ * height_]) {
+      : Matrix(initList.begin()->size(), initList.size()) {
     for (std::size_t i = 0; i < initList.size(); ++i)
       for (std::size_t j = 0; j < (initList.begin() + i)->size(); ++j)
         operator()(i, j) = *((initList.begin() + i)->begin() + j);
   }
 
-  template <std::size_t w, std::size_t h>
-  Matrix &operator=(const Matrix<T, w, h> &other) {
+  ~Matrix() { deallocate_(); }
+
+  Matrix &operator=(const Matrix &other) {
     if (this == &other)
       goto skipCopy;
-    if (other.width() * other.height() == width_ * height_)
-      goto skipRealloc;
-    delete[] data_;
-    data_ = new T[other.width() * other.height()];
-  skipRealloc:
-    width_ = other.width();
-    height_ = other.height();
-    std::copy_n(other.data_, width_ * height_, data_);
+    reshape_(other.width_, other.height_, other.stride_);
+    std::copy_n(other.data_, stride_ * height_, data_);
   skipCopy:
     return *this;
   }
 
-  template <std::size_t w, std::size_t h>
-  Matrix &operator=(Matrix<T, w, h> &&other) {
+  // keeps this matrix's resource, so moving from a matrix with a different
+  // one copies
+  Matrix &operator=(Matrix &&other) {
     if (this == &other)
       goto skipMove;
-    width_ = other.width();
-    height_ = other.height();
-    delete[] data_;
-    data_ = other.data_;
-    if constexpr (w == 0 || h == 0)
-      other.width_ = other.height_ = 0;
-    other.data_ = nullptr;
+    if (resource_ != other.resource_) {
+      *this = other;
+      goto skipMove;
+    }
+    deallocate_();
+    width_ = std::exchange(other.width_, 0);
+    height_ = std::exchange(other.height_, 0);
+    stride_ = std::exchange(other.stride_, 0);
+    data_ = std::exchange(other.data_, nullptr);
   skipMove:
     return *this;
   }
 
+  template <std::size_t w, std::size_t h>
+  Matrix &operator=(const Matrix<T, w, h> &other) {
+    reshape_(other.width(), other.height(), other.width());
+    copyRows_(other);
+    return *this;
+  }
+
+  template <MatrixExpression E> Matrix &operator=(const E &e) {
+    // a new shape means a new buffer, and the expression may be reading the
+    // old one through a view, so it's evaluated before the old one goes
+    if (e.width() != width_ || e.height() != height_) {
+      Matrix result(e.width(), e.height(), resource_);
+      assignExpression(result.data_, result.stride_, e);
+      return *this = std::move(result);
+    }
+    assignExpression(data_, stride_, e);
+    return *this;
+  }
+
   Matrix &operator=(const MatrixInitList &initList) {
     const auto listWidth = initList.begin()->size(),
                listHeight = initList.size();
-    if (listWidth * listHeight == width_ * height_)
-      goto skipRealloc;
-    delete[] data_;
-    data_ = new T[listWidth * listHeight];
-  skipRealloc:
-    width_ = listWidth;
-    height_ = listHeight;
+    reshape_(listWidth, listHeight, listWidth);
     for (std::size_t i = 0; i < listHeight; ++i)
       for (std::size_t j = 0; j < (initList.begin() + i)->size(); ++j)
         operator()(i, j) = *((initList.begin() + i)->begin() + j);
@@ -84,52 +140,50 @@ public:
   }
 
   template <std::size_t w, std::size_t h>
-  [[nodiscard]] bool operator==(const Matrix<T, w, h> &other) {
-    return std::equal(data_, data_ + width_ * height_, other.data_,
-                      other.data_ + other.width() * other.height());
+  [[nodiscard]] bool operator==(const Matrix<T, w, h> &other) const {
+    if (width_ * height_ != other.width() * other.height())
+      return false;
+    const auto &kernels = kernels::simdKernels<T>();
+    if (contiguous() && other.stride() == other.width())
+      return kernels.equal(width_ * height_, data_, other.data());
+    if (width_ != other.width())
+      return false;
+    for (std::size_t i = 0; i < height_; ++i)
+      if (!kernels.equal(width_, row_(i), other.data() + i * other.stride()))
+        return false;
+    return true;
   }
 
   template <std::size_t w, std::size_t h>
-  [[nodiscard]] bool operator!=(const Matrix<T, w, h> &other) {
+  [[nodiscard]] bool operator!=(const Matrix<T, w, h> &other) const {
     return !operator==(other);
   }
 
-  [[nodiscard]] Matrix operator-() const { return *this * T(-1); }
-
-  template <std::size_t w, std::size_t h>
-  [[nodiscard]] Matrix operator+(const Matrix<T, w, h> &other) const {
-    assert(width_ == other.width() && height_ == other.height());
-    Matrix result(other.width(), other.height());
-    std::transform(data_, data_ + other.width() * other.height(), other.data_,
-                   result.data_, std::plus());
-    return result;
-  }
+  // +, -, unary - and scalar * / are lazy, see math/matrix_expression.hpp
 
+  // dynamic*dynamic or dynamic*static
   template <std::size_t w, std::size_t h>
-  [[nodiscard]] Matrix operator-(const Matrix<T, w, h> &other) const {
-    return *this + -other;
-  }
-
-  [[nodiscard]] Matrix operator*(T scalar) const {
-    Matrix result(width_, height_);
-    std::transform(data_, data_ + width_ * height_, result.data_,
-                   [scalar](T elem) { return elem * scalar; });
+  [[nodiscard]] Matrix operator*(const Matrix<T, w, h> &other) const {
+    assert(width_ == other.height());
+    Matrix result(other.width(), height_);
+    kernels::product(height_, other.width(), width_, data_, stride_,
+                     other.data(), other.stride(), result.data_,
+                     result.stride_);
     return result;
   }
 
-  [[nodiscard]] Matrix operator/(T scalar) const {
-    return *this * (T(1) / scalar);
-  }
-
-  // dynamic*dynamic or dynamic*static
+  // same product as operator*, with the output split into tiles computed on
+  // the pool. the result doesn't depend on the pool's thread count
   template <std::size_t w, std::size_t h>
-  [[nodiscard]] Matrix operator*(const Matrix<T, w, h> &other) const {
+  [[nodiscard]] Matrix
+  multiply(const Matrix<T, w, h> &other,
+           concurrency::ThreadPool &pool = concurrency::defaultThreadPool())
+      const {
     assert(width_ == other.height());
     Matrix result(other.width(), height_);
-    for (std::size_t i = 0; i < height_; ++i)
-      for (std::size_t j = 0; j < other.width(); ++j)
-        for (std::size_t k = 0; k < width_; ++k)
-          result(i, j) += operator()(i, k) * other(k, j);
+    kernels::parallelProduct(pool, height_, other.width(), width_, data_,
+                             stride_, other.data(), other.stride(),
+                             result.data_, result.stride_);
     return result;
   }
 
@@ -139,27 +193,40 @@ public:
   operator*(const Matrix<T, w, h> &a, const Matrix<T, 0, 0> &b) {
     assert(w == b.height_);
     Matrix result(b.width_, h);
-    for (std::size_t i = 0; i < h; ++i)
-      for (std::size_t j = 0; j < b.width_; ++j)
-        for (std::size_t k = 0; k < w; ++k)
-          result(i, j) += a(i, k) * b(k, j);
+    kernels::product(h, b.width_, w, a.data(), w, b.data_, b.stride_,
+                     result.data_, result.stride_);
     return result;
   }
 
   template <std::size_t w, std::size_t h>
   [[nodiscard]] T dot(const Matrix<T, w, h> &other) const {
-    assert(width_ == other.width() && height_ == other.height() &&
-           (width_ == 1 || height_ == 1));
-    return std::inner_product(data_, data_ + w * h, other.data_, T());
+    return dot_(other);
   }
 
   template <std::size_t w, std::size_t h>
   [[nodiscard]] Matrix cross(const Matrix<T, w, h> &other) const {
     assert(width_ == other.width() && height_ == other.height() &&
            ((width_ == 1 && height_ == 3) || (height_ == 1 && width_ == 3)));
-    // TODO: implement cross product here too
+    // padded column vectors keep one component per row
+    const auto at = [](const auto &m, std::size_t k) {
+      return m.data()[m.width() == 1 ? k * m.stride() : k];
+    };
+    Matrix result(width_, height_);
+    result(0, 0) = at(*this, 1) * at(other, 2) - at(*this, 2) * at(other, 1);
+    const auto y = at(*this, 2) * at(other, 0) - at(*this, 0) * at(other, 2);
+    const auto z = at(*this, 0) * at(other, 1) - at(*this, 1) * at(other, 0);
+    if (width_ == 1) {
+      result(1, 0) = y;
+      result(2, 0) = z;
+    } else {
+      result(0, 1) = y;
+      result(0, 2) = z;
+    }
+    return result;
   }
 
+  // elementwise compound operators evaluate in place through the expression
+  // machinery, see also math/blas.hpp
   template <std::size_t w, std::size_t h>
   Matrix &operator+=(const Matrix<T, w, h> &other) {
     return *this = *this + other;
@@ -181,34 +248,219 @@ public:
 
   [[nodiscard]] T length() const {
     assert(width_ == 1 || height_ == 1);
-    return std::sqrt(dot(*this));
+    return std::sqrt(dot_(*this));
+  }
+
+  // reductions, see math/kernels/reduce.hpp. big matrices are split over the
+  // default pool, which doesn't change the result. norm is the frobenius
+  // norm, normL1 and normInf the largest column and row sums of magnitudes
+  [[nodiscard]] T sum(Summation summation = Summation::pairwise) const {
+    return reduce_(Reduction::sum, summation);
+  }
+
+  [[nodiscard]] T norm(Summation summation = Summation::pairwise) const {
+    return std::sqrt(reduce_(Reduction::sumSquares, summation));
+  }
+
+  [[nodiscard]] T normL1(Summation summation = Summation::pairwise) const {
+    if (width_ == 0 || height_ == 0)
+      return T();
+    const auto sums = reduceColumns_(Reduction::sumAbs, summation);
+    return *std::max_element(sums.begin(), sums.end());
+  }
+
+  [[nodiscard]] T normInf(Summation summation = Summation::pairwise) const {
+    if (width_ == 0 || height_ == 0)
+      return T();
+    const auto sums = reduceRows_(Reduction::sumAbs, summation);
+    return *std::max_element(sums.begin(), sums.end());
+  }
+
+  [[nodiscard]] T min() const {
+    return reduce_(Reduction::min, Summation::plain);
+  }
+
+  [[nodiscard]] T max() const {
+    return reduce_(Reduction::max, Summation::plain);
+  }
+
+  // first position of the extreme in row-major order
+  [[nodiscard]] MatrixIndex argmin() const {
+    return kernels::findElement(data_, width_, height_, stride_, min());
+  }
+
+  [[nodiscard]] MatrixIndex argmax() const {
+    return kernels::findElement(data_, width_, height_, stride_, max());
+  }
+
+  // one result per row as a column vector, one per column as a row vector
+  [[nodiscard]] Matrix
+  rowwise(Reduction kind, Summation summation = Summation::pairwise) const {
+    const auto results = reduceRows_(kind, summation);
+    Matrix result(1, height_);
+    std::copy(results.begin(), results.end(), result.data_);
+    return result;
+  }
+
+  [[nodiscard]] Matrix
+  columnwise(Reduction kind, Summation summation = Summation::pairwise) const {
+    const auto results = reduceColumns_(kind, summation);
+    Matrix result(width_, 1);
+    std::copy(results.begin(), results.end(), result.data_);
+    return result;
   }
 
   [[nodiscard]] T operator()(std::size_t row, std::size_t column) const {
     assert(row < height_ && column < width_);
-    return data_[row * width_ + column];
+    return data_[row * stride_ + column];
   }
 
   T &operator()(std::size_t row, std::size_t column) {
     assert(row < height_ && column < width_);
-    return data_[row * width_ + column];
+    return data_[row * stride_ + column];
   }
 
-  [[nodiscard]] Matrix transposed() const;
+  [[nodiscard]] Matrix transposed() const {
+    Matrix result(height_, width_);
+    kernels::transpose(height_, width_, data_, stride_, result.data_,
+                       result.stride_);
+    return result;
+  }
 
-  [[maybe_unused]] void transpose() { *this = transposed(); }
+  // square matrices are transposed in place, anything else needs a second
+  // buffer anyway
+  [[maybe_unused]] void transpose() {
+    if (width_ == height_)
+      kernels::transposeInPlace(width_, data_, stride_);
+    else
+      *this = transposed();
+  }
 
   [[nodiscard]] std::size_t width() const { return width_; }
 
   [[nodiscard]] std::size_t height() const { return height_; }
 
-  [[nodiscard]] const T *begin() const { return data_; }
-  [[nodiscard]] T *begin() { return data_; }
-  [[nodiscard]] const T *end() const { return data_ + width_ * height_; }
-  [[nodiscard]] T *end() { return data_ + width_ * height_; }
+  // elements between the starts of consecutive rows
+  [[nodiscard]] std::size_t stride() const { return stride_; }
+
+  [[nodiscard]] bool contiguous() const { return stride_ == width_; }
+
+  [[nodiscard]] const T *data() const { return data_; }
+  [[nodiscard]] T *data() { return data_; }
+
+  // iterating element by element only makes sense without padding, padded
+  // matrices are walked row by row through view()
+  [[nodiscard]] const T *begin() const {
+    assert(contiguous());
+    return data_;
+  }
+  [[nodiscard]] T *begin() {
+    assert(contiguous());
+    return data_;
+  }
+  [[nodiscard]] const T *end() const { return begin() + width_ * height_; }
+  [[nodiscard]] T *end() { return begin() + width_ * height_; }
+
+  // zero-copy window onto the whole matrix, narrow it with block/row/column
+  [[nodiscard]] MatrixView<T> view() { return *this; }
+  [[nodiscard]] MatrixView<const T> view() const { return *this; }
+
+  [[nodiscard]] memory::MemoryResource *resource() const { return resource_; }
 
 private:
-  std::size_t width_, height_;
+  static std::size_t strideFor_(std::size_t width, Padding padding) {
+    constexpr auto lineElements = memory::cacheLineSize / sizeof(T);
+    if (padding == Padding::none || memory::cacheLineSize % sizeof(T) != 0)
+      return width;
+    return (width + lineElements - 1) / lineElements * lineElements;
+  }
+
+  T *allocate_(std::size_t count) {
+    return static_cast<T *>(
+        resource_->allocate(count * sizeof(T), memory::cacheLineSize));
+  }
+
+  void deallocate_() noexcept {
+    if (data_)
+      resource_->deallocate(data_, stride_ * height_ * sizeof(T),
+                            memory::cacheLineSize);
+  }
+
+  // makes room for a new shape, keeping the buffer when it's the same size
+  void reshape_(std::size_t width, std::size_t height, std::size_t stride) {
+    if (stride * height != stride_ * height_) {
+      deallocate_();
+      data_ = nullptr; // in case allocating throws
+      data_ = allocate_(stride * height);
+    }
+    width_ = width;
+    height_ = height;
+    stride_ = stride;
+    zeroPadding_();
+  }
+
+  // so kernels can read whole padded rows
+  void zeroPadding_() {
+    if (stride_ != width_)
+      for (std::size_t i = 0; i < height_; ++i)
+        std::fill(data_ + i * stride_ + width_, data_ + (i + 1) * stride_,
+                  T());
+  }
+
+  AccumulatorOf<T> reduce_(Reduction kind, Summation summation) const {
+    return kernels::reduceMatrix(kind, summation, data_, width_, height_,
+                                 stride_, &concurrency::defaultThreadPool());
+  }
+
+  // in the accumulator type, rounded once by dot() and length()
+  template <std::size_t w, std::size_t h>
+  AccumulatorOf<T> dot_(const Matrix<T, w, h> &other) const {
+    assert(width_ == other.width() && height_ == other.height() &&
+           (width_ == 1 || height_ == 1));
+    // row vectors are contiguous whatever their padding, padded column
+    // vectors keep one element per row
+    const auto step = [](const auto &m) {
+      return m.height() == 1 ? std::size_t(1) : m.stride();
+    };
+    const auto size = width_ * height_, thisStep = step(*this),
+               otherStep = step(other);
+    if (thisStep == 1 && otherStep == 1)
+      return kernels::simdKernels<T>().dot(size, data_, other.data());
+    AccumulatorOf<T> result = AccumulatorOf<T>();
+    for (std::size_t i = 0; i < size; ++i)
+      result += data_[i * thisStep] * other.data()[i * otherStep];
+    return result;
+  }
+
+  std::vector<AccumulatorOf<T>> reduceRows_(Reduction kind,
+                                            Summation summation) const {
+    std::vector<AccumulatorOf<T>> results(height_);
+    kernels::reduceRows(kind, summation, data_, width_, height_, stride_,
+                        results.data(), &concurrency::defaultThreadPool());
+    return results;
+  }
+
+  std::vector<AccumulatorOf<T>> reduceColumns_(Reduction kind,
+                                               Summation summation) const {
+    std::vector<AccumulatorOf<T>> results(width_);
+    kernels::reduceColumns(kind, summation, data_, width_, height_, stride_,
+                           results.data(), &concurrency::defaultThreadPool());
+    return results;
+  }
+
+  [[nodiscard]] const T *row_(std::size_t index) const {
+    return data_ + index * stride_;
+  }
+
+  template <std::size_t w, std::size_t h>
+  void copyRows_(const Matrix<T, w, h> &other) {
+    for (std::size_t i = 0; i < height_; ++i)
+      std::copy_n(other.data() + i * other.stride(), width_,
+                  data_ + i * stride_);
+  }
+
+  std::size_t width_, height_, stride_;
+  memory::MemoryResource *resource_;
   T *data_;
 
   template <std::floating_point U> friend class HeapMatrix;
@@ -216,10 +468,22 @@ private:
 
 // aliases
 
-template <std::floating_point T> using DMatrix = Matrix<T, 0, 0>;
+template <MatrixElement T> using DMatrix = Matrix<T, 0, 0>;
 
 using DFMatrix [[maybe_unused]] = DMatrix<float>;
+using DHMatrix [[maybe_unused]] = DMatrix<Half>;
+using DBMatrix [[maybe_unused]] = DMatrix<BFloat16>;
 
 } // namespace mcpp::math
 
+namespace mcpp::type_traits {
+
+// the elements are on the heap, the object itself is sizes and a pointer
+template <math::MatrixElement T>
+struct IsTriviallyRelocatable<math::DMatrix<T>> {
+  static constexpr const bool value = true;
+};
+
+} // namespace mcpp::type_traits
+
 #endif // MODERN_CPP_INC_MATH_MATRIX_HPP
@@ -0,0 +1,346 @@
+#ifndef MODERN_CPP_INC_MATH_MATRIX_EXPRESSION_HPP
+#define MODERN_CPP_INC_MATH_MATRIX_EXPRESSION_HPP
+
+#include "math/half.hpp"
+#include "math/kernels/convert.hpp"
+#include "math/kernels/simd.hpp"
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+// lazy elementwise arithmetic. +, -, unary - and scalar * / on matrices don't
+// compute anything, they build a small tree of nodes holding references to the
+// operands. the tree is only walked when it gets assigned to (or used to
+// construct) a matrix, in a single loop that writes each destination element
+// exactly once, so `a + b * 2.f - c` costs one pass and no temporaries.
+// careful with `auto`: an unevaluated expression keeps references to its
+// operands and must not outlive them
+
+namespace mcpp::math {
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+class Matrix;
+
+template <typename T> class MatrixView;
+
+template <typename T> struct IsMatrix {
+  static constexpr const bool value = false;
+};
+
+template <MatrixElement T, std::size_t w, std::size_t h>
+struct IsMatrix<Matrix<T, w, h>> {
+  static constexpr const bool value = true;
+};
+
+template <typename T>
+constexpr auto IsMatrixV = IsMatrix<std::remove_cvref_t<T>>::value;
+
+template <typename T> struct IsMatrixView {
+  static constexpr const bool value = false;
+};
+
+template <typename T>
+constexpr auto IsMatrixViewV = IsMatrixView<std::remove_cvref_t<T>>::value;
+
+// operands with actual elements behind them, as opposed to lazy expressions
+template <typename E>
+concept DenseOperand = IsMatrixV<E> || IsMatrixViewV<E>;
+
+// anything that can be evaluated elementwise. static dimensions are 0 when only
+// known at runtime
+template <typename E>
+concept MatrixExpression = requires(const E &e, std::size_t i) {
+  typename E::ValueType;
+  { E::staticWidth } -> std::convertible_to<std::size_t>;
+  { E::staticHeight } -> std::convertible_to<std::size_t>;
+  { e.width() } -> std::same_as<std::size_t>;
+  { e.height() } -> std::same_as<std::size_t>;
+  { e.coeff(i, i) } -> std::convertible_to<typename E::ValueType>;
+};
+
+template <typename E>
+concept MatrixOperand = DenseOperand<E> || MatrixExpression<E>;
+
+// leaf node, a row-major block of existing storage
+template <MatrixElement T, std::size_t w, std::size_t h>
+class MatrixReference {
+public:
+  using ValueType = T;
+  static constexpr std::size_t staticWidth = w, staticHeight = h;
+
+  constexpr MatrixReference(const T *data, std::size_t width,
+                            std::size_t height, std::size_t stride)
+      : data_(data), width_(width), height_(height), stride_(stride) {}
+
+  [[nodiscard]] constexpr std::size_t width() const { return width_; }
+  [[nodiscard]] constexpr std::size_t height() const { return height_; }
+
+  [[nodiscard]] constexpr T coeff(std::size_t row, std::size_t column) const {
+    return data_[row * stride_ + column];
+  }
+
+  [[nodiscard]] constexpr const T *row(std::size_t index) const {
+    return data_ + index * stride_;
+  }
+
+  [[nodiscard]] constexpr bool contiguous() const { return stride_ == width_; }
+
+private:
+  const T *data_;
+  std::size_t width_, height_, stride_;
+};
+
+template <MatrixExpression L, MatrixExpression R, typename Op>
+class BinaryExpression {
+public:
+  using ValueType = typename L::ValueType;
+  static constexpr std::size_t
+      staticWidth = L::staticWidth ? L::staticWidth : R::staticWidth,
+      staticHeight = L::staticHeight ? L::staticHeight : R::staticHeight;
+
+  static_assert(std::is_same_v<ValueType, typename R::ValueType>);
+  static_assert(!L::staticWidth || !R::staticWidth ||
+                L::staticWidth == R::staticWidth);
+  static_assert(!L::staticHeight || !R::staticHeight ||
+                L::staticHeight == R::staticHeight);
+
+  constexpr BinaryExpression(const L &lhs, const R &rhs, Op op = Op())
+      : lhs_(lhs), rhs_(rhs), op_(op) {
+    assert(lhs_.width() == rhs_.width() && lhs_.height() == rhs_.height());
+  }
+
+  [[nodiscard]] constexpr std::size_t width() const { return lhs_.width(); }
+  [[nodiscard]] constexpr std::size_t height() const { return lhs_.height(); }
+
+  [[nodiscard]] constexpr ValueType coeff(std::size_t row,
+                                          std::size_t column) const {
+    return op_(lhs_.coeff(row, column), rhs_.coeff(row, column));
+  }
+
+  [[nodiscard]] constexpr const L &lhs() const { return lhs_; }
+  [[nodiscard]] constexpr const R &rhs() const { return rhs_; }
+
+private:
+  L lhs_;
+  R rhs_;
+  [[no_unique_address]] Op op_;
+};
+
+template <MatrixExpression E, typename Op> class UnaryExpression {
+public:
+  using ValueType = typename E::ValueType;
+  static constexpr std::size_t staticWidth = E::staticWidth,
+                               staticHeight = E::staticHeight;
+
+  constexpr explicit UnaryExpression(const E &operand, Op op = Op())
+      : operand_(operand), op_(op) {}
+
+  [[nodiscard]] constexpr std::size_t width() const { return operand_.width(); }
+  [[nodiscard]] constexpr std::size_t height() const {
+    return operand_.height();
+  }
+
+  [[nodiscard]] constexpr ValueType coeff(std::size_t row,
+                                          std::size_t column) const {
+    return op_(operand_.coeff(row, column));
+  }
+
+  [[nodiscard]] constexpr const E &operand() const { return operand_; }
+  [[nodiscard]] constexpr const Op &op() const { return op_; }
+
+private:
+  E operand_;
+  [[no_unique_address]] Op op_;
+};
+
+template <typename T> struct ScaleBy {
+  T scalar;
+  constexpr T operator()(T element) const { return element * scalar; }
+};
+
+// scalar / element, for dividing a scalar by a matrix elementwise
+template <typename T> struct DivideInto {
+  T scalar;
+  constexpr T operator()(T element) const { return scalar / element; }
+};
+
+// turns an operand into an expression node, wrapping matrices into leaves
+template <MatrixElement T, std::size_t w, std::size_t h>
+constexpr MatrixReference<T, w, h> asExpression(const Matrix<T, w, h> &m) {
+  return {m.data(), m.width(), m.height(), m.stride()};
+}
+
+template <MatrixExpression E> constexpr const E &asExpression(const E &e) {
+  return e;
+}
+
+template <MatrixOperand E>
+using ExpressionOf = std::remove_cvref_t<decltype(asExpression(
+    std::declval<const E &>()))>;
+
+template <MatrixOperand E>
+using ValueTypeOf = typename ExpressionOf<E>::ValueType;
+
+template <typename E> struct IsMatrixReference {
+  static constexpr const bool value = false;
+};
+
+template <MatrixElement T, std::size_t w, std::size_t h>
+struct IsMatrixReference<MatrixReference<T, w, h>> {
+  static constexpr const bool value = true;
+};
+
+template <typename E, typename Op>
+constexpr auto IsLeafBinaryV = false;
+
+template <typename L, typename R, typename Op>
+constexpr auto IsLeafBinaryV<BinaryExpression<L, R, Op>, Op> =
+    IsMatrixReference<L>::value && IsMatrixReference<R>::value;
+
+template <typename E, typename Op>
+constexpr auto IsLeafUnaryV = false;
+
+template <typename E, typename Op>
+constexpr auto IsLeafUnaryV<UnaryExpression<E, Op>, Op> =
+    IsMatrixReference<E>::value;
+
+// single-operation trees over plain matrices map directly onto one of the
+// runtime-dispatched simd kernels. they're run over the whole buffer at once
+// when nothing is strided, row by row otherwise. returns false for anything
+// the kernels don't cover
+template <MatrixExpression E>
+bool assignWithKernels(typename E::ValueType *destination, std::size_t stride,
+                       const E &e) {
+  using T = typename E::ValueType;
+  const auto &kernels = kernels::simdKernels<T>();
+  const auto width = e.width(), height = e.height();
+  const auto forRows = [&](bool contiguous, auto run) {
+    if (contiguous && stride == width)
+      run(0, width * height);
+    else
+      for (std::size_t i = 0; i < height; ++i)
+        run(i, width);
+    return true;
+  };
+
+  if constexpr (IsLeafBinaryV<E, std::plus<>>)
+    return forRows(e.lhs().contiguous() && e.rhs().contiguous(),
+                   [&](std::size_t i, std::size_t n) {
+                     kernels.add(n, e.lhs().row(i), e.rhs().row(i),
+                                 destination + i * stride);
+                   });
+  else if constexpr (IsLeafBinaryV<E, std::minus<>>)
+    return forRows(e.lhs().contiguous() && e.rhs().contiguous(),
+                   [&](std::size_t i, std::size_t n) {
+                     kernels.subtract(n, e.lhs().row(i), e.rhs().row(i),
+                                      destination + i * stride);
+                   });
+  else if constexpr (IsLeafUnaryV<E, ScaleBy<T>>)
+    return forRows(e.operand().contiguous(), [&](std::size_t i, std::size_t n) {
+      kernels.scale(n, e.operand().row(i), e.op().scalar,
+                    destination + i * stride);
+    });
+  else if constexpr (IsLeafUnaryV<E, std::negate<>>)
+    return forRows(e.operand().contiguous(), [&](std::size_t i, std::size_t n) {
+      kernels.scale(n, e.operand().row(i), T(-1), destination + i * stride);
+    });
+  else
+    return false;
+}
+
+// the fused loop everything ends up in, unless a single simd kernel covers the
+// whole expression. rows are walked in order and the inner loop is unit-stride
+// on the destination, so it vectorizes once the tree is inlined
+template <MatrixExpression E>
+constexpr void assignExpression(typename E::ValueType *destination,
+                                std::size_t stride, const E &e) {
+  const auto width = e.width(), height = e.height();
+  constexpr auto staticSize = E::staticWidth * E::staticHeight;
+  if constexpr (staticSize == 0 ||
+                staticSize >= kernels::simdDispatchThreshold)
+    if (!std::is_constant_evaluated() &&
+        width * height >= kernels::simdDispatchThreshold &&
+        assignWithKernels(destination, stride, e))
+      return;
+  for (std::size_t i = 0; i < height; ++i) {
+    auto row = destination + i * stride;
+    for (std::size_t j = 0; j < width; ++j)
+      row[j] = e.coeff(i, j);
+  }
+}
+
+// the matrix type an expression evaluates to: fixed-size if both dimensions
+// are known at compile time, dynamic otherwise
+template <MatrixOperand E>
+using EvaluatedType = std::conditional_t<
+    ExpressionOf<E>::staticWidth != 0 && ExpressionOf<E>::staticHeight != 0,
+    Matrix<ValueTypeOf<E>, ExpressionOf<E>::staticWidth,
+           ExpressionOf<E>::staticHeight>,
+    Matrix<ValueTypeOf<E>, 0, 0>>;
+
+template <MatrixOperand E> constexpr decltype(auto) evaluated(const E &e) {
+  if constexpr (DenseOperand<E>)
+    return (e);
+  else
+    return EvaluatedType<E>(e);
+}
+
+// operators
+
+template <MatrixOperand L, MatrixOperand R>
+[[nodiscard]] constexpr auto operator+(const L &lhs, const R &rhs) {
+  return BinaryExpression<ExpressionOf<L>, ExpressionOf<R>, std::plus<>>(
+      asExpression(lhs), asExpression(rhs));
+}
+
+template <MatrixOperand L, MatrixOperand R>
+[[nodiscard]] constexpr auto operator-(const L &lhs, const R &rhs) {
+  return BinaryExpression<ExpressionOf<L>, ExpressionOf<R>, std::minus<>>(
+      asExpression(lhs), asExpression(rhs));
+}
+
+template <MatrixOperand E> [[nodiscard]] constexpr auto operator-(const E &e) {
+  return UnaryExpression<ExpressionOf<E>, std::negate<>>(asExpression(e));
+}
+
+template <MatrixOperand E>
+[[nodiscard]] constexpr auto
+operator*(const E &e, std::type_identity_t<ValueTypeOf<E>> scalar) {
+  using T = ValueTypeOf<E>;
+  return UnaryExpression<ExpressionOf<E>, ScaleBy<T>>(asExpression(e),
+                                                      ScaleBy<T>{scalar});
+}
+
+template <MatrixOperand E>
+[[nodiscard]] constexpr auto
+operator*(std::type_identity_t<ValueTypeOf<E>> scalar, const E &e) {
+  return e * scalar;
+}
+
+template <MatrixOperand E>
+[[nodiscard]] constexpr auto
+operator/(const E &e, std::type_identity_t<ValueTypeOf<E>> scalar) {
+  return e * (ValueTypeOf<E>(1) / scalar);
+}
+
+template <MatrixOperand E>
+[[nodiscard]] constexpr auto
+operator/(std::type_identity_t<ValueTypeOf<E>> scalar, const E &e) {
+  using T = ValueTypeOf<E>;
+  return UnaryExpression<ExpressionOf<E>, DivideInto<T>>(asExpression(e),
+                                                         DivideInto<T>{scalar});
+}
+
+// matrix products aren't elementwise, so an expression operand is evaluated
+// first and the product goes through the dense operands' own operator*
+template <MatrixOperand L, MatrixOperand R>
+  requires(!DenseOperand<L> || !DenseOperand<R>)
+[[nodiscard]] constexpr auto operator*(const L &lhs, const R &rhs) {
+  return evaluated(lhs) * evaluated(rhs);
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_MATRIX_EXPRESSION_HPP
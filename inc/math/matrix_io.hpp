@@ -0,0 +1,279 @@
+#ifndef MODERN_CPP_INC_MATH_MATRIX_IO_HPP
+#define MODERN_CPP_INC_MATH_MATRIX_IO_HPP
+
+#include "math/matrix.hpp"
+#include "math/matrix_view.hpp"
+#include "memory/aligned.hpp"
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// binary matrix files: a fixed 64 byte header followed by the raw rows, so
+// the elements start on a cache line (and a page, once mapped) and can be
+// used straight from a mapping of the file without parsing anything.
+// elements are stored in the writer's byte order, which the header records;
+// files from a machine of the other endianness are rejected, not swapped.
+// mapping uses posix mmap
+
+namespace mcpp::math {
+
+enum class MatrixElementType : std::uint32_t {
+  float32 = 1,
+  float64 = 2,
+  float16 = 3,
+  bfloat16 = 4
+};
+
+struct MatrixFileHeader {
+  static constexpr char expectedMagic[8] = {'M', 'C', 'P', 'P',
+                                            'M', 'A', 'T', '\0'};
+  static constexpr std::uint32_t currentVersion = 1;
+  // reads back as something else if the file comes from the other byte order
+  static constexpr std::uint32_t expectedByteOrder = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  MatrixElementType elementType;
+  std::uint32_t elementSize;
+  std::uint64_t width, height;
+  // elements between the starts of consecutive rows in the file
+  std::uint64_t stride;
+  // bytes from the start of the file to the first element, a multiple of
+  // `alignment`
+  std::uint64_t dataOffset;
+  std::uint64_t alignment;
+};
+
+static_assert(sizeof(MatrixFileHeader) == memory::cacheLineSize &&
+              std::is_trivially_copyable_v<MatrixFileHeader>);
+
+template <MatrixElement T> constexpr MatrixElementType matrixElementTypeOf() {
+  static_assert(std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                    std::is_same_v<T, Half> || std::is_same_v<T, BFloat16>,
+                "no file element type for T");
+  if constexpr (std::is_same_v<T, float>)
+    return MatrixElementType::float32;
+  else if constexpr (std::is_same_v<T, double>)
+    return MatrixElementType::float64;
+  else if constexpr (std::is_same_v<T, Half>)
+    return MatrixElementType::float16;
+  else
+    return MatrixElementType::bfloat16;
+}
+
+// checks a header read from somewhere of fileSize bytes against what a
+// matrix of T needs, throwing std::runtime_error if anything is off
+template <MatrixElement T>
+void validateMatrixFileHeader(const MatrixFileHeader &header,
+                              std::uint64_t fileSize) {
+  const auto fail = [](const char *reason) {
+    throw std::runtime_error(std::string("bad matrix file: ") + reason);
+  };
+  if (std::memcmp(header.magic, MatrixFileHeader::expectedMagic, 8) != 0)
+    fail("not a matrix file");
+  if (header.byteOrder != MatrixFileHeader::expectedByteOrder)
+    fail("written with the other byte order");
+  if (header.version != MatrixFileHeader::currentVersion)
+    fail("unsupported version");
+  if (header.elementType != matrixElementTypeOf<T>() ||
+      header.elementSize != sizeof(T))
+    fail("element type mismatch");
+  if (header.stride < header.width ||
+      header.dataOffset < sizeof(MatrixFileHeader) || header.alignment == 0 ||
+      header.dataOffset % header.alignment != 0 ||
+      header.dataOffset % alignof(T) != 0)
+    fail("inconsistent layout");
+  if (header.height != 0 && header.stride > UINT64_MAX / header.height)
+    fail("dimensions overflow");
+  const auto elements = header.height * header.stride;
+  if (fileSize < header.dataOffset ||
+      (fileSize - header.dataOffset) / sizeof(T) < elements)
+    fail("truncated");
+}
+
+// writes the header and the rows back to back, whatever the operand's stride
+template <DenseOperand M> void writeMatrix(std::ostream &out, const M &m) {
+  using T = ValueTypeOf<M>;
+  const auto view = constViewOf(m);
+  MatrixFileHeader header{};
+  std::memcpy(header.magic, MatrixFileHeader::expectedMagic, 8);
+  header.version = MatrixFileHeader::currentVersion;
+  header.byteOrder = MatrixFileHeader::expectedByteOrder;
+  header.elementType = matrixElementTypeOf<T>();
+  header.elementSize = sizeof(T);
+  header.width = view.width();
+  header.height = view.height();
+  header.stride = view.width();
+  header.dataOffset = sizeof(MatrixFileHeader);
+  header.alignment = memory::cacheLineSize;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  for (std::size_t i = 0; i < view.height(); ++i)
+    out.write(reinterpret_cast<const char *>(view.row(i).data()),
+              std::streamsize(view.width() * sizeof(T)));
+  if (!out)
+    throw std::runtime_error("couldn't write matrix");
+}
+
+template <DenseOperand M>
+void saveMatrix(const std::string &path, const M &m) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw std::system_error(errno, std::generic_category(), path);
+  writeMatrix(out, m);
+}
+
+// reads a whole file into a new matrix, the portable (and copying) way
+template <MatrixElement T> DMatrix<T> readMatrix(std::istream &in) {
+  MatrixFileHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    throw std::runtime_error("bad matrix file: truncated");
+  // the size check is done against the rows actually read below
+  validateMatrixFileHeader<T>(header, UINT64_MAX);
+  in.ignore(std::streamsize(header.dataOffset - sizeof(header)));
+  DMatrix<T> result(header.width, header.height);
+  for (std::size_t i = 0; i < header.height; ++i) {
+    in.read(reinterpret_cast<char *>(result.data() + i * result.stride()),
+            std::streamsize(header.width * sizeof(T)));
+    if (i + 1 < header.height)
+      in.ignore(std::streamsize((header.stride - header.width) * sizeof(T)));
+  }
+  if (!in)
+    throw std::runtime_error("bad matrix file: truncated");
+  return result;
+}
+
+enum class MapMode {
+  // the mapping is read-only, touching it through a mutable pointer faults
+  readOnly,
+  // writes go to private copies of the touched pages, the file never changes
+  copyOnWrite
+};
+
+// a matrix file mapped into memory. nothing is read up front, pages come in
+// as the elements are first touched. the elements are only reachable through
+// views, which must not outlive the mapping; copy one into a DMatrix to keep
+// the data around
+template <MatrixElement T> class MappedMatrix {
+public:
+  explicit MappedMatrix(const std::string &path,
+                        MapMode mode = MapMode::readOnly)
+      : mode_(mode) {
+    const auto descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+      throw std::system_error(errno, std::generic_category(), path);
+    struct stat status {};
+    if (::fstat(descriptor, &status) != 0) {
+      const auto error = errno;
+      ::close(descriptor);
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    length_ = std::size_t(status.st_size);
+    if (length_ < sizeof(MatrixFileHeader)) {
+      ::close(descriptor);
+      throw std::runtime_error("bad matrix file: truncated");
+    }
+    const auto protection =
+        mode == MapMode::readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    mapping_ =
+        ::mmap(nullptr, length_, protection, MAP_PRIVATE, descriptor, 0);
+    // the mapping keeps its own reference to the file
+    const auto error = errno;
+    ::close(descriptor);
+    if (mapping_ == MAP_FAILED) {
+      mapping_ = nullptr;
+      throw std::system_error(error, std::generic_category(), path);
+    }
+    const auto &header = *static_cast<const MatrixFileHeader *>(mapping_);
+    try {
+      validateMatrixFileHeader<T>(header, length_);
+    } catch (...) {
+      ::munmap(mapping_, length_);
+      throw;
+    }
+    width_ = header.width;
+    height_ = header.height;
+    stride_ = header.stride;
+    data_ = reinterpret_cast<T *>(static_cast<char *>(mapping_) +
+                                  header.dataOffset);
+  }
+
+  MappedMatrix(const MappedMatrix &) = delete;
+
+  MappedMatrix(MappedMatrix &&other) noexcept
+      : mode_(other.mode_), mapping_(std::exchange(other.mapping_, nullptr)),
+        length_(std::exchange(other.length_, 0)), width_(other.width_),
+        height_(other.height_), stride_(other.stride_),
+        data_(std::exchange(other.data_, nullptr)) {}
+
+  ~MappedMatrix() {
+    if (mapping_)
+      ::munmap(mapping_, length_);
+  }
+
+  MappedMatrix &operator=(const MappedMatrix &) = delete;
+
+  MappedMatrix &operator=(MappedMatrix &&other) noexcept {
+    if (this == &other)
+      goto skipMove;
+    if (mapping_)
+      ::munmap(mapping_, length_);
+    mode_ = other.mode_;
+    mapping_ = std::exchange(other.mapping_, nullptr);
+    length_ = std::exchange(other.length_, 0);
+    width_ = other.width_;
+    height_ = other.height_;
+    stride_ = other.stride_;
+    data_ = std::exchange(other.data_, nullptr);
+  skipMove:
+    return *this;
+  }
+
+  [[nodiscard]] MatrixView<const T> view() const {
+    return {data_, width_, height_, stride_};
+  }
+
+  // only copy-on-write mappings can be written to
+  [[nodiscard]] MatrixView<T> mutableView() {
+    if (mode_ != MapMode::copyOnWrite)
+      throw std::logic_error("matrix is mapped read-only");
+    return {data_, width_, height_, stride_};
+  }
+
+  [[nodiscard]] T operator()(std::size_t row, std::size_t column) const {
+    assert(row < height_ && column < width_);
+    return data_[row * stride_ + column];
+  }
+
+  [[nodiscard]] std::size_t width() const { return width_; }
+
+  [[nodiscard]] std::size_t height() const { return height_; }
+
+  [[nodiscard]] std::size_t stride() const { return stride_; }
+
+  [[nodiscard]] MapMode mode() const { return mode_; }
+
+private:
+  MapMode mode_;
+  void *mapping_ = nullptr;
+  std::size_t length_ = 0, width_ = 0, height_ = 0, stride_ = 0;
+  T *data_ = nullptr;
+};
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_MATRIX_IO_HPP
@@ -0,0 +1,163 @@
+#ifndef MODERN_CPP_INC_MATH_MATRIX_VIEW_HPP
+#define MODERN_CPP_INC_MATH_MATRIX_VIEW_HPP
+
+#include "math/kernels/gemm.hpp"
+#include "math/kernels/gemv.hpp"
+#include "math/matrix_expression.hpp"
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+namespace mcpp::math {
+
+// non-owning window onto row-major storage: a width x height block whose rows
+// start stride elements apart. submatrices, rows and columns of a matrix are
+// all views over its buffer, so blocked algorithms can work on pieces without
+// copying them out. MatrixView<const T> is the read-only flavour.
+// like any reference, a view must not outlive the storage it points into.
+// assigning to a view writes through to the elements, it never rebinds
+template <typename T> class MatrixView {
+public:
+  using ValueType = std::remove_const_t<T>;
+
+  MatrixView(T *data, std::size_t width, std::size_t height,
+             std::size_t stride)
+      : data_(data), width_(width), height_(height), stride_(stride) {
+    assert(stride >= width || height <= 1);
+  }
+
+  MatrixView(const MatrixView &) = default;
+
+  // a whole matrix
+  template <std::size_t w, std::size_t h>
+  MatrixView(Matrix<ValueType, w, h> &m)
+      : MatrixView(m.data(), m.width(), m.height(), m.stride()) {}
+
+  template <std::size_t w, std::size_t h>
+    requires std::is_const_v<T>
+  MatrixView(const Matrix<ValueType, w, h> &m)
+      : MatrixView(m.data(), m.width(), m.height(), m.stride()) {}
+
+  MatrixView(const MatrixView<ValueType> &other)
+    requires std::is_const_v<T>
+      : MatrixView(other.data(), other.width(), other.height(),
+                   other.stride()) {}
+
+  MatrixView &operator=(const MatrixView &other)
+    requires(!std::is_const_v<T>)
+  {
+    assignExpression(data_, stride_, asExpression(other));
+    return *this;
+  }
+
+  template <MatrixOperand E>
+    requires(!std::is_const_v<T>)
+  MatrixView &operator=(const E &e) {
+    assert(e.width() == width_ && e.height() == height_);
+    assignExpression(data_, stride_, asExpression(e));
+    return *this;
+  }
+
+  template <MatrixOperand E>
+    requires(!std::is_const_v<T>)
+  MatrixView &operator+=(const E &e) {
+    return *this = *this + e;
+  }
+
+  template <MatrixOperand E>
+    requires(!std::is_const_v<T>)
+  MatrixView &operator-=(const E &e) {
+    return *this = *this - e;
+  }
+
+  MatrixView &operator*=(ValueType scalar)
+    requires(!std::is_const_v<T>)
+  {
+    return *this = *this * scalar;
+  }
+
+  MatrixView &operator/=(ValueType scalar)
+    requires(!std::is_const_v<T>)
+  {
+    return *this = *this / scalar;
+  }
+
+  T &operator()(std::size_t row, std::size_t column) const {
+    assert(row < height_ && column < width_);
+    return data_[row * stride_ + column];
+  }
+
+  // width x height piece whose top-left corner is at (row, column)
+  [[nodiscard]] MatrixView block(std::size_t row, std::size_t column,
+                                 std::size_t width,
+                                 std::size_t height) const {
+    assert(row + height <= height_ && column + width <= width_);
+    return {data_ + row * stride_ + column, width, height, stride_};
+  }
+
+  [[nodiscard]] MatrixView row(std::size_t index) const {
+    return block(index, 0, width_, 1);
+  }
+
+  [[nodiscard]] MatrixView column(std::size_t index) const {
+    return block(0, index, 1, height_);
+  }
+
+  [[nodiscard]] std::size_t width() const { return width_; }
+  [[nodiscard]] std::size_t height() const { return height_; }
+  [[nodiscard]] std::size_t stride() const { return stride_; }
+  [[nodiscard]] T *data() const { return data_; }
+  [[nodiscard]] bool contiguous() const {
+    return stride_ == width_ || height_ <= 1;
+  }
+
+private:
+  T *data_;
+  std::size_t width_, height_, stride_;
+};
+
+template <MatrixElement T, std::size_t w, std::size_t h>
+MatrixView(Matrix<T, w, h> &) -> MatrixView<T>;
+
+template <MatrixElement T, std::size_t w, std::size_t h>
+MatrixView(const Matrix<T, w, h> &) -> MatrixView<const T>;
+
+template <typename T> struct IsMatrixView<MatrixView<T>> {
+  static constexpr const bool value = true;
+};
+
+template <typename T>
+MatrixReference<std::remove_const_t<T>, 0, 0>
+asExpression(const MatrixView<T> &view) {
+  return {view.data(), view.width(), view.height(), view.stride()};
+}
+
+// read-only view of anything dense, matrices and views alike
+template <DenseOperand E>
+MatrixView<const ValueTypeOf<E>> constViewOf(const E &e) {
+  if constexpr (IsMatrixViewV<E>)
+    return e;
+  else
+    return {e.data(), e.width(), e.height(), e.stride()};
+}
+
+// products with a view on either side go straight to the gemm kernel, which
+// takes the strides as they are
+template <DenseOperand L, DenseOperand R>
+  requires(IsMatrixViewV<L> || IsMatrixViewV<R>)
+[[nodiscard]] Matrix<ValueTypeOf<L>, 0, 0> operator*(const L &lhs,
+                                                      const R &rhs) {
+  using T = ValueTypeOf<L>;
+  const auto a = constViewOf(lhs);
+  const auto b = constViewOf(rhs);
+  assert(a.width() == b.height());
+  Matrix<T, 0, 0> result(b.width(), a.height());
+  kernels::product(a.height(), b.width(), a.width(), a.data(), a.stride(),
+                   b.data(), b.stride(), result.data(), result.stride());
+  return result;
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_MATRIX_VIEW_HPP
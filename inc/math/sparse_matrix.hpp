@@ -0,0 +1,225 @@
+#ifndef MODERN_CPP_INC_MATH_SPARSE_MATRIX_HPP
+#define MODERN_CPP_INC_MATH_SPARSE_MATRIX_HPP
+
+#include "concurrency/thread_pool.hpp"
+#include "math/kernels/simd.hpp"
+#include "math/matrix.hpp"
+#include "math/matrix_view.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace mcpp::math {
+
+template <std::floating_point T> struct Triplet {
+  std::size_t row, column;
+  T value;
+};
+
+// compressed sparse row storage: the nonzeros of row i are values[k] at
+// column columns[k] for k in [rowOffsets[i], rowOffsets[i + 1]), sorted by
+// column. memory and product costs are proportional to the number of nonzeros
+// instead of width * height. built from triplets through SparseMatrixBuilder
+// or from a dense matrix
+template <std::floating_point T> class SparseMatrix {
+public:
+  using ValueType = T;
+
+  // all zeros
+  SparseMatrix(std::size_t width, std::size_t height)
+      : width_(width), height_(height), rowOffsets_(height + 1) {}
+
+  // keeps the elements whose magnitude is above tolerance
+  template <DenseOperand M>
+  explicit SparseMatrix(const M &dense, T tolerance = T())
+      : SparseMatrix(dense.width(), dense.height()) {
+    const auto view = constViewOf(dense);
+    for (std::size_t i = 0; i < height_; ++i) {
+      for (std::size_t j = 0; j < width_; ++j)
+        if (std::abs(view(i, j)) > tolerance) {
+          columns_.push_back(j);
+          values_.push_back(view(i, j));
+        }
+      rowOffsets_[i + 1] = values_.size();
+    }
+  }
+
+  [[nodiscard]] DMatrix<T> toDense() const {
+    DMatrix<T> result(width_, height_);
+    for (std::size_t i = 0; i < height_; ++i) {
+      std::fill_n(result.data() + i * result.stride(), width_, T());
+      for (auto k = rowOffsets_[i]; k < rowOffsets_[i + 1]; ++k)
+        result(i, columns_[k]) = values_[k];
+    }
+    return result;
+  }
+
+  // zero if the element isn't stored, found by binary search within the row
+  [[nodiscard]] T operator()(std::size_t row, std::size_t column) const {
+    assert(row < height_ && column < width_);
+    const auto first = columns_.begin() + rowOffsets_[row],
+               last = columns_.begin() + rowOffsets_[row + 1];
+    const auto found = std::lower_bound(first, last, column);
+    return found != last && *found == column
+               ? values_[std::size_t(found - columns_.begin())]
+               : T();
+  }
+
+  // counting sort by column, O(nonzeros + width). rows come out sorted because
+  // the source is walked in row order
+  [[nodiscard]] SparseMatrix transposed() const {
+    SparseMatrix result(height_, width_);
+    result.columns_.resize(values_.size());
+    result.values_.resize(values_.size());
+    for (const auto column : columns_)
+      ++result.rowOffsets_[column + 1];
+    std::partial_sum(result.rowOffsets_.begin(), result.rowOffsets_.end(),
+                     result.rowOffsets_.begin());
+    auto next = result.rowOffsets_;
+    for (std::size_t i = 0; i < height_; ++i)
+      for (auto k = rowOffsets_[i]; k < rowOffsets_[i + 1]; ++k) {
+        const auto to = next[columns_[k]]++;
+        result.columns_[to] = i;
+        result.values_[to] = values_[k];
+      }
+    return result;
+  }
+
+  // this * dense, dense being a column vector, a DMatrix, a fixed-size matrix
+  // or a view of any of them. rows of the result are split into tasks of
+  // about the same number of nonzeros, fixed regardless of the pool's size,
+  // so results are identical for any thread count
+  template <DenseOperand M>
+  [[nodiscard]] DMatrix<T>
+  multiply(const M &dense,
+           concurrency::ThreadPool &pool = concurrency::defaultThreadPool())
+      const {
+    const auto b = constViewOf(dense);
+    assert(b.height() == width_);
+    DMatrix<T> result(b.width(), height_);
+    const auto c = result.view();
+    const auto &kernels = kernels::simdKernels<T>();
+    const auto rows = [&](std::size_t first, std::size_t last) {
+      for (auto i = first; i < last; ++i) {
+        const auto out = c.row(i).data();
+        if (b.width() == 1) {
+          // sparse times vector, a gather and a dot
+          T sum = T();
+          for (auto k = rowOffsets_[i]; k < rowOffsets_[i + 1]; ++k)
+            sum += values_[k] * b(columns_[k], 0);
+          *out = sum;
+        } else {
+          std::fill_n(out, b.width(), T());
+          for (auto k = rowOffsets_[i]; k < rowOffsets_[i + 1]; ++k)
+            kernels.axpy(b.width(), values_[k], b.row(columns_[k]).data(),
+                         out);
+        }
+      }
+    };
+
+    const auto work = values_.size() * b.width();
+    if (work < parallelGrain_) {
+      rows(0, height_);
+      return result;
+    }
+    // task t gets the rows whose nonzeros start in its share of them
+    const auto perTask = std::max<std::size_t>(parallelGrain_ / b.width(), 1);
+    const auto tasks = (values_.size() + perTask - 1) / perTask;
+    const auto firstRow = [&](std::size_t task) {
+      if (task >= tasks)
+        return height_;
+      return std::size_t(std::lower_bound(rowOffsets_.begin(),
+                                          rowOffsets_.end() - 1,
+                                          task * perTask) -
+                         rowOffsets_.begin());
+    };
+    pool.parallelFor(tasks, [&](std::size_t task) {
+      rows(firstRow(task), firstRow(task + 1));
+    });
+    return result;
+  }
+
+  [[nodiscard]] std::size_t width() const { return width_; }
+
+  [[nodiscard]] std::size_t height() const { return height_; }
+
+  [[nodiscard]] std::size_t nonZeros() const { return values_.size(); }
+
+  [[nodiscard]] const std::vector<std::size_t> &rowOffsets() const {
+    return rowOffsets_;
+  }
+
+  [[nodiscard]] const std::vector<std::size_t> &columns() const {
+    return columns_;
+  }
+
+  [[nodiscard]] const std::vector<T> &values() const { return values_; }
+
+private:
+  // multiply-adds below which a product isn't worth splitting up
+  static constexpr std::size_t parallelGrain_ = 1 << 15;
+
+  std::size_t width_, height_;
+  std::vector<std::size_t> rowOffsets_, columns_;
+  std::vector<T> values_;
+
+  template <std::floating_point> friend class SparseMatrixBuilder;
+};
+
+// collects (row, column, value) triplets in any order. build() sorts them
+// into a SparseMatrix, summing duplicates, which is the usual way of
+// assembling finite element style systems
+template <std::floating_point T> class SparseMatrixBuilder {
+public:
+  SparseMatrixBuilder(std::size_t width, std::size_t height)
+      : width_(width), height_(height) {}
+
+  void add(std::size_t row, std::size_t column, T value) {
+    assert(row < height_ && column < width_);
+    triplets_.push_back({row, column, value});
+  }
+
+  void reserve(std::size_t count) { triplets_.reserve(count); }
+
+  [[nodiscard]] SparseMatrix<T> build() const {
+    auto sorted = triplets_;
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+      return a.row != b.row ? a.row < b.row : a.column < b.column;
+    });
+    SparseMatrix<T> result(width_, height_);
+    for (std::size_t k = 0; k < sorted.size();) {
+      const auto &first = sorted[k];
+      T sum = T();
+      for (; k < sorted.size() && sorted[k].row == first.row &&
+             sorted[k].column == first.column;
+           ++k)
+        sum += sorted[k].value;
+      result.columns_.push_back(first.column);
+      result.values_.push_back(sum);
+      ++result.rowOffsets_[first.row + 1];
+    }
+    std::partial_sum(result.rowOffsets_.begin(), result.rowOffsets_.end(),
+                     result.rowOffsets_.begin());
+    return result;
+  }
+
+private:
+  std::size_t width_, height_;
+  std::vector<Triplet<T>> triplets_;
+};
+
+// sparse * dense with the default pool, see SparseMatrix::multiply
+template <std::floating_point T, DenseOperand M>
+  requires std::same_as<ValueTypeOf<M>, T>
+[[nodiscard]] DMatrix<T> operator*(const SparseMatrix<T> &a, const M &b) {
+  return a.multiply(b);
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_SPARSE_MATRIX_HPP
@@ -1,7 +1,15 @@
 #ifndef MODERN_CPP_INC_MATH_STATIC_MATRIX_HPP
 #define MODERN_CPP_INC_MATH_STATIC_MATRIX_HPP
 
+#include "math/kernels/gemv.hpp"
+#include "math/kernels/reduce.hpp"
+#include "math/kernels/simd.hpp"
+#include "math/kernels/transpose.hpp"
+#include "math/matrix_expression.hpp"
+#include "math/matrix_view.hpp"
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <concepts>
@@ -10,88 +18,128 @@
 #include <iostream>
 #include <numeric>
 #include <type_traits>
+#include <utility>
 
 namespace mcpp::math {
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+// elements live inline, so fixed-size matrices never touch the heap and are
+// trivially copyable. storage is aligned to its own size rounded up to a power
+// of two (capped at 32 bytes), so an FVector4 or a row of an FMatrix4x4 is a
+// single aligned sse load and a DMatrix4x4 row an aligned avx one. everything
+// but length(), the reductions and the views is constexpr, so transforms built
+// from constants fold at compile time and tables of them can be constexpr
+// variables
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 class Matrix {
   using MatrixInitList = std::initializer_list<std::initializer_list<T>>;
 
 public:
   template <std::size_t w = width_, std::size_t h = height_>
-  [[maybe_unused]] static typename std::enable_if_t<w == h, Matrix> identity();
+  [[maybe_unused]] static constexpr typename std::enable_if_t<w == h, Matrix>
+  identity();
 
-  Matrix() = default;
-  Matrix(const Matrix &);
-  Matrix(Matrix &&) noexcept;
-  Matrix(const MatrixInitList &);
+  constexpr Matrix();
+  constexpr Matrix(const Matrix &) = default;
+  constexpr Matrix(Matrix &&) noexcept = default;
+  constexpr Matrix(const MatrixInitList &);
   // dummy int, constructs without initializing to zero
-  explicit Matrix(int);
+  constexpr explicit Matrix(int);
+  template <MatrixExpression E> constexpr Matrix(const E &);
 
-  ~Matrix();
+  constexpr ~Matrix() = default;
 
-  Matrix &operator=(const Matrix &);
-  Matrix &operator=(Matrix &&) noexcept;
-  Matrix &operator=(const MatrixInitList &);
+  constexpr Matrix &operator=(const Matrix &) = default;
+  constexpr Matrix &operator=(Matrix &&) noexcept = default;
+  constexpr Matrix &operator=(const MatrixInitList &);
+  template <MatrixExpression E> constexpr Matrix &operator=(const E &);
 
-  [[nodiscard]] bool operator==(const Matrix &) const;
-  [[nodiscard]] bool operator!=(const Matrix &) const;
+  [[nodiscard]] constexpr bool operator==(const Matrix &) const;
+  [[nodiscard]] constexpr bool operator!=(const Matrix &) const;
 
-  [[nodiscard]] Matrix operator-() const;
-
-  [[nodiscard]] Matrix operator+(const Matrix &) const;
-  [[nodiscard]] Matrix operator-(const Matrix &) const;
-  [[nodiscard]] Matrix operator*(T) const;
-  [[nodiscard]] Matrix operator/(T) const;
+  // +, -, unary - and scalar * / are lazy, see math/matrix_expression.hpp
 
   template <std::size_t otherWidth>
-  [[nodiscard]] Matrix<T, otherWidth, height_>
+  [[nodiscard]] constexpr Matrix<T, otherWidth, height_>
   operator*(const Matrix<T, otherWidth, width_> &) const;
 
   template <std::size_t w = width_, std::size_t h = height_>
-  [[nodiscard]] typename std::enable_if_t<w == 1 || h == 1, T>
+  [[nodiscard]] constexpr typename std::enable_if_t<w == 1 || h == 1, T>
   dot(const Matrix &) const;
 
   template <std::size_t w = width_, std::size_t h = height_>
   [[nodiscard]] [[maybe_unused]]
-  typename std::enable_if_t<(w == 1 && h == 3) || (h == 1 && w == 3),
-                            Matrix<T, w, h>>
+  constexpr typename std::enable_if_t<(w == 1 && h == 3) || (h == 1 && w == 3),
+                                      Matrix<T, w, h>>
   cross(const Matrix &) const;
 
   template <std::size_t w = width_, std::size_t h = height_>
   [[nodiscard]] [[maybe_unused]] typename std::enable_if_t<w == 1 || h == 1, T>
   length() const;
 
-  Matrix &operator+=(const Matrix &) const;
-  Matrix &operator-=(const Matrix &) const;
-  Matrix &operator*=(T) const;
-  Matrix &operator/=(T) const;
-
-  T &operator()(std::size_t, std::size_t);
-  [[nodiscard]] T operator()(std::size_t, std::size_t) const;
+  // reductions, see math/kernels/reduce.hpp. norm is the frobenius norm,
+  // normL1 and normInf the largest column and row sums of magnitudes
+  [[nodiscard]] T sum(Summation = Summation::pairwise) const;
+  [[nodiscard]] T norm(Summation = Summation::pairwise) const;
+  [[nodiscard]] T normL1(Summation = Summation::pairwise) const;
+  [[nodiscard]] T normInf(Summation = Summation::pairwise) const;
+  [[nodiscard]] T min() const;
+  [[nodiscard]] T max() const;
+  // first position of the extreme in row-major order
+  [[nodiscard]] MatrixIndex argmin() const;
+  [[nodiscard]] MatrixIndex argmax() const;
+  // one result per row as a column vector, one per column as a row vector
+  [[nodiscard]] Matrix<T, 1, height_>
+  rowwise(Reduction, Summation = Summation::pairwise) const;
+  [[nodiscard]] Matrix<T, width_, 1>
+  columnwise(Reduction, Summation = Summation::pairwise) const;
+
+  // these update in place, see also math/blas.hpp
+  constexpr Matrix &operator+=(const Matrix &);
+  constexpr Matrix &operator-=(const Matrix &);
+  constexpr Matrix &operator*=(T);
+  constexpr Matrix &operator/=(T);
+
+  constexpr T &operator()(std::size_t, std::size_t);
+  [[nodiscard]] constexpr T operator()(std::size_t, std::size_t) const;
 
   template <std::size_t w = width_, std::size_t h = height_>
-  [[nodiscard]] std::enable_if_t<w == 1 || h == 1, T>
+  [[nodiscard]] constexpr std::enable_if_t<w == 1 || h == 1, T>
   operator()(std::size_t) const;
 
-  [[nodiscard]] Matrix<T, height_, width_> transposed() const;
-  [[maybe_unused]] typename std::enable_if_t<width_ == height_, void>
+  [[nodiscard]] constexpr Matrix<T, height_, width_> transposed() const;
+  template <std::size_t w = width_, std::size_t h = height_>
+  [[maybe_unused]] constexpr typename std::enable_if_t<w == h, void>
   transpose();
 
-  [[nodiscard]] std::size_t width() const;
-  [[nodiscard]] std::size_t height() const;
+  [[nodiscard]] constexpr std::size_t width() const;
+  [[nodiscard]] constexpr std::size_t height() const;
+  // fixed-size matrices are never padded, rows follow each other directly
+  [[nodiscard]] constexpr std::size_t stride() const;
 
   template <std::size_t w = width_, std::size_t h = height_>
-  [[nodiscard]] [[maybe_unused]] typename std::enable_if_t<w == h, std::size_t>
-  order() const;
+  [[nodiscard]] [[maybe_unused]] constexpr
+      typename std::enable_if_t<w == h, std::size_t>
+      order() const;
+
+  [[nodiscard]] constexpr const T *begin() const;
+  [[nodiscard]] constexpr const T *end() const;
+  [[nodiscard]] constexpr T *begin();
+  [[nodiscard]] constexpr T *end();
+
+  [[nodiscard]] constexpr const T *data() const;
+  [[nodiscard]] constexpr T *data();
 
-  [[nodiscard]] const T *begin() const;
-  [[nodiscard]] const T *end() const;
+  [[nodiscard]] MatrixView<T> view();
+  [[nodiscard]] MatrixView<const T> view() const;
 
 private:
-  T *data_ = new T[width_ * height_]{};
+  static constexpr auto alignment_ =
+      std::min(std::bit_ceil(sizeof(T) * width_ * height_), std::size_t(32));
+
+  alignas(alignment_) T data_[width_ * height_];
 
   friend Matrix<T, 0, 0>;
+  template <MatrixElement, std::size_t, std::size_t> friend class Matrix;
 };
 
 // aliases
@@ -102,7 +150,7 @@ using FMatrix = Matrix<float, width, height>;
 using FMatrix3x3 [[maybe_unused]] = FMatrix<3, 3>;
 using FMatrix4x4 [[maybe_unused]] = FMatrix<4, 4>;
 
-template <std::floating_point T, std::size_t dim>
+template <MatrixElement T, std::size_t dim>
 using Vector = Matrix<T, 1, dim>;
 
 template <std::size_t dim> using FVector = Vector<float, dim>;
@@ -110,7 +158,7 @@ template <std::size_t dim> using FVector = Vector<float, dim>;
 using FVector3 [[maybe_unused]] = FVector<3>;
 using FVector4 [[maybe_unused]] = FVector<4>;
 
-template <std::floating_point T, std::size_t dim>
+template <MatrixElement T, std::size_t dim>
 using RowVector = Matrix<T, dim, 1>;
 
 template <std::size_t dim> using FRowVector = RowVector<float, dim>;
@@ -118,31 +166,29 @@ template <std::size_t dim> using FRowVector = RowVector<float, dim>;
 using FRowVector3 [[maybe_unused]] = FRowVector<3>;
 using FRowVector4 [[maybe_unused]] = FRowVector<4>;
 
+static_assert(std::is_trivially_copyable_v<FMatrix4x4> &&
+              sizeof(FMatrix4x4) == 16 * sizeof(float));
+
 // implementation
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t w, std::size_t h>
-[[maybe_unused]] typename std::enable_if_t<w == h, Matrix<T, width_, height_>>
-Matrix<T, width_, height_>::identity() {
+[[maybe_unused]] constexpr
+    typename std::enable_if_t<w == h, Matrix<T, width_, height_>>
+    Matrix<T, width_, height_>::identity() {
   Matrix result;
   for (std::size_t i = 0; i < w; ++i)
     result(i, i) = 1;
   return result;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>::Matrix(const Matrix &other) : Matrix(1) {
-  std::copy_n(other.data_, width_ * height_, data_);
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>::Matrix(Matrix &&other) noexcept
-    : data_(other.data_) {
-  other.data_ = nullptr;
-}
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_>::Matrix() : data_() {}
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>::Matrix(const Matrix::MatrixInitList &initList) {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_>::Matrix(
+    const Matrix::MatrixInitList &initList)
+    : Matrix() {
   // I'd love to do this with a static_assert, if only there was a way
   assert(initList.size() == height_ && initList.begin()->size() == width_);
   for (std::size_t i = 0; i < initList.size(); ++i)
@@ -150,38 +196,17 @@ Matrix<T, width_, height_>::Matrix(const Matrix::MatrixInitList &initList) {
       operator()(i, j) = *((initList.begin() + i)->begin() + j);
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>::Matrix(int) : data_(new T[width_ * height_]) {}
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_>::Matrix(int) {}
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>::~Matrix() {
-  delete[] data_;
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+template <MatrixExpression E>
+constexpr Matrix<T, width_, height_>::Matrix(const E &e) : Matrix(1) {
+  operator=(e);
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
-Matrix<T, width_, height_>::operator=(const Matrix &other) {
-  if (this == &other)
-    goto skipCopy;
-  std::copy_n(other.data_, width_ * height_, data_);
-skipCopy:
-  return *this;
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
-Matrix<T, width_, height_>::operator=(Matrix &&other) noexcept {
-  if (this == &other)
-    goto skipMove;
-  delete[] data_;
-  data_ = other.data_;
-  other.data_ = nullptr;
-skipMove:
-  return *this;
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_> &
 Matrix<T, width_, height_>::operator=(const Matrix::MatrixInitList &initList) {
   static_assert(initList.size() == height_ && initList[0].size() == width_);
   for (std::size_t i = 0; i < initList.size(); ++i)
@@ -189,66 +214,62 @@ Matrix<T, width_, height_>::operator=(const Matrix::MatrixInitList &initList) {
       operator()(i, j) = initList[i][j];
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-bool Matrix<T, width_, height_>::operator==(const Matrix &other) const {
-  return std::equal(data_, data_ + width_ * height_, other.data_);
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-bool Matrix<T, width_, height_>::operator!=(const Matrix &other) const {
-  return !operator==(other);
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> Matrix<T, width_, height_>::operator-() const {
-  return *this * T(-1);
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>
-Matrix<T, width_, height_>::operator+(const Matrix &other) const {
-  Matrix result(1);
-  std::transform(data_, data_ + width_ * height_, other.data_, result.data_,
-                 std::plus());
-  return result;
-}
-
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>
-Matrix<T, width_, height_>::operator-(const Matrix &other) const {
-  return *this + -other;
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+template <MatrixExpression E>
+constexpr Matrix<T, width_, height_> &
+Matrix<T, width_, height_>::operator=(const E &e) {
+  static_assert((E::staticWidth == 0 || E::staticWidth == width_) &&
+                (E::staticHeight == 0 || E::staticHeight == height_));
+  assert(e.width() == width_ && e.height() == height_);
+  assignExpression(data_, width_, e);
+  return *this;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>
-Matrix<T, width_, height_>::operator*(T scalar) const {
-  Matrix result(1);
-  std::transform(data_, data_ + width_ * height_, result.data_,
-                 [scalar](T element) { return scalar * element; });
-  return result;
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr bool
+Matrix<T, width_, height_>::operator==(const Matrix &other) const {
+  // the kernels can't run in constant expressions, those take the plain loop
+  if constexpr (width_ * height_ >= kernels::simdDispatchThreshold)
+    if (!std::is_constant_evaluated())
+      return kernels::simdKernels<T>().equal(width_ * height_, data_,
+                                             other.data_);
+  return std::equal(data_, data_ + width_ * height_, other.data_);
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_>
-Matrix<T, width_, height_>::operator/(T scalar) const {
-  return *this * (T(1) / scalar);
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr bool
+Matrix<T, width_, height_>::operator!=(const Matrix &other) const {
+  return !operator==(other);
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t otherWidth>
-Matrix<T, otherWidth, height_> Matrix<T, width_, height_>::operator*(
+constexpr Matrix<T, otherWidth, height_> Matrix<T, width_, height_>::operator*(
     const Matrix<T, otherWidth, width_> &other) const {
+  // big enough matrix-vector products stream through the gemv kernels
+  if constexpr (std::floating_point<T> &&
+                width_ * height_ >= kernels::simdDispatchThreshold &&
+                (otherWidth == 1 || height_ == 1))
+    if (!std::is_constant_evaluated()) {
+      Matrix<T, otherWidth, height_> result(1);
+      kernels::product(height_, otherWidth, width_, data_, width_,
+                       other.data_, otherWidth, result.data_, otherWidth);
+      return result;
+    }
   Matrix<T, otherWidth, height_> result;
   for (std::size_t i = 0; i < height_; ++i)
-    for (std::size_t j = 0; j < otherWidth; ++j)
+    for (std::size_t j = 0; j < otherWidth; ++j) {
+      AccumulatorOf<T> sum = AccumulatorOf<T>();
       for (std::size_t k = 0; k < width_; ++k)
-        result(i, j) += operator()(i, k) * other(k, j);
+        sum += operator()(i, k) * other(k, j);
+      result(i, j) = sum;
+    }
   return result;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t w, std::size_t h>
-typename std::enable_if_t<w == 1 || h == 1, T>
+constexpr typename std::enable_if_t<w == 1 || h == 1, T>
 Matrix<T, width_, height_>::dot(const Matrix &other) const {
   // if constexpr (w == 1) {
   //   const Matrix<T, height_, width_> &t = transposed();
@@ -257,62 +278,146 @@ Matrix<T, width_, height_>::dot(const Matrix &other) const {
   // } else {
   //   return std::inner_product(data_, data_ + w, other.data_, T());
   // }
-  return std::inner_product(data_, data_ + w * h, other.data_, T());
+  if constexpr (w * h >= kernels::simdDispatchThreshold)
+    if (!std::is_constant_evaluated())
+      return kernels::simdKernels<T>().dot(w * h, data_, other.data_);
+  return std::inner_product(data_, data_ + w * h, other.data_,
+                            AccumulatorOf<T>());
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t w, std::size_t h>
-typename std::enable_if_t<(w == 1 && h == 3) || (h == 1 && w == 3),
-                          Matrix<T, w, h>>
-Matrix<T, width_, height_>::cross(const Matrix &other [[maybe_unused]]) const {
-  // TODO: cross product of two vectors
+constexpr typename std::enable_if_t<(w == 1 && h == 3) || (h == 1 && w == 3),
+                                    Matrix<T, w, h>>
+Matrix<T, width_, height_>::cross(const Matrix &other) const {
+  // row or column, the three components are contiguous either way
+  Matrix result(0);
+  result.data_[0] = data_[1] * other.data_[2] - data_[2] * other.data_[1];
+  result.data_[1] = data_[2] * other.data_[0] - data_[0] * other.data_[2];
+  result.data_[2] = data_[0] * other.data_[1] - data_[1] * other.data_[0];
+  return result;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t w, std::size_t h>
 typename std::enable_if_t<w == 1 || h == 1, T>
 Matrix<T, width_, height_>::length() const {
   return std::sqrt(dot(*this));
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
-Matrix<T, width_, height_>::operator+=(const Matrix &other) const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+T Matrix<T, width_, height_>::sum(Summation summation) const {
+  return kernels::reduceMatrix(Reduction::sum, summation, data_, width_,
+                               height_, width_);
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+T Matrix<T, width_, height_>::norm(Summation summation) const {
+  return std::sqrt(kernels::reduceMatrix(Reduction::sumSquares, summation,
+                                         data_, width_, height_, width_));
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+T Matrix<T, width_, height_>::normL1(Summation summation) const {
+  std::array<AccumulatorOf<T>, width_> sums;
+  kernels::reduceColumns(Reduction::sumAbs, summation, data_, width_, height_,
+                         width_, sums.data());
+  return *std::max_element(sums.begin(), sums.end());
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+T Matrix<T, width_, height_>::normInf(Summation summation) const {
+  std::array<AccumulatorOf<T>, height_> sums;
+  kernels::reduceRows(Reduction::sumAbs, summation, data_, width_, height_,
+                      width_, sums.data());
+  return *std::max_element(sums.begin(), sums.end());
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+T Matrix<T, width_, height_>::min() const {
+  return kernels::reduceMatrix(Reduction::min, Summation::plain, data_,
+                               width_, height_, width_);
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+T Matrix<T, width_, height_>::max() const {
+  return kernels::reduceMatrix(Reduction::max, Summation::plain, data_,
+                               width_, height_, width_);
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+MatrixIndex Matrix<T, width_, height_>::argmin() const {
+  return kernels::findElement(data_, width_, height_, width_, min());
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+MatrixIndex Matrix<T, width_, height_>::argmax() const {
+  return kernels::findElement(data_, width_, height_, width_, max());
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+Matrix<T, 1, height_>
+Matrix<T, width_, height_>::rowwise(Reduction kind,
+                                    Summation summation) const {
+  std::array<AccumulatorOf<T>, height_> results;
+  kernels::reduceRows(kind, summation, data_, width_, height_, width_,
+                      results.data());
+  Matrix<T, 1, height_> result(0);
+  std::copy(results.begin(), results.end(), result.data_);
+  return result;
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+Matrix<T, width_, 1>
+Matrix<T, width_, height_>::columnwise(Reduction kind,
+                                       Summation summation) const {
+  std::array<AccumulatorOf<T>, width_> results;
+  kernels::reduceColumns(kind, summation, data_, width_, height_, width_,
+                         results.data());
+  Matrix<T, width_, 1> result(0);
+  std::copy(results.begin(), results.end(), result.data_);
+  return result;
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_> &
+Matrix<T, width_, height_>::operator+=(const Matrix &other) {
   return *this = *this + other;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
-Matrix<T, width_, height_>::operator-=(const Matrix &other) const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_> &
+Matrix<T, width_, height_>::operator-=(const Matrix &other) {
   return *this = *this - other;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
-Matrix<T, width_, height_>::operator*=(T scalar) const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_> &
+Matrix<T, width_, height_>::operator*=(T scalar) {
   return *this = *this * scalar;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, width_, height_> &
-Matrix<T, width_, height_>::operator/=(T scalar) const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, width_, height_> &
+Matrix<T, width_, height_>::operator/=(T scalar) {
   return *this = *this / scalar;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-T &Matrix<T, width_, height_>::operator()(std::size_t row, std::size_t col) {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr T &Matrix<T, width_, height_>::operator()(std::size_t row,
+                                                  std::size_t col) {
   return data_[row * width_ + col];
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-T Matrix<T, width_, height_>::operator()(std::size_t row,
-                                         std::size_t col) const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr T Matrix<T, width_, height_>::operator()(std::size_t row,
+                                                   std::size_t col) const {
   return data_[row * width_ + col];
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t w, std::size_t h>
-std::enable_if_t<w == 1 || h == 1, T>
+constexpr std::enable_if_t<w == 1 || h == 1, T>
 Matrix<T, width_, height_>::operator()(std::size_t index) const {
   if constexpr (w == 1) {
     return data_[width_ * index];
@@ -321,63 +426,101 @@ Matrix<T, width_, height_>::operator()(std::size_t index) const {
   }
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-Matrix<T, height_, width_> Matrix<T, width_, height_>::transposed() const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr Matrix<T, height_, width_>
+Matrix<T, width_, height_>::transposed() const {
   Matrix<T, height_, width_> result(1);
+  if constexpr (width_ * height_ >= kernels::simdDispatchThreshold)
+    if (!std::is_constant_evaluated()) {
+      kernels::transpose(height_, width_, data_, width_, result.data_,
+                         height_);
+      return result;
+    }
   for (std::size_t i = 0; i < height_; ++i)
     for (std::size_t j = 0; j < width_; ++j)
       result(j, i) = operator()(i, j);
   return result;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-[[maybe_unused]] typename std::enable_if_t<width_ == height_, void>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+template <std::size_t w, std::size_t h>
+[[maybe_unused]] constexpr typename std::enable_if_t<w == h, void>
 Matrix<T, width_, height_>::transpose() {
-  *this = std::move(transposed());
+  if constexpr (width_ * height_ >= kernels::simdDispatchThreshold)
+    if (!std::is_constant_evaluated()) {
+      kernels::transposeInPlace(width_, data_, width_);
+      return;
+    }
+  for (std::size_t i = 0; i < height_; ++i)
+    for (std::size_t j = i + 1; j < width_; ++j)
+      std::swap(data_[i * width_ + j], data_[j * width_ + i]);
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-std::size_t Matrix<T, width_, height_>::width() const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr std::size_t Matrix<T, width_, height_>::width() const {
   return width_;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-std::size_t Matrix<T, width_, height_>::height() const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr std::size_t Matrix<T, width_, height_>::height() const {
   return height_;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr std::size_t Matrix<T, width_, height_>::stride() const {
+  return width_;
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
 template <std::size_t w, std::size_t h>
-typename std::enable_if_t<w == h, std::size_t>
+constexpr typename std::enable_if_t<w == h, std::size_t>
 Matrix<T, width_, height_>::order() const {
   return width_;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-const T *Matrix<T, width_, height_>::begin() const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr const T *Matrix<T, width_, height_>::begin() const {
   return data_;
 }
 
-template <std::floating_point T, std::size_t width_, std::size_t height_>
-const T *Matrix<T, width_, height_>::end() const {
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr const T *Matrix<T, width_, height_>::end() const {
   return data_ + width_ * height_;
 }
 
-// non-member stuff
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr T *Matrix<T, width_, height_>::begin() {
+  return data_;
+}
 
-template <std::floating_point T, std::size_t width, std::size_t height>
-Matrix<T, width, height> operator*(T scalar,
-                                   const Matrix<T, width, height> &m) {
-  return m * scalar;
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr T *Matrix<T, width_, height_>::end() {
+  return data_ + width_ * height_;
 }
 
-template <std::floating_point T, std::size_t width, std::size_t height>
-Matrix<T, width, height> operator/(T scalar,
-                                   const Matrix<T, width, height> &m) {
-  return m / scalar;
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr const T *Matrix<T, width_, height_>::data() const {
+  return data_;
 }
 
-template <std::floating_point T, std::size_t width, std::size_t height>
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+constexpr T *Matrix<T, width_, height_>::data() {
+  return data_;
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+MatrixView<T> Matrix<T, width_, height_>::view() {
+  return *this;
+}
+
+template <MatrixElement T, std::size_t width_, std::size_t height_>
+MatrixView<const T> Matrix<T, width_, height_>::view() const {
+  return *this;
+}
+
+// non-member stuff
+
+template <MatrixElement T, std::size_t width, std::size_t height>
 std::ostream &operator<<(std::ostream &os, const Matrix<T, width, height> &m) {
   for (std::size_t i = 0; i < height; ++i) {
     for (std::size_t j = 0; j < width; ++j)
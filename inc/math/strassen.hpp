@@ -0,0 +1,127 @@
+#ifndef MODERN_CPP_INC_MATH_STRASSEN_HPP
+#define MODERN_CPP_INC_MATH_STRASSEN_HPP
+
+#include "math/kernels/strassen.hpp"
+#include "math/matrix.hpp"
+#include "math/matrix_view.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+// strassen-winograd products for large dynamic matrices, o(n^2.81) instead of
+// o(n^3). the savings come with a weaker error bound than the classical
+// product's (errors are relative to the largest elements of the operands, not
+// to each dot product), so it's opt-in per call site: see strassenErrorBound
+
+namespace mcpp::math {
+
+struct StrassenOptions {
+  // recursion stops once any dimension would drop below this, the rest is
+  // done by the classical kernel. lower values save multiplications but pay
+  // for it in additions, memory traffic and accuracy
+  std::size_t cutoff = 512;
+};
+
+// halvings needed until the smallest dimension reaches the cutoff
+inline std::size_t strassenLevels(std::size_t m, std::size_t n, std::size_t k,
+                                  const StrassenOptions &options = {}) {
+  std::size_t levels = 0;
+  for (auto smallest = std::min({m, n, k}); smallest / 2 >= options.cutoff;
+       smallest /= 2)
+    ++levels;
+  return levels;
+}
+
+// first-order bounds on max |c - computed c| for a * b, in the max-abs norm.
+// the classical one is n^2 u |a| |b|, the strassen-winograd one is
+// ((n0^2 + 6 n0) 18^l - 6 n) u |a| |b|, n0 = n / 2^l being the size the
+// classical kernel takes over at (higham, accuracy and stability of numerical
+// algorithms, section 23.2). both are worst cases, actual errors are usually
+// orders of magnitude smaller
+template <std::floating_point T> struct StrassenErrorBound {
+  std::size_t levels;
+  T strassen, classical;
+};
+
+template <DenseOperand L, DenseOperand R>
+[[nodiscard]] StrassenErrorBound<ValueTypeOf<L>>
+strassenErrorBound(const L &lhs, const R &rhs,
+                   const StrassenOptions &options = {}) {
+  using T = ValueTypeOf<L>;
+  const auto a = constViewOf(lhs), b = constViewOf(rhs);
+  const auto maxAbs = [](const MatrixView<const T> &v) {
+    T result = T();
+    for (std::size_t i = 0; i < v.height(); ++i)
+      for (std::size_t j = 0; j < v.width(); ++j)
+        result = std::max(result, std::abs(v(i, j)));
+    return result;
+  };
+  const auto levels = strassenLevels(a.height(), b.width(), a.width(), options);
+  const auto n = T(std::max({a.height(), b.width(), a.width()}));
+  const auto n0 = n / T(std::size_t(1) << levels);
+  const auto scale =
+      std::numeric_limits<T>::epsilon() / 2 * maxAbs(a) * maxAbs(b);
+  return {levels,
+          ((n0 * n0 + 6 * n0) * std::pow(T(18), T(levels)) - 6 * n) * scale,
+          n * n * scale};
+}
+
+// a * b through strassen-winograd. operands whose dimensions aren't divisible
+// by 2^levels are copied into zero-padded buffers first, which is cheap next
+// to the product. all the temporaries come from a single allocation shared by
+// every level of the recursion
+template <DenseOperand L, DenseOperand R>
+[[nodiscard]] DMatrix<ValueTypeOf<L>>
+strassenMultiply(const L &lhs, const R &rhs,
+                 const StrassenOptions &options = {}) {
+  using T = ValueTypeOf<L>;
+  const auto a = constViewOf(lhs), b = constViewOf(rhs);
+  assert(a.width() == b.height());
+  const auto m = a.height(), n = b.width(), k = a.width();
+  const auto levels = strassenLevels(m, n, k, options);
+  DMatrix<T> result(n, m);
+  if (levels == 0) {
+    kernels::gemm(m, n, k, T(1), a.data(), a.stride(), 1, b.data(),
+                  b.stride(), 1, T(), result.data(), result.stride());
+    return result;
+  }
+
+  const auto multiple = std::size_t(1) << levels;
+  const auto roundUp = [&](std::size_t d) {
+    return (d + multiple - 1) / multiple * multiple;
+  };
+  const auto pm = roundUp(m), pn = roundUp(n), pk = roundUp(k);
+  const auto padded = [](const MatrixView<const T> &v, std::size_t width,
+                         std::size_t height) {
+    DMatrix<T> copy(width, height);
+    for (std::size_t i = 0; i < height; ++i) {
+      const auto row = copy.data() + i * copy.stride();
+      if (i < v.height())
+        std::copy_n(v.row(i).data(), v.width(), row);
+      std::fill(row + (i < v.height() ? v.width() : 0), row + width, T());
+    }
+    return copy;
+  };
+
+  const kernels::PackBuffer<T> scratch(
+      kernels::strassenScratchSize(pm, pn, pk, levels));
+  if (pm == m && pn == n && pk == k) {
+    kernels::strassenGemm(m, n, k, a.data(), a.stride(), b.data(), b.stride(),
+                          result.data(), result.stride(), levels,
+                          scratch.get());
+  } else {
+    const auto pa = padded(a, pk, pm), pb = padded(b, pn, pk);
+    DMatrix<T> pc(pn, pm);
+    kernels::strassenGemm(pm, pn, pk, pa.data(), pa.stride(), pb.data(),
+                          pb.stride(), pc.data(), pc.stride(), levels,
+                          scratch.get());
+    result.view() = pc.view().block(0, 0, n, m);
+  }
+  return result;
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_STRASSEN_HPP
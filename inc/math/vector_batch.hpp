@@ -0,0 +1,179 @@
+#ifndef MODERN_CPP_INC_MATH_VECTOR_BATCH_HPP
+#define MODERN_CPP_INC_MATH_VECTOR_BATCH_HPP
+
+#include "math/kernels/batch.hpp"
+#include "math/static_matrix.hpp"
+#include "memory/aligned.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <initializer_list>
+#include <utility>
+
+namespace mcpp::math {
+
+// many 3d or 4d vectors stored structure-of-arrays: all x components, then all
+// y components and so on, each array starting on its own cache line. meant
+// for transforming whole sets of points at once, see transform() and friends
+// below. single vectors go in and out as Vector<T, dim>
+template <std::floating_point T, std::size_t dim> class VectorBatch {
+  static_assert(dim == 3 || dim == 4, "only 3d and 4d vectors are batched");
+
+public:
+  explicit VectorBatch(std::size_t size)
+      : size_(size), capacity_(paddedSize_(size)),
+        data_(memory::allocateAligned<T>(dim * capacity_)) {
+    std::fill_n(data_, dim * capacity_, T());
+  }
+
+  VectorBatch(std::initializer_list<Vector<T, dim>> vectors)
+      : VectorBatch(vectors.size()) {
+    std::size_t i = 0;
+    for (const auto &v : vectors)
+      set(i++, v);
+  }
+
+  VectorBatch(const VectorBatch &other)
+      : size_(other.size_), capacity_(other.capacity_),
+        data_(memory::allocateAligned<T>(dim * capacity_)) {
+    std::copy_n(other.data_, dim * capacity_, data_);
+  }
+
+  VectorBatch(VectorBatch &&other) noexcept
+      : size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        data_(std::exchange(other.data_, nullptr)) {}
+
+  ~VectorBatch() { memory::deallocateAligned(data_); }
+
+  VectorBatch &operator=(const VectorBatch &other) {
+    if (this == &other)
+      goto skipCopy;
+    if (capacity_ != other.capacity_) {
+      memory::deallocateAligned(data_);
+      data_ = memory::allocateAligned<T>(dim * other.capacity_);
+      capacity_ = other.capacity_;
+    }
+    size_ = other.size_;
+    std::copy_n(other.data_, dim * capacity_, data_);
+  skipCopy:
+    return *this;
+  }
+
+  VectorBatch &operator=(VectorBatch &&other) noexcept {
+    if (this == &other)
+      goto skipMove;
+    memory::deallocateAligned(data_);
+    size_ = std::exchange(other.size_, 0);
+    capacity_ = std::exchange(other.capacity_, 0);
+    data_ = std::exchange(other.data_, nullptr);
+  skipMove:
+    return *this;
+  }
+
+  // gathers the components of one vector, which costs dim strided reads
+  [[nodiscard]] Vector<T, dim> operator[](std::size_t index) const {
+    assert(index < size_);
+    Vector<T, dim> result(0);
+    for (std::size_t c = 0; c < dim; ++c)
+      result(c, 0) = component(c)[index];
+    return result;
+  }
+
+  void set(std::size_t index, const Vector<T, dim> &v) {
+    assert(index < size_);
+    for (std::size_t c = 0; c < dim; ++c)
+      component(c)[index] = v(c, 0);
+  }
+
+  // the contiguous array holding component c (0 for x, 1 for y...) of every
+  // vector in the batch
+  [[nodiscard]] const T *component(std::size_t c) const {
+    assert(c < dim);
+    return data_ + c * capacity_;
+  }
+
+  [[nodiscard]] T *component(std::size_t c) {
+    assert(c < dim);
+    return data_ + c * capacity_;
+  }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+  // all the component arrays at once, the way the batch kernels take them
+  [[nodiscard]] std::array<const T *, dim> components() const {
+    std::array<const T *, dim> result;
+    for (std::size_t c = 0; c < dim; ++c)
+      result[c] = component(c);
+    return result;
+  }
+
+  [[nodiscard]] std::array<T *, dim> components() {
+    std::array<T *, dim> result;
+    for (std::size_t c = 0; c < dim; ++c)
+      result[c] = component(c);
+    return result;
+  }
+
+private:
+  // rounds every component array up to whole cache lines
+  static std::size_t paddedSize_(std::size_t size) {
+    constexpr auto lineElements = memory::cacheLineSize / sizeof(T);
+    return (size + lineElements - 1) / lineElements * lineElements;
+  }
+
+  std::size_t size_, capacity_;
+  T *data_;
+};
+
+// aliases
+
+template <std::size_t dim> using FVectorBatch = VectorBatch<float, dim>;
+
+using FVector3Batch [[maybe_unused]] = FVectorBatch<3>;
+using FVector4Batch [[maybe_unused]] = FVectorBatch<4>;
+
+// batch operations. outputs must have the inputs' size and may be the inputs
+// themselves
+
+// out[i] = matrix * in[i]. 3d vectors are transformed as points (w = 1) by
+// default, pass w = 0 for directions. the bottom row of the matrix only
+// matters for 4d vectors
+template <std::floating_point T, std::size_t dim>
+void transform(const Matrix<T, 4, 4> &matrix, const VectorBatch<T, dim> &in,
+               VectorBatch<T, dim> &out, T w = T(1)) {
+  assert(in.size() == out.size());
+  kernels::batchKernels<T, dim>().transform(in.size(), matrix.data(),
+                                            in.components().data(), w,
+                                            out.components().data());
+}
+
+// out[i] = in[i] / |in[i]|
+template <std::floating_point T, std::size_t dim>
+void normalize(const VectorBatch<T, dim> &in, VectorBatch<T, dim> &out) {
+  assert(in.size() == out.size());
+  kernels::batchKernels<T, dim>().normalize(
+      in.size(), in.components().data(), out.components().data());
+}
+
+// out[i] = a[i] . b[i], out holding a.size() elements
+template <std::floating_point T, std::size_t dim>
+void dot(const VectorBatch<T, dim> &a, const VectorBatch<T, dim> &b, T *out) {
+  assert(a.size() == b.size());
+  kernels::batchKernels<T, dim>().dot(a.size(), a.components().data(),
+                                      b.components().data(), out);
+}
+
+// out[i] = a[i] x b[i], 4d vectors being crossed as 3d ones with w = 0
+template <std::floating_point T, std::size_t dim>
+void cross(const VectorBatch<T, dim> &a, const VectorBatch<T, dim> &b,
+           VectorBatch<T, dim> &out) {
+  assert(a.size() == b.size() && a.size() == out.size());
+  kernels::batchKernels<T, dim>().cross(a.size(), a.components().data(),
+                                        b.components().data(),
+                                        out.components().data());
+}
+
+} // namespace mcpp::math
+
+#endif // MODERN_CPP_INC_MATH_VECTOR_BATCH_HPP
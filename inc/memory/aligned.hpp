@@ -0,0 +1,59 @@
+#ifndef MODERN_CPP_INC_MEMORY_ALIGNED_HPP
+#define MODERN_CPP_INC_MEMORY_ALIGNED_HPP
+
+#include <cstddef>
+#include <new>
+
+namespace mcpp::memory {
+
+constexpr std::size_t cacheLineSize = 64;
+
+// raw storage for count objects of T, aligned to `alignment` bytes. nothing is
+// constructed, so this is meant for implicit-lifetime types like arithmetic
+// ones
+template <typename T>
+[[nodiscard]] T *allocateAligned(std::size_t count,
+                                 std::size_t alignment = cacheLineSize) {
+  return static_cast<T *>(
+      ::operator new(count * sizeof(T), std::align_val_t(alignment)));
+}
+
+template <typename T>
+void deallocateAligned(T *pointer,
+                       std::size_t alignment = cacheLineSize) noexcept {
+  ::operator delete(pointer, std::align_val_t(alignment));
+}
+
+// standard allocator interface over the above, for std containers that need
+// aligned buffers
+template <typename T, std::size_t alignment = cacheLineSize>
+class AlignedAllocator {
+public:
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, alignment>;
+  };
+
+  AlignedAllocator() = default;
+
+  template <typename U>
+  explicit AlignedAllocator(const AlignedAllocator<U, alignment> &) {}
+
+  [[nodiscard]] T *allocate(std::size_t count) {
+    return allocateAligned<T>(count, alignment);
+  }
+
+  void deallocate(T *pointer, std::size_t) noexcept {
+    deallocateAligned(pointer, alignment);
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, alignment> &) const {
+    return true;
+  }
+};
+
+} // namespace mcpp::memory
+
+#endif // MODERN_CPP_INC_MEMORY_ALIGNED_HPP
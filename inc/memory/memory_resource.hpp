@@ -0,0 +1,290 @@
+#ifndef MODERN_CPP_INC_MEMORY_MEMORY_RESOURCE_HPP
+#define MODERN_CPP_INC_MEMORY_MEMORY_RESOURCE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// where containers get their memory from, in the spirit of std::pmr. a
+// container takes a MemoryResource pointer when it's constructed and keeps
+// it for life, the resource has to outlive it. copies of a container go to
+// the default resource unless told otherwise, moves take the resource along.
+// the arena and pool resources below aren't synchronized, each one is meant
+// to be used by a single thread at a time
+
+namespace mcpp::memory {
+
+class MemoryResource {
+public:
+  virtual ~MemoryResource() = default;
+
+  [[nodiscard]] void *allocate(std::size_t bytes,
+                               std::size_t alignment = alignof(
+                                   std::max_align_t)) {
+    assert(std::has_single_bit(alignment));
+    return doAllocate_(bytes, alignment);
+  }
+
+  // bytes and alignment must be the ones the block was allocated with
+  void deallocate(void *pointer, std::size_t bytes,
+                  std::size_t alignment = alignof(std::max_align_t)) noexcept {
+    doDeallocate_(pointer, bytes, alignment);
+  }
+
+protected:
+  virtual void *doAllocate_(std::size_t bytes, std::size_t alignment) = 0;
+  virtual void doDeallocate_(void *pointer, std::size_t bytes,
+                             std::size_t alignment) noexcept = 0;
+};
+
+// the global heap: malloc for the fundamental alignments, so blocks can be
+// grown with realloc, the aligned operator new above them
+class HeapResource : public MemoryResource {
+public:
+  // grows or shrinks a block, moving its bytes if it has to. only the first
+  // min(bytes, newBytes) bytes are kept
+  [[nodiscard]] void *reallocate(void *pointer, std::size_t bytes,
+                                 std::size_t newBytes, std::size_t alignment) {
+    if (alignment <= alignof(std::max_align_t)) {
+      const auto result =
+          std::realloc(pointer, std::max(newBytes, std::size_t(1)));
+      if (!result)
+        throw std::bad_alloc();
+      return result;
+    }
+    const auto result = doAllocate_(newBytes, alignment);
+    if (pointer)
+      std::memcpy(result, pointer, std::min(bytes, newBytes));
+    doDeallocate_(pointer, bytes, alignment);
+    return result;
+  }
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    if (alignment > alignof(std::max_align_t))
+      return ::operator new(bytes, std::align_val_t(alignment));
+    const auto result = std::malloc(std::max(bytes, std::size_t(1)));
+    if (!result)
+      throw std::bad_alloc();
+    return result;
+  }
+
+  void doDeallocate_(void *pointer, std::size_t,
+                     std::size_t alignment) noexcept override {
+    if (alignment > alignof(std::max_align_t))
+      ::operator delete(pointer, std::align_val_t(alignment));
+    else
+      std::free(pointer);
+  }
+};
+
+[[nodiscard]] inline HeapResource *heapResource() {
+  static HeapResource resource;
+  return &resource;
+}
+
+namespace detail {
+
+inline std::atomic<MemoryResource *> &defaultResourceSlot() {
+  static std::atomic<MemoryResource *> resource = heapResource();
+  return resource;
+}
+
+} // namespace detail
+
+// what containers use when they aren't given a resource, the heap unless
+// changed
+[[nodiscard]] inline MemoryResource *defaultResource() {
+  return detail::defaultResourceSlot().load(std::memory_order_acquire);
+}
+
+// null goes back to the heap. returns the previous default
+inline MemoryResource *setDefaultResource(MemoryResource *resource) {
+  return detail::defaultResourceSlot().exchange(
+      resource ? resource : heapResource(), std::memory_order_acq_rel);
+}
+
+// a bump allocator: allocations carve the next bytes off the current chunk,
+// deallocation does nothing and release() (or the destructor) hands every
+// chunk back to upstream at once. chunks double in size as they run out, and
+// the first one can be a buffer of the caller's, e.g. on the stack
+class MonotonicResource : public MemoryResource {
+public:
+  explicit MonotonicResource(std::size_t initialSize = 1024,
+                             MemoryResource *upstream = defaultResource())
+      : upstream_(upstream), nextSize_(std::max(initialSize, minChunk_)),
+        initialSize_(nextSize_) {}
+
+  MonotonicResource(void *buffer, std::size_t size,
+                    MemoryResource *upstream = defaultResource())
+      : upstream_(upstream), current_(static_cast<std::byte *>(buffer)),
+        end_(current_ + size), nextSize_(std::max(size * 2, minChunk_)),
+        initialSize_(nextSize_), buffer_(current_), bufferSize_(size) {}
+
+  MonotonicResource(const MonotonicResource &) = delete;
+  MonotonicResource &operator=(const MonotonicResource &) = delete;
+
+  ~MonotonicResource() override { release(); }
+
+  // frees everything allocated from this resource in one go
+  void release() noexcept {
+    while (chunks_) {
+      const auto next = chunks_->next;
+      upstream_->deallocate(chunks_, chunks_->size, alignof(Chunk_));
+      chunks_ = next;
+    }
+    current_ = buffer_;
+    end_ = buffer_ + bufferSize_;
+    nextSize_ = initialSize_;
+  }
+
+  [[nodiscard]] MemoryResource *upstream() const { return upstream_; }
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    auto aligned = align_(current_, alignment);
+    if (!current_ || aligned + bytes > end_) {
+      newChunk_(bytes + alignment);
+      aligned = align_(current_, alignment);
+    }
+    current_ = aligned + bytes;
+    return aligned;
+  }
+
+  void doDeallocate_(void *, std::size_t, std::size_t) noexcept override {}
+
+private:
+  // at the start of each chunk, chaining them for release()
+  struct Chunk_ {
+    Chunk_ *next;
+    std::size_t size;
+  };
+
+  static constexpr std::size_t minChunk_ = 256;
+
+  static std::byte *align_(std::byte *pointer, std::size_t alignment) {
+    const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+    return pointer + ((alignment - address % alignment) % alignment);
+  }
+
+  void newChunk_(std::size_t atLeast) {
+    const auto size = std::max(nextSize_, atLeast + sizeof(Chunk_));
+    const auto chunk = ::new (upstream_->allocate(size, alignof(Chunk_)))
+        Chunk_{chunks_, size};
+    chunks_ = chunk;
+    current_ = reinterpret_cast<std::byte *>(chunk + 1);
+    end_ = reinterpret_cast<std::byte *>(chunk) + size;
+    nextSize_ = size * 2;
+  }
+
+  MemoryResource *upstream_;
+  Chunk_ *chunks_ = nullptr;
+  std::byte *current_ = nullptr, *end_ = nullptr;
+  std::size_t nextSize_, initialSize_;
+  std::byte *buffer_ = nullptr;
+  std::size_t bufferSize_ = 0;
+};
+
+// free lists of fixed-size blocks, one per power of two size class from 8 to
+// largestPooled bytes. a request is served by the smallest class that fits
+// both its size and alignment, blocks are carved out of chunks obtained from
+// upstream and recycled on deallocation, so steady churn of small objects
+// stops reaching upstream entirely. anything bigger goes straight upstream.
+// release() (or the destructor) frees all the chunks
+class PoolResource : public MemoryResource {
+public:
+  static constexpr std::size_t largestPooled = 512;
+
+  explicit PoolResource(MemoryResource *upstream = defaultResource())
+      : upstream_(upstream) {}
+
+  PoolResource(const PoolResource &) = delete;
+  PoolResource &operator=(const PoolResource &) = delete;
+
+  ~PoolResource() override { release(); }
+
+  void release() noexcept {
+    while (chunks_) {
+      const auto next = chunks_->next;
+      upstream_->deallocate(chunks_, chunks_->size, chunks_->alignment);
+      chunks_ = next;
+    }
+    std::fill(std::begin(free_), std::end(free_), nullptr);
+  }
+
+  [[nodiscard]] MemoryResource *upstream() const { return upstream_; }
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    const auto size = blockSize_(bytes, alignment);
+    if (size > largestPooled)
+      return upstream_->allocate(bytes, alignment);
+    auto &head = free_[classOf_(size)];
+    if (!head)
+      refill_(size);
+    const auto block = head;
+    head = head->next;
+    return block;
+  }
+
+  void doDeallocate_(void *pointer, std::size_t bytes,
+                     std::size_t alignment) noexcept override {
+    const auto size = blockSize_(bytes, alignment);
+    if (size > largestPooled) {
+      upstream_->deallocate(pointer, bytes, alignment);
+      return;
+    }
+    auto &head = free_[classOf_(size)];
+    head = ::new (pointer) Block_{head};
+  }
+
+private:
+  struct Block_ {
+    Block_ *next;
+  };
+
+  struct Chunk_ {
+    Chunk_ *next;
+    std::size_t size, alignment;
+  };
+
+  static constexpr std::size_t smallest_ = 8, classes_ = 7, chunkBytes_ = 4096;
+  static_assert(smallest_ << (classes_ - 1) == largestPooled);
+
+  static std::size_t blockSize_(std::size_t bytes, std::size_t alignment) {
+    return std::bit_ceil(std::max({bytes, alignment, smallest_}));
+  }
+
+  static std::size_t classOf_(std::size_t size) {
+    return std::countr_zero(size) - std::countr_zero(smallest_);
+  }
+
+  // a chunk's header takes its first block(s), the rest go on the free list.
+  // blocks are aligned to their size, which covers any alignment that maps
+  // to their class
+  void refill_(std::size_t size) {
+    const auto header = (sizeof(Chunk_) + size - 1) / size * size;
+    const auto alignment = std::max(size, alignof(Chunk_));
+    const auto raw = static_cast<std::byte *>(
+        upstream_->allocate(chunkBytes_, alignment));
+    chunks_ = ::new (raw) Chunk_{chunks_, chunkBytes_, alignment};
+    auto &head = free_[classOf_(size)];
+    for (auto block = raw + chunkBytes_ - size; block >= raw + header;
+         block -= size)
+      head = ::new (block) Block_{head};
+  }
+
+  MemoryResource *upstream_;
+  Chunk_ *chunks_ = nullptr;
+  Block_ *free_[classes_] = {};
+};
+
+} // namespace mcpp::memory
+
+#endif // MODERN_CPP_INC_MEMORY_MEMORY_RESOURCE_HPP
@@ -1,6 +1,7 @@
 #ifndef MODERN_CPP_INC_MISC_STRING_HPP
 #define MODERN_CPP_INC_MISC_STRING_HPP
 
+#include "memory/memory_resource.hpp"
 #include "type_traits/type_traits.hpp"
 #include <algorithm>
 #include <cstdint>
@@ -12,17 +13,25 @@ namespace mcpp {
 template <typename T>
 concept Char = type_traits::IsCharV<T>;
 
+// strings longer than the sso buffer get one from a memory resource, which
+// the string keeps for life. copies go to the default resource, the results
+// of + to the left operand's
 template <Char T> class BasicString {
 public:
   BasicString();
-  BasicString(const BasicString &);
+  explicit BasicString(memory::MemoryResource *);
+  BasicString(const BasicString &,
+              memory::MemoryResource * = memory::defaultResource());
   BasicString(BasicString &&) noexcept;
-  BasicString(const T *);
+  BasicString(const T *,
+              memory::MemoryResource * = memory::defaultResource());
 
   ~BasicString();
 
+  // assignment keeps this string's resource, so moving from a string with a
+  // different one copies
   BasicString &operator=(const BasicString &);
-  BasicString &operator=(BasicString &&) noexcept;
+  BasicString &operator=(BasicString &&);
   BasicString &operator=(const T *);
 
   [[nodiscard]] bool operator==(const BasicString &) const;
@@ -42,6 +51,12 @@ public:
   T &operator[](std::size_t);
 
   [[maybe_unused]] [[nodiscard]] std::size_t length() const;
+  [[nodiscard]] memory::MemoryResource *resource() const;
+
+  // the chars, not null terminated
+  [[nodiscard]] const T *data() const;
+  [[nodiscard]] const T *begin() const;
+  [[nodiscard]] const T *end() const;
 
   friend std::ostream &operator<<(std::ostream &os, const BasicString &str) {
     std::copy(str.data_, str.data_ + str.size_, std::ostream_iterator<T>(os));
@@ -51,15 +66,22 @@ public:
   // TODO: maybe someday add an operator>> to insert values from istream
 
 private:
-  explicit BasicString(std::size_t);
+  BasicString(std::size_t, memory::MemoryResource *);
 
   [[nodiscard]] std::size_t strLen_(const T *) const;
+  // a buffer for size chars, the sso one if they fit
+  [[nodiscard]] T *allocate_(std::size_t size);
+  // gives the heap buffer back, if there is one, and goes back to buf_
+  void release_() noexcept;
+  // size chars from other, in a buffer of the right size
+  void assign_(const T *other, std::size_t size);
 
   static constexpr auto outOfRangeMsg_ = "out of range";
   static constexpr auto ssoBufSize_ = 16ULL;
 
   T *data_;
   std::size_t size_;
+  memory::MemoryResource *resource_;
   T buf_[ssoBufSize_];
 };
 
@@ -71,37 +93,41 @@ using String32 [[maybe_unused]] = BasicString<char32_t>;
 } // namespace mcpp
 
 template <mcpp::Char T>
-inline mcpp::BasicString<T>::BasicString() : data_(buf_), size_(0) {}
+inline mcpp::BasicString<T>::BasicString()
+    : BasicString(memory::defaultResource()) {}
+
+template <mcpp::Char T>
+inline mcpp::BasicString<T>::BasicString(memory::MemoryResource *resource)
+    : data_(buf_), size_(0), resource_(resource) {}
 
 template <mcpp::Char T>
-mcpp::BasicString<T>::BasicString(const BasicString &other)
-    : data_(buf_), size_(other.size_) {
-  if (other.size_ > ssoBufSize_)
-    data_ = new T[size_];
+mcpp::BasicString<T>::BasicString(const BasicString &other,
+                                  memory::MemoryResource *resource)
+    : BasicString(other.size_, resource) {
   std::copy(other.data_, other.data_ + size_, data_);
 }
 
 template <mcpp::Char T>
 inline mcpp::BasicString<T>::BasicString(BasicString &&other) noexcept
-    : data_(buf_), size_(other.size_) {
-  if (other.size_ > ssoBufSize_) {
+    : data_(buf_), size_(other.size_), resource_(other.resource_) {
+  if (other.data_ != other.buf_) {
     data_ = other.data_;
-    other.data_ = nullptr;
+    other.data_ = other.buf_;
   } else {
     std::copy(other.data_, other.data_ + size_, buf_);
   }
   other.size_ = 0;
 }
 
-template <mcpp::Char T> mcpp::BasicString<T>::BasicString(const T *other) {
-  size_ = strLen_(other);
-  data_ = size_ > ssoBufSize_ ? new T[size_] : buf_;
+template <mcpp::Char T>
+mcpp::BasicString<T>::BasicString(const T *other,
+                                  memory::MemoryResource *resource)
+    : BasicString(strLen_(other), resource) {
   std::copy(other, other + size_, data_);
 }
 
 template <mcpp::Char T> inline mcpp::BasicString<T>::~BasicString() {
-  if (data_ != buf_)
-    delete[] data_;
+  release_();
   size_ = 0;
 }
 
@@ -110,41 +136,28 @@ mcpp::BasicString<T> &
 mcpp::BasicString<T>::operator=(const BasicString &other) {
   if (this == &other)
     goto skipCopy;
-  if (other.size_ > ssoBufSize_) {
-    // this resizes the array even if other.size_ == size_, but the additional
-    // ifs I'd have to write to optimize for that really specific case make me
-    // want to take my name off the census
-    if (data_ != buf_)
-      delete[] data_;
-    data_ = new T[other.size_];
-  } else if (data_ != buf_) {
-    delete[] data_;
-    data_ = buf_;
-  }
-  std::copy(other.data_, other.data_ + other.size_, data_);
-  size_ = other.size_;
+  // this reallocates even if other.size_ == size_, but the additional ifs
+  // I'd have to write to optimize for that really specific case make me want
+  // to take my name off the census
+  assign_(other.data_, other.size_);
 skipCopy:
   return *this;
 }
 
 template <mcpp::Char T>
 inline mcpp::BasicString<T> &
-mcpp::BasicString<T>::operator=(BasicString &&other) noexcept {
+mcpp::BasicString<T>::operator=(BasicString &&other) {
   if (this == &other)
     goto skipMove;
-  if (other.size_ > ssoBufSize_) {
-    if (data_ != buf_)
-      delete[] data_;
+  if (other.data_ != other.buf_ && resource_ == other.resource_) {
+    release_();
     data_ = other.data_;
-    other.data_ = nullptr;
+    other.data_ = other.buf_;
+    size_ = other.size_;
   } else {
-    if (data_ != buf_) {
-      delete[] data_;
-      data_ = buf_;
-    }
-    std::copy(other.data_, other.data_ + other.size_, data_); // tiny copy
+    assign_(other.data_, other.size_); // tiny copy, unless resources differ
+    other.release_();
   }
-  size_ = other.size_;
   other.size_ = 0;
 skipMove:
   return *this;
@@ -152,17 +165,7 @@ skipMove:
 
 template <mcpp::Char T>
 mcpp::BasicString<T> &mcpp::BasicString<T>::operator=(const T *other) {
-  auto otherLength = strLen_(other);
-  if (otherLength > ssoBufSize_) {
-    if (data_ != buf_)
-      delete[] data_;
-    data_ = new T[otherLength];
-  } else if (data_ != buf_) {
-    delete[] data_;
-    data_ = buf_;
-  }
-  std::copy(other, other + otherLength, data_);
-  size_ = otherLength;
+  assign_(other, strLen_(other));
   return *this;
 }
 
@@ -190,7 +193,7 @@ inline bool mcpp::BasicString<T>::operator!=(const T *other) const {
 template <mcpp::Char T>
 mcpp::BasicString<T>
 mcpp::BasicString<T>::operator+(const BasicString &other) const {
-  BasicString result(size_ + other.size_);
+  BasicString result(size_ + other.size_, resource_);
   auto midpoint = std::copy(data_, data_ + size_, result.data_);
   std::copy(other.data_, other.data_ + other.size_, midpoint);
   return result;
@@ -198,12 +201,12 @@ mcpp::BasicString<T>::operator+(const BasicString &other) const {
 
 template <mcpp::Char T>
 mcpp::BasicString<T> mcpp::BasicString<T>::operator+(const T *other) const {
-  return *this + BasicString(other);
+  return *this + BasicString(other, resource_);
 }
 
 template <mcpp::Char T>
 mcpp::BasicString<T> mcpp::BasicString<T>::operator+(const T &elem) const {
-  BasicString result(size_ + 1);
+  BasicString result(size_ + 1, resource_);
   std::copy(data_, data_ + size_, result.data_);
   result[size_] = elem;
   return result;
@@ -245,9 +248,28 @@ template <mcpp::Char T>
 }
 
 template <mcpp::Char T>
-mcpp::BasicString<T>::BasicString(std::size_t initialCapacity)
-    : size_(initialCapacity) {
-  data_ = size_ > ssoBufSize_ ? new T[size_] : buf_;
+inline mcpp::memory::MemoryResource *mcpp::BasicString<T>::resource() const {
+  return resource_;
+}
+
+template <mcpp::Char T> inline const T *mcpp::BasicString<T>::data() const {
+  return data_;
+}
+
+template <mcpp::Char T> inline const T *mcpp::BasicString<T>::begin() const {
+  return data_;
+}
+
+template <mcpp::Char T> inline const T *mcpp::BasicString<T>::end() const {
+  return data_ + size_;
+}
+
+template <mcpp::Char T>
+mcpp::BasicString<T>::BasicString(std::size_t initialCapacity,
+                                  memory::MemoryResource *resource)
+    : data_(buf_), size_(0), resource_(resource) {
+  data_ = allocate_(initialCapacity);
+  size_ = initialCapacity;
 }
 
 template <mcpp::Char T>
@@ -258,4 +280,26 @@ std::size_t mcpp::BasicString<T>::strLen_(const T *str) const {
   return p - str;
 }
 
+template <mcpp::Char T> T *mcpp::BasicString<T>::allocate_(std::size_t size) {
+  if (size <= ssoBufSize_)
+    return buf_;
+  return static_cast<T *>(resource_->allocate(size * sizeof(T), alignof(T)));
+}
+
+template <mcpp::Char T> void mcpp::BasicString<T>::release_() noexcept {
+  if (data_ != buf_)
+    resource_->deallocate(data_, size_ * sizeof(T), alignof(T));
+  data_ = buf_;
+}
+
+template <mcpp::Char T>
+void mcpp::BasicString<T>::assign_(const T *other, std::size_t size) {
+  // allocated before anything is freed, other may point into this string
+  const auto newData = allocate_(size);
+  std::copy(other, other + size, newData);
+  release_();
+  data_ = newData;
+  size_ = size;
+}
+
 #endif // MODERN_CPP_INC_MISC_STRING_HPP
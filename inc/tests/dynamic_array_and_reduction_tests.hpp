@@ -3,6 +3,12 @@
 
 void testDynamicArray();
 
+void testSmallArray();
+
+void testConcurrentArray();
+
+void testThreadPool();
+
 void testReduction();
 
 #endif // MODERN_CPP_INC_TESTS_DYNAMIC_ARRAY_AND_REDUCTION_TESTS_HPP
@@ -0,0 +1,6 @@
+#ifndef MODERN_CPP_INC_TESTS_HASH_TABLE_TESTS_HPP
+#define MODERN_CPP_INC_TESTS_HASH_TABLE_TESTS_HPP
+
+void testHashTables();
+
+#endif // MODERN_CPP_INC_TESTS_HASH_TABLE_TESTS_HPP
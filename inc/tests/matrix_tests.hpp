@@ -0,0 +1,6 @@
+#ifndef MODERN_CPP_INC_TESTS_MATRIX_TESTS_HPP
+#define MODERN_CPP_INC_TESTS_MATRIX_TESTS_HPP
+
+void testMatrix();
+
+#endif // MODERN_CPP_INC_TESTS_MATRIX_TESTS_HPP
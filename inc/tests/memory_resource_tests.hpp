@@ -0,0 +1,6 @@
+#ifndef MODERN_CPP_INC_TESTS_MEMORY_RESOURCE_TESTS_HPP
+#define MODERN_CPP_INC_TESTS_MEMORY_RESOURCE_TESTS_HPP
+
+void testMemoryResources();
+
+#endif // MODERN_CPP_INC_TESTS_MEMORY_RESOURCE_TESTS_HPP
@@ -2,6 +2,7 @@
 #define MODERN_CPP_INC_TYPE_TRAITS_TYPE_TRAITS_HPP
 
 #include <cstdint>
+#include <type_traits>
 
 namespace mcpp::type_traits {
 
@@ -43,6 +44,18 @@ template <> struct IsChar<char32_t> {
 
 template <typename T> constexpr auto IsCharV = IsChar<T>::value;
 
+// whether an object can be moved to a new address by copying its bytes and
+// forgetting the original, without running any constructor or destructor.
+// trivially copyable types can, other types opt in by specializing this (most
+// types that own a heap buffer qualify, types that point into themselves,
+// like BasicString with its inline buffer, don't)
+template <typename T> struct IsTriviallyRelocatable {
+  static constexpr const bool value = std::is_trivially_copyable_v<T>;
+};
+
+template <typename T>
+constexpr auto IsTriviallyRelocatableV = IsTriviallyRelocatable<T>::value;
+
 } // namespace type_traits
 
 #endif // MODERN_CPP_INC_TYPE_TRAITS_TYPE_TRAITS_HPP
@@ -0,0 +1,185 @@
+#include "bench/benchmark.hpp"
+#include "data_structures/flat_hash_table.hpp"
+#include "misc/string.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// FlatHashMap against std::unordered_map: inserting n keys into an empty map,
+// finding n keys that are there and n that aren't, and removing and
+// reinserting every key of a full map, for integer and string keys. ns/op is
+// per key. see bench/benchmark.hpp for how they're timed and the options
+//
+//   hash_bench [--filter substring] [--min-time seconds] [--json file]
+
+namespace {
+
+using mcpp::bench::doNotOptimize;
+using mcpp::bench::Options;
+using mcpp::bench::Result;
+using mcpp::data_structures::FlatHashMap;
+
+// the few operations the benchmarks need, for either map
+template <typename K, typename V>
+void insert(FlatHashMap<K, V> &map, const K &key, V value) {
+  map.insert(key, value);
+}
+
+template <typename K, typename V>
+void insert(std::unordered_map<K, V> &map, const K &key, V value) {
+  map.emplace(key, value);
+}
+
+template <typename K, typename V>
+bool contains(const FlatHashMap<K, V> &map, const K &key) {
+  return map.find(key);
+}
+
+template <typename K, typename V>
+bool contains(const std::unordered_map<K, V> &map, const K &key) {
+  return map.find(key) != map.end();
+}
+
+template <typename K, typename V>
+void remove(FlatHashMap<K, V> &map, const K &key) {
+  map.remove(key);
+}
+
+template <typename K, typename V>
+void remove(std::unordered_map<K, V> &map, const K &key) {
+  map.erase(key);
+}
+
+// n distinct keys that are in the map and n that aren't, plus the present
+// ones shuffled. lookups go in that order, not the one they were inserted in,
+// or std::unordered_map would walk its nodes in allocation order
+template <typename K> struct Keys {
+  std::vector<K> present, absent, shuffled;
+};
+
+template <typename K> Keys<K> shuffle(Keys<K> keys) {
+  keys.shuffled = keys.present;
+  std::shuffle(keys.shuffled.begin(), keys.shuffled.end(),
+               std::mt19937_64(7));
+  return keys;
+}
+
+Keys<std::uint64_t> integerKeys(std::size_t n) {
+  std::mt19937_64 gen(42);
+  Keys<std::uint64_t> keys;
+  // odd keys are in, even ones out
+  for (std::size_t i = 0; i < n; ++i) {
+    keys.present.push_back(gen() | 1);
+    keys.absent.push_back(gen() & ~std::uint64_t(1));
+  }
+  return shuffle(std::move(keys));
+}
+
+// 8 to 40 chars, so some fit BasicString's inline buffer and some don't
+template <typename S> Keys<S> stringKeys(std::size_t n) {
+  std::mt19937_64 gen(42);
+  Keys<S> keys;
+  const auto make = [&](char prefix, std::size_t i) {
+    std::string key;
+    key += prefix;
+    key += std::to_string(i);
+    key.resize(std::max(key.size(), std::size_t(8 + gen() % 33)), 'x');
+    return S(key.c_str());
+  };
+  for (std::size_t i = 0; i < n; ++i) {
+    keys.present.push_back(make('+', i));
+    keys.absent.push_back(make('-', i));
+  }
+  return shuffle(std::move(keys));
+}
+
+template <typename Map, typename K>
+void benchmarkMap(const char *map, const char *keyType, const Keys<K> &keys,
+                  const Options &options, std::vector<Result> &results) {
+  const auto n = keys.present.size();
+  const auto run = [&](const char *op, const std::function<void()> &body) {
+    auto name = std::string(op) + '/' + map + '/' + keyType + '/' +
+                std::to_string(n);
+    if (name.find(options.filter) == std::string::npos)
+      return;
+    results.push_back(
+        mcpp::bench::measure(std::move(name), 0, 0, options.minTime, body));
+    results.back().nsPerOp /= double(n);
+    mcpp::bench::print(results.back());
+  };
+
+  run("insert", [&] {
+    Map fresh;
+    for (const auto &key : keys.present)
+      insert(fresh, key, 1);
+    doNotOptimize(fresh);
+  });
+
+  Map full;
+  for (const auto &key : keys.present)
+    insert(full, key, 1);
+  run("find_hit", [&] {
+    std::size_t found = 0;
+    for (const auto &key : keys.shuffled)
+      found += contains(full, key);
+    doNotOptimize(found);
+  });
+  run("find_miss", [&] {
+    std::size_t found = 0;
+    for (const auto &key : keys.absent)
+      found += contains(full, key);
+    doNotOptimize(found);
+  });
+  run("remove_insert", [&] {
+    for (const auto &key : keys.shuffled) {
+      remove(full, key);
+      insert(full, key, 1);
+    }
+    doNotOptimize(full);
+  });
+}
+
+void benchmarkSize(std::size_t n, const Options &options,
+                   std::vector<Result> &results) {
+  const auto integers = integerKeys(n);
+  benchmarkMap<FlatHashMap<std::uint64_t, int>>("flat", "int", integers,
+                                                options, results);
+  benchmarkMap<std::unordered_map<std::uint64_t, int>>("std", "int", integers,
+                                                       options, results);
+  benchmarkMap<FlatHashMap<mcpp::String, int>>(
+      "flat", "string", stringKeys<mcpp::String>(n), options, results);
+  benchmarkMap<std::unordered_map<std::string, int>>(
+      "std", "string", stringKeys<std::string>(n), options, results);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!mcpp::bench::parse(argc, argv, options)) {
+    std::cerr << "usage: " << argv[0]
+              << " [--filter substring] [--min-time seconds] [--json file]\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Result> results;
+  for (std::size_t n : {1000, 100000, 1000000})
+    benchmarkSize(n, options, results);
+
+  if (!options.json.empty()) {
+    std::ofstream out(options.json);
+    mcpp::bench::writeJson(out, results, {});
+    if (!out) {
+      std::cerr << "couldn't write " << options.json << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
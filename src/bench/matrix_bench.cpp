@@ -0,0 +1,150 @@
+#include "bench/benchmark.hpp"
+#include "math/kernels/simd.hpp"
+#include "math/matrix.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// matrix benchmarks: multiply, add, transpose, dot, copy and move over a
+// range of sizes, for float and double, in fixed-size and dynamic storage.
+// the byte counts are the minimal traffic (each operand read once, the result
+// written once), so GB/s is a lower bound. see bench/benchmark.hpp for how
+// they're timed and the options
+//
+//   matrix_bench [--filter substring] [--min-time seconds] [--json file]
+
+namespace {
+
+using mcpp::bench::doNotOptimize;
+using mcpp::bench::Options;
+using mcpp::bench::Result;
+using mcpp::math::DMatrix;
+using mcpp::math::Matrix;
+
+template <typename T> void randomize(T *data, std::size_t count) {
+  static std::mt19937 gen(42);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  for (std::size_t i = 0; i < count; ++i)
+    data[i] = T(dist(gen));
+}
+
+template <typename T> const char *typeName() {
+  return std::is_same_v<T, float> ? "float" : "double";
+}
+
+// the same set of operations for any square matrix type M, built by make
+template <typename T, typename M, typename V, typename Make, typename MakeV>
+void benchmarkStorage(const char *storage, std::size_t n, Make make,
+                      MakeV makeVector, const Options &options,
+                      std::vector<Result> &results) {
+  const auto name = [&](const char *op) {
+    return std::string(op) + '/' + storage + '/' + typeName<T>() + '/' +
+           std::to_string(n);
+  };
+  const auto run = [&](const char *op, double flops, double bytes,
+                       const std::function<void()> &body) {
+    auto full = name(op);
+    if (full.find(options.filter) == std::string::npos)
+      return;
+    results.push_back(mcpp::bench::measure(std::move(full), flops, bytes,
+                                           options.minTime, body));
+    mcpp::bench::print(results.back());
+  };
+
+  const auto elements = double(n) * double(n), size = double(sizeof(T));
+  M a = make(), b = make(), c = make();
+  randomize(a.data(), n * n);
+  randomize(b.data(), n * n);
+  V x = makeVector(), y = makeVector();
+  randomize(x.data(), n * n);
+  randomize(y.data(), n * n);
+
+  run("multiply", 2 * elements * double(n), 3 * elements * size, [&] {
+    c = a * b;
+    doNotOptimize(c);
+  });
+  run("add", elements, 3 * elements * size, [&] {
+    c = a + b;
+    doNotOptimize(c);
+  });
+  run("transpose", 0, 2 * elements * size, [&] {
+    c = a.transposed();
+    doNotOptimize(c);
+  });
+  run("dot", 2 * elements, 2 * elements * size, [&] {
+    const auto d = x.dot(y);
+    doNotOptimize(d);
+  });
+  run("copy", 0, 2 * elements * size, [&] {
+    c = a;
+    doNotOptimize(c);
+  });
+  // a round trip, dynamic matrices only swap pointers so they move no
+  // elements at all
+  const auto moved = std::is_same_v<M, DMatrix<T>> ? 0 : 4 * elements * size;
+  run("move", 0, moved, [&] {
+    M d = std::move(a);
+    a = std::move(d);
+    doNotOptimize(a);
+  });
+}
+
+template <typename T, std::size_t n>
+void benchmarkStatic(const Options &options, std::vector<Result> &results) {
+  benchmarkStorage<T, Matrix<T, n, n>, Matrix<T, 1, n * n>>(
+      "static", n, [] { return Matrix<T, n, n>(); },
+      [] { return Matrix<T, 1, n * n>(); }, options, results);
+}
+
+template <typename T>
+void benchmarkDynamic(std::size_t n, const Options &options,
+                      std::vector<Result> &results) {
+  benchmarkStorage<T, DMatrix<T>, DMatrix<T>>(
+      "dynamic", n, [n] { return DMatrix<T>(n, n); },
+      [n] { return DMatrix<T>(1, n * n); }, options, results);
+}
+
+template <typename T>
+void benchmarkType(const Options &options, std::vector<Result> &results) {
+  benchmarkStatic<T, 4>(options, results);
+  benchmarkStatic<T, 16>(options, results);
+  benchmarkStatic<T, 64>(options, results);
+  for (std::size_t n : {4, 16, 64, 256, 1024})
+    benchmarkDynamic<T>(n, options, results);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!mcpp::bench::parse(argc, argv, options)) {
+    std::cerr << "usage: " << argv[0]
+              << " [--filter substring] [--min-time seconds] [--json file]\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Result> results;
+  benchmarkType<float>(options, results);
+  benchmarkType<double>(options, results);
+
+  if (!options.json.empty()) {
+    std::ofstream out(options.json);
+    mcpp::bench::writeJson(
+        out, results,
+        {{"simd_level",
+          std::to_string(int(mcpp::math::kernels::detectSimdLevel()))},
+         {"threads",
+          std::to_string(
+              mcpp::concurrency::defaultThreadPool().threadCount())}});
+    if (!out) {
+      std::cerr << "couldn't write " << options.json << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,17 +1,26 @@
 #include "tests/dynamic_array_and_reduction_tests.hpp"
 #include "tests/fundamental_types_tests.hpp"
+#include "tests/hash_table_tests.hpp"
 #include "tests/int32_type_traits_test.hpp"
 #include "tests/linked_list_test.hpp"
+#include "tests/matrix_tests.hpp"
+#include "tests/memory_resource_tests.hpp"
 #include "tests/string_tests.hpp"
 #include <cstdlib>
 
 int main() {
   testDynamicArray();
+  testSmallArray();
+  testConcurrentArray();
+  testThreadPool();
   testReduction();
   testLinkedList();
+  testHashTables();
+  testMemoryResources();
   testInt32TypeTraits();
   testFundamentalTypes();
   testString();
+  testMatrix();
 
   return EXIT_SUCCESS;
 }
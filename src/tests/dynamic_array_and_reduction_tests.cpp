@@ -1,7 +1,52 @@
 #include "tests/dynamic_array_and_reduction_tests.hpp"
 #include "algorithms/reduce.hpp"
+#include "concurrency/thread_pool.hpp"
+#include "data_structures/concurrent_array.hpp"
 #include "data_structures/dynamic_array.hpp"
+#include "data_structures/small_array.hpp"
+#include "misc/string.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+
+// counts how elements get carried over when an array grows
+struct Counted {
+  static inline std::size_t copies = 0, moves = 0;
+
+  explicit Counted(int value) : value(value) {}
+  Counted(const Counted &other) : value(other.value) { ++copies; }
+  Counted(Counted &&other) noexcept : value(other.value) { ++moves; }
+  Counted &operator=(const Counted &) = default;
+  Counted &operator=(Counted &&) noexcept = default;
+  ~Counted() {} // not trivially copyable, so growth has to move
+
+  int value;
+};
+
+// passes everything on to the heap, counting the allocations
+class CountingResource : public mcpp::memory::MemoryResource {
+public:
+  std::size_t allocations = 0;
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return mcpp::memory::heapResource()->allocate(bytes, alignment);
+  }
+
+  void doDeallocate_(void *pointer, std::size_t bytes,
+                     std::size_t alignment) noexcept override {
+    mcpp::memory::heapResource()->deallocate(pointer, bytes, alignment);
+  }
+};
+
+} // namespace
 
 void testDynamicArray() {
   using mcpp::data_structures::Array;
@@ -31,6 +76,145 @@ void testDynamicArray() {
   Array<float> b{1, 2, 3, 4, 5};
 
   std::cout << "b = " << b << std::endl;
+
+  // growth moves instead of copying, emplace builds in place
+  Array<Counted> counted;
+  for (auto i = 0; i < 100; ++i)
+    counted.emplace(i);
+  std::cout << "100 emplaces, copies: " << Counted::copies
+            << ", moves: " << Counted::moves
+            << ", capacity: " << counted.capacity() << '\n';
+
+  // strings point into themselves, so they're moved one by one. pushing an
+  // element of the array itself survives the growth
+  Array<mcpp::String> strings;
+  strings.reserve(2);
+  strings.push("a string too long for the inline buffer");
+  strings.push(mcpp::String("short"));
+  strings.push(strings[0]);
+  const auto copy = strings;
+  std::cout << "strings: " << strings
+            << ", copy equal? " << (copy[2] == strings[0]) << '\n';
+
+  // arrays themselves relocate as bytes, nested growth is realloc
+  Array<Array<unsigned>> nested;
+  for (auto i = 0U; i < 20; ++i) {
+    nested.emplace();
+    nested[i].push(i);
+    nested[i].push(nested[i][0] + 1);
+  }
+  std::cout << "nested: " << nested.size() << " arrays, the last holds "
+            << nested[19] << std::endl;
+}
+
+void testSmallArray() {
+  using mcpp::data_structures::SmallArray;
+
+  SmallArray<unsigned, 16> a;
+  for (auto i = 0U; i < 16; ++i)
+    a.push(i);
+  std::cout << "16 elements inline? " << a.isInline();
+  a.push(a[0]); // spills, reading from the inline buffer it leaves
+  std::cout << ", 17 inline? " << a.isInline() << ", a = " << a << '\n';
+
+  // moves steal heap buffers but have to move inline elements
+  SmallArray<mcpp::String, 2> strings{"first", "a string that needs the heap"};
+  auto moved = std::move(strings);
+  moved.emplace("third");
+  auto copy = moved;
+  copy.remove("first");
+  std::cout << "moved: " << moved << ", inline? " << moved.isInline()
+            << ", copy without the first: " << copy
+            << ", source empty? " << (strings.size() == 0) << '\n';
+
+  moved.clear();
+  std::cout << "cleared back inline? " << moved.isInline() << ", sizes: "
+            << sizeof(SmallArray<float, 4>) << ' '
+            << sizeof(mcpp::data_structures::Array<float>) << std::endl;
+}
+
+void testConcurrentArray() {
+  using mcpp::data_structures::ConcurrentArray;
+
+  ConcurrentArray<std::size_t> a;
+  const auto first = &a.emplace(0);
+
+  // 8 producers, and a reader walking the array while they push
+  constexpr std::size_t producers = 8, perProducer = 10000;
+  std::atomic<bool> done = false;
+  std::size_t walks = 0, maxSeen = 0;
+  std::thread reader([&] {
+    while (!done.load()) {
+      std::size_t seen = 0;
+      for ([[maybe_unused]] auto value : a)
+        ++seen;
+      maxSeen = std::max(maxSeen, seen);
+      ++walks;
+    }
+  });
+  mcpp::concurrency::ThreadPool pool(producers);
+  pool.parallelFor(producers, [&](std::size_t producer) {
+    for (std::size_t i = 1; i <= perProducer; ++i)
+      a.push(producer * perProducer + i);
+  });
+  done = true;
+  reader.join();
+
+  std::cout << "concurrent pushes: " << a.size()
+            << ", first element stayed put? " << (&a[0] == first)
+            << ", reader walks: " << (walks > 0)
+            << ", reader never saw too many? "
+            << (maxSeen <= a.size()) << '\n';
+
+  // the first segment holds 64, the push at index 32 installs the second
+  CountingResource counter;
+  ConcurrentArray<int> b(&counter);
+  for (int i = 0; i < 32; ++i)
+    b.push(i);
+  const auto before = counter.allocations;
+  b.push(32);
+  std::cout << "next segment installed halfway through? "
+            << (before == 1 && counter.allocations == 2) << '\n';
+
+  auto frozen = a.freeze();
+  std::sort(frozen.begin(), frozen.end());
+  std::size_t expected = 0;
+  const auto complete = std::all_of(frozen.begin(), frozen.end(),
+                                    [&](auto value) {
+                                      return value == expected++;
+                                    });
+  std::cout << "frozen: " << frozen.size() << " elements, all there? "
+            << (complete && expected == producers * perProducer + 1)
+            << ", left empty? " << (a.size() == 0) << std::endl;
+}
+
+void testThreadPool() {
+  mcpp::concurrency::ThreadPool pool(4);
+
+  // every index throws, so the submitter and the workers all do
+  std::string message;
+  try {
+    pool.parallelFor(1000, [](std::size_t i) {
+      throw std::runtime_error("task " + std::to_string(i));
+    });
+  } catch (const std::runtime_error &error) {
+    message = error.what();
+  }
+  std::cout << "task exception rethrown? " << (message.rfind("task ", 0) == 0);
+
+  // the pool still runs loops in parallel afterwards: two tasks that wait for
+  // each other only both finish when they're on different threads
+  std::atomic<int> arrived = 0;
+  std::atomic<bool> met = true;
+  pool.parallelFor(2, [&](std::size_t) {
+    ++arrived;
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (arrived < 2 && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+    met = met && arrived == 2;
+  });
+  std::cout << ", still parallel afterwards? " << met << std::endl;
 }
 
 void testReduction() {
@@ -0,0 +1,127 @@
+#include "tests/hash_table_tests.hpp"
+#include "data_structures/flat_hash_table.hpp"
+#include "memory/memory_resource.hpp"
+#include "misc/string.hpp"
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+using mcpp::data_structures::FlatHashMap;
+using mcpp::data_structures::FlatHashSet;
+
+// passes everything on to the heap, counting the allocations. once there
+// have been limit of them, the next ones throw
+class CountingResource : public mcpp::memory::MemoryResource {
+public:
+  std::size_t allocations = 0, limit = -1;
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    if (allocations == limit)
+      throw std::bad_alloc();
+    ++allocations;
+    return mcpp::memory::heapResource()->allocate(bytes, alignment);
+  }
+
+  void doDeallocate_(void *pointer, std::size_t bytes,
+                     std::size_t alignment) noexcept override {
+    mcpp::memory::heapResource()->deallocate(pointer, bytes, alignment);
+  }
+};
+
+void testSet() {
+  FlatHashSet<int> s{1, 2, 3};
+  std::cout << "s = " << s << ", inserted 2 again? " << s.insert(2)
+            << ", removed 2? " << s.remove(2) << ", contains 2? "
+            << s.contains(2) << '\n';
+
+  // random inserts and removes against std::unordered_set, removal shifts
+  // elements back so lookups behind a removed one must still find theirs
+  FlatHashSet<unsigned> set;
+  std::unordered_set<unsigned> reference;
+  std::mt19937 gen(42);
+  auto agree = true;
+  for (auto i = 0; i < 200000; ++i) {
+    const auto key = gen() % 4096;
+    switch (gen() % 3) {
+    case 0:
+      agree &= set.insert(key) == reference.insert(key).second;
+      break;
+    case 1:
+      agree &= set.remove(key) == (reference.erase(key) == 1);
+      break;
+    default:
+      agree &= set.contains(key) == reference.contains(key);
+    }
+  }
+  std::size_t iterated = 0;
+  for ([[maybe_unused]] auto key : set)
+    ++iterated;
+  std::cout << "agrees with std::unordered_set? "
+            << (agree && set.size() == reference.size() &&
+                iterated == reference.size())
+            << ", size " << set.size() << ", capacity " << set.capacity()
+            << '\n';
+}
+
+void testMap() {
+  FlatHashMap<mcpp::String, int> counts;
+  for (const auto word : {"the", "a", "the", "string too long for sso",
+                          "the", "string too long for sso"})
+    ++counts[word];
+  std::cout << "counts of the: " << counts.at("the")
+            << ", of the long one: " << counts.at("string too long for sso")
+            << ", of a: " << counts.at(std::string_view("a")) << '\n';
+
+  // heterogeneous lookups hash and compare the chars they're given, no
+  // BasicString gets built
+  CountingResource counting;
+  const auto previous = mcpp::memory::setDefaultResource(&counting);
+  const auto found =
+      counts.contains("string too long for sso") && !counts.find("missing");
+  mcpp::memory::setDefaultResource(previous);
+  std::cout << "found by C string? " << found
+            << ", allocations: " << counting.allocations << '\n';
+
+  try {
+    [[maybe_unused]] const auto &missing = counts.at("missing");
+  } catch (const std::out_of_range &e) {
+    std::cout << "at(\"missing\") threw: " << e.what() << '\n';
+  }
+
+  auto copy = counts;
+  copy.remove("the");
+  std::cout << "copy without the: " << copy.size()
+            << " keys, original: " << counts.size() << '\n';
+
+  // a rehash that can't get its new block leaves the map as it was
+  CountingResource failing;
+  FlatHashMap<int, int> squares(&failing);
+  squares.insert(0, 0);
+  failing.limit = failing.allocations;
+  auto inserted = 1;
+  try {
+    for (;; ++inserted)
+      squares.insert(inserted, inserted * inserted);
+  } catch (const std::bad_alloc &) {
+  }
+  auto intact = squares.size() == std::size_t(inserted);
+  for (auto i = 0; i < inserted; ++i)
+    intact &= squares.contains(i) && squares.at(i) == i * i;
+  std::cout << "failed rehash kept all " << inserted
+            << " entries? " << intact << std::endl;
+}
+
+} // namespace
+
+void testHashTables() {
+  std::cout << "--- TESTING HASH TABLES ---\n";
+
+  testSet();
+  testMap();
+}
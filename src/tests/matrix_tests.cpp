@@ -0,0 +1,910 @@
+#include "tests/matrix_tests.hpp"
+
+#include "concurrency/thread_pool.hpp"
+#include "first_assignment/heap_matrix.hpp"
+#include "math/blas.hpp"
+#include "math/decomposition.hpp"
+#include "math/matrix.hpp"
+#include "math/matrix_io.hpp"
+#include "math/sparse_matrix.hpp"
+#include "math/strassen.hpp"
+#include "math/vector_batch.hpp"
+#include "memory/memory_resource.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using mcpp::math::DMatrix;
+using mcpp::math::FMatrix;
+using mcpp::math::FMatrix3x3;
+using mcpp::math::FMatrix4x4;
+
+namespace {
+
+// passes everything on to the heap, counting what reaches it
+class CountingResource : public mcpp::memory::MemoryResource {
+public:
+  std::size_t allocations = 0;
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return mcpp::memory::heapResource()->allocate(bytes, alignment);
+  }
+
+  void doDeallocate_(void *pointer, std::size_t bytes,
+                     std::size_t alignment) noexcept override {
+    mcpp::memory::heapResource()->deallocate(pointer, bytes, alignment);
+  }
+};
+
+template <typename T> DMatrix<T> randomMatrix(std::size_t w, std::size_t h) {
+  static std::mt19937 gen(42);
+  std::uniform_real_distribution<T> dist(-1, 1);
+  DMatrix<T> m(w, h);
+  for (auto &x : m)
+    x = dist(gen);
+  return m;
+}
+
+template <typename T>
+T maxDifference(const DMatrix<T> &a, const DMatrix<T> &b) {
+  T difference = 0;
+  for (std::size_t i = 0; i < a.height(); ++i)
+    for (std::size_t j = 0; j < a.width(); ++j)
+      difference = std::max(difference, std::abs(a(i, j) - b(i, j)));
+  return difference;
+}
+
+template <typename T>
+T maxProductError(const DMatrix<T> &a, const DMatrix<T> &b,
+                  const DMatrix<T> &product) {
+  T error = 0;
+  for (std::size_t i = 0; i < a.height(); ++i)
+    for (std::size_t j = 0; j < b.width(); ++j) {
+      T expected = 0;
+      for (std::size_t k = 0; k < a.width(); ++k)
+        expected += a(i, k) * b(k, j);
+      error = std::max(error, std::abs(expected - product(i, j)));
+    }
+  return error;
+}
+
+void testProduct() {
+  const auto a = randomMatrix<float>(300, 257),
+             b = randomMatrix<float>(131, 300);
+  std::cout << "float gemm error: " << maxProductError(a, b, a * b) << '\n';
+
+  const auto c = randomMatrix<double>(5, 7), d = randomMatrix<double>(3, 5);
+  std::cout << "small double gemm error: " << maxProductError(c, d, c * d)
+            << std::endl;
+}
+
+void testParallelProduct() {
+  using mcpp::concurrency::ThreadPool;
+
+  const auto a = randomMatrix<float>(300, 230),
+             b = randomMatrix<float>(270, 300);
+  ThreadPool one(1), four(4);
+  const auto serial = a.multiply(b, one), parallel = a.multiply(b, four);
+  std::cout << "parallel gemm error: " << maxProductError(a, b, parallel)
+            << ", same as single-threaded? "
+            << std::equal(serial.begin(), serial.end(), parallel.begin())
+            << '\n';
+}
+
+void testExpressions() {
+  const auto a = randomMatrix<float>(70, 40), b = randomMatrix<float>(70, 40),
+             c = randomMatrix<float>(70, 40);
+  const DMatrix<float> d = a + b * 2.f - c;
+  float error = 0;
+  for (std::size_t i = 0; i < d.height(); ++i)
+    for (std::size_t j = 0; j < d.width(); ++j)
+      error = std::max(error,
+                       std::abs(a(i, j) + b(i, j) * 2.f - c(i, j) - d(i, j)));
+  std::cout << "fused expression error: " << error << '\n';
+
+  FMatrix3x3 m{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  const FMatrix3x3 n = -m / 2.f + m;
+  std::cout << "m / 2 =\n" << n << '\n';
+
+  const DMatrix<float> powers{{1, 2}, {4, 8}};
+  std::cout << "8 / powers == powers reversed? "
+            << (DMatrix<float>(8.f / powers) ==
+                DMatrix<float>{{8, 4}, {2, 1}})
+            << '\n';
+
+  // fixed-size matrices are plain values now, moving one leaves it intact
+  DMatrix<float> dynamic(std::move(m));
+  std::cout << "moved from static intact? " << (dynamic == m) << std::endl;
+}
+
+void testSimdKernels() {
+  using namespace mcpp::math::kernels;
+
+  const auto a = randomMatrix<double>(1, 1001),
+             b = randomMatrix<double>(1, 1001);
+  const auto reference = simdKernelsFor<double>(SimdLevel::scalar);
+  std::cout << "simd level: " << int(detectSimdLevel()) << '\n';
+  for (auto level = int(detectSimdLevel()); level >= 0; --level) {
+    const auto kernels = simdKernelsFor<double>(SimdLevel(level));
+    std::cout << "level " << level << " dot error: "
+              << std::abs(kernels.dot(1001, a.begin(), b.begin()) -
+                          reference.dot(1001, a.begin(), b.begin()))
+              << ", sum error: "
+              << std::abs(kernels.sum(1001, a.begin()) -
+                          reference.sum(1001, a.begin()))
+              << '\n';
+  }
+
+  const DMatrix<double> sum = a + b, negated = -a;
+  std::cout << "a + b == b + a? " << (sum == DMatrix<double>(b + a))
+            << ", -a == a * -1? " << (negated == DMatrix<double>(a * -1.))
+            << ", |a| = " << a.length() << std::endl;
+}
+
+void testBlas() {
+  using mcpp::math::FVector3;
+
+  const auto a = randomMatrix<double>(90, 70),
+             b = randomMatrix<double>(50, 90), x = randomMatrix<double>(1, 90);
+  auto c = randomMatrix<double>(50, 70), y = randomMatrix<double>(1, 70);
+  const DMatrix<double> expectedC = a * b * 2. + c * .5,
+                        expectedY = a * x * 3. - y;
+
+  mcpp::math::gemm(2., a, b, .5, c);
+  mcpp::math::gemv(3., a, x, -1., y);
+  std::cout << "gemm-accumulate error: " << maxDifference(c, expectedC)
+            << ", gemv error: " << maxDifference(y, expectedY) << '\n';
+
+  mcpp::math::axpy(-1., expectedY, y);
+  FVector3 v{{1}, {2}, {3}};
+  v += v;
+  v *= .5f;
+  v -= FVector3{{1}, {1}, {1}};
+  std::cout << "axpy residual: " << y.length() << ", v =\n" << v << std::endl;
+
+  // the workspace only grows, so repeating the same products allocates
+  // nothing after the first round
+  CountingResource counting;
+  mcpp::math::kernels::Workspace workspace(&counting);
+  DMatrix<double> xs(3, 90, mcpp::math::Padding::cacheLine),
+      ys(2, 70, mcpp::math::Padding::cacheLine);
+  std::size_t firstRound = 0;
+  for (auto round = 0; round < 10; ++round) {
+    mcpp::math::gemm(1., a, b, 0., c, workspace);
+    mcpp::math::gemv(1., a, xs.view().column(1), 1., ys.view().column(0),
+                     workspace);
+    if (round == 0)
+      firstRound = counting.allocations;
+  }
+  std::cout << "workspace allocations in the first round: " << firstRound
+            << ", in the next nine: " << counting.allocations - firstRound
+            << std::endl;
+}
+
+void testGemv() {
+  using mcpp::math::kernels::gemvKernelsFor, mcpp::math::kernels::SimdLevel;
+
+  // odd sizes so every kernel goes through its row and column tails
+  const auto a = randomMatrix<double>(53, 37), x = randomMatrix<double>(1, 53),
+             xt = randomMatrix<double>(1, 37), y0 = randomMatrix<double>(1, 37),
+             yt0 = randomMatrix<double>(1, 53);
+  DMatrix<double> expected(1, 37), expectedT(1, 53);
+  for (std::size_t i = 0; i < 37; ++i) {
+    double sum = 0;
+    for (std::size_t k = 0; k < 53; ++k)
+      sum += a(i, k) * x(k, 0);
+    expected(i, 0) = 2 * sum - y0(i, 0);
+  }
+  for (std::size_t j = 0; j < 53; ++j) {
+    double sum = 0;
+    for (std::size_t k = 0; k < 37; ++k)
+      sum += a(k, j) * xt(k, 0);
+    expectedT(j, 0) = 2 * sum - yt0(j, 0);
+  }
+  const auto best = mcpp::math::kernels::detectSimdLevel();
+  for (auto level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2,
+                     SimdLevel::avx512}) {
+    if (level > best)
+      break;
+    const auto kernels = gemvKernelsFor<double>(level);
+    auto y = y0, yt = yt0;
+    kernels.gemv(37, 53, 2., a.data(), a.stride(), x.data(), -1., y.data());
+    kernels.gemvTransposed(37, 53, 2., a.data(), a.stride(), xt.data(), -1.,
+                           yt.data());
+    std::cout << "level " << int(level)
+              << " gemv error: " << maxDifference(y, expected)
+              << ", transposed error: " << maxDifference(yt, expectedT)
+              << '\n';
+  }
+
+  // strided vectors: columns of padded matrices
+  DMatrix<double> xs(3, 53, mcpp::math::Padding::cacheLine),
+      ys(2, 37, mcpp::math::Padding::cacheLine);
+  xs.view().column(1) = x;
+  ys.view().column(0) = y0;
+  mcpp::math::gemv(2., a.view(), xs.view().column(1), -1.,
+                   ys.view().column(0));
+  std::cout << "strided gemv error: "
+            << maxDifference(DMatrix<double>(ys.view().column(0)), expected);
+
+  // operator* picks gemv for vectors on either side, the threaded version
+  // splits rows or columns the same way for any pool
+  const auto big = randomMatrix<float>(700, 2000);
+  const auto v = randomMatrix<float>(1, 700), w = randomMatrix<float>(2000, 1);
+  mcpp::concurrency::ThreadPool one(1), four(4);
+  const auto bv = big * v, wb = w * big;
+  DMatrix<float> viaGemm(1, 2000), rowViaGemm(700, 1);
+  mcpp::math::gemm(1.f, big, v, 0.f, viaGemm);
+  mcpp::math::gemm(1.f, w, big, 0.f, rowViaGemm);
+  std::cout << ", product error: " << maxDifference(bv, viaGemm)
+            << ", row vector error: " << maxDifference(wb, rowViaGemm)
+            << ", threads agree? "
+            << (big.multiply(v, four) == big.multiply(v, one) &&
+                w.multiply(big, four) == w.multiply(big, one) &&
+                big.multiply(v, four) == bv)
+            << std::endl;
+
+  mcpp::math::FMatrix<8, 8> m;
+  mcpp::math::FVector<8> u;
+  for (std::size_t i = 0; i < 8; ++i) {
+    u(i, 0) = float(i);
+    for (std::size_t j = 0; j < 8; ++j)
+      m(i, j) = float(i * 8 + j);
+  }
+  const auto mu = m * u;
+  std::cout << "fixed-size gemv: " << mu(7, 0) << ", row: "
+            << (u.transposed() * m)(0, 7) << std::endl;
+}
+
+template <typename T> void testTranspose(std::size_t w, std::size_t h) {
+  const auto a = randomMatrix<T>(w, h);
+  auto t = a.transposed();
+  bool matches = t.width() == h && t.height() == w;
+  for (std::size_t i = 0; matches && i < h; ++i)
+    for (std::size_t j = 0; j < w; ++j)
+      matches = matches && t(j, i) == a(i, j);
+  t.transpose();
+  std::cout << w << 'x' << h << " transpose ok? " << (matches && t == a)
+            << '\n';
+}
+
+void testTransposes() {
+  testTranspose<float>(123, 77);
+  testTranspose<float>(100, 100);
+  testTranspose<double>(61, 61);
+  testTranspose<double>(3, 200);
+
+  mcpp::math::FMatrix<8, 8> m;
+  for (std::size_t i = 0; i < 8; ++i)
+    for (std::size_t j = 0; j < 8; ++j)
+      m(i, j) = float(i * 8 + j);
+  auto t = m.transposed();
+  t.transpose();
+  std::cout << "8x8 static transpose ok? "
+            << (t == m && m.transposed()(2, 5) == m(5, 2)) << std::endl;
+}
+
+void testViews() {
+  auto a = randomMatrix<float>(60, 50);
+  const auto b = randomMatrix<float>(40, 30);
+
+  // the 20x30 block of a starting at row 10, column 5, copied the slow way
+  DMatrix<float> copy(20, 30);
+  for (std::size_t i = 0; i < 30; ++i)
+    for (std::size_t j = 0; j < 20; ++j)
+      copy(i, j) = a(10 + i, 5 + j);
+
+  auto block = a.view().block(10, 5, 20, 30);
+  const auto corner = b.view().block(0, 0, 30, 20);
+  std::cout << "block product error: "
+            << maxDifference(block * corner, copy * DMatrix<float>(corner))
+            << '\n';
+
+  block *= 2.f;
+  a.view().row(0) = a.view().row(1);
+  mcpp::math::axpy(1.f, a.view().column(2), a.view().column(3));
+  std::cout << "writes through? " << (a(10, 5) == 2 * copy(0, 0))
+            << (a(0, 7) == a(1, 7)) << (a(4, 3) != a(4, 2)) << std::endl;
+
+  // a view of the destination itself, with a different shape
+  auto c = randomMatrix<float>(4, 4);
+  const auto topLeft = DMatrix<float>(c.view().block(0, 0, 2, 2));
+  c = c.view().block(0, 0, 2, 2) * 2.f;
+  std::cout << "assigned from own view? "
+            << (c.width() == 2 && c.height() == 2 &&
+                c == DMatrix<float>(topLeft * 2.f))
+            << std::endl;
+}
+
+void testPadding() {
+  using mcpp::math::Padding;
+  const auto a = randomMatrix<float>(70, 50), b = randomMatrix<float>(33, 70);
+
+  DMatrix<float> paddedA(70, 50, Padding::cacheLine);
+  DMatrix<float> paddedB(33, 70, Padding::cacheLine);
+  paddedA.view() = a;
+  paddedB.view() = b;
+  const auto address = reinterpret_cast<std::uintptr_t>(paddedA.data());
+  std::cout << "padded to cache lines? "
+            << (paddedA.stride() == 80 && paddedB.stride() == 48 &&
+                address % 64 == 0)
+            << ", padding zeroed? "
+            << std::all_of(paddedB.data() + 33, paddedB.data() + 48,
+                           [](float x) { return x == 0; })
+            << '\n';
+
+  const auto copy = paddedA;
+  std::cout << "padded results match? " << (copy == a)
+            << (maxDifference(paddedA * paddedB, a * b) == 0)
+            << (DMatrix<float>(paddedA + a) == DMatrix<float>(a * 2.f))
+            << (paddedA.transposed() == a.transposed()) << std::endl;
+
+  DMatrix<float> row(5, 1, Padding::cacheLine),
+      column(1, 5, Padding::cacheLine);
+  row.view() = DMatrix<float>{{1, 1, 1, 1, 1}};
+  column.view() = DMatrix<float>{{1}, {1}, {1}, {1}, {1}};
+  std::cout << "padded vector dot products: " << row.dot(row) << ' '
+            << column.dot(column) << ", lengths " << row.length() << ' '
+            << column.length() << std::endl;
+}
+
+void testBatches() {
+  using namespace mcpp::math::kernels;
+  using mcpp::math::FMatrix4x4, mcpp::math::FVector3, mcpp::math::FVector4;
+
+  // a rotation about z plus a translation
+  const FMatrix4x4 rigid = {
+      {0, -1, 0, 5}, {1, 0, 0, -2}, {0, 0, 1, 3}, {0, 0, 0, 1}};
+  const auto points = randomMatrix<float>(3, 1001);
+  mcpp::math::FVector3Batch batch(1001), transformed(1001), crossed(1001);
+  for (std::size_t i = 0; i < 1001; ++i)
+    batch.set(i, FVector3{{points(i, 0)}, {points(i, 1)}, {points(i, 2)}});
+
+  for (auto level = int(detectSimdLevel()); level >= 0; --level) {
+    const auto kernels = batchKernelsFor<float, 3>(SimdLevel(level));
+    kernels.transform(1001, rigid.data(), batch.components().data(), 1,
+                      transformed.components().data());
+    float error = 0;
+    for (std::size_t i = 0; i < 1001; ++i) {
+      const auto p = batch[i];
+      const FVector4 expected =
+          rigid * FVector4{{p(0, 0)}, {p(1, 0)}, {p(2, 0)}, {1}};
+      for (std::size_t c = 0; c < 3; ++c)
+        error = std::max(error,
+                         std::abs(transformed[i](c, 0) - expected(c, 0)));
+    }
+    std::cout << "level " << level << " batch transform error: " << error
+              << '\n';
+  }
+
+  transform(rigid, batch, transformed);
+  cross(batch, transformed, crossed);
+  float dots[1001];
+  dot(crossed, batch, dots);
+  normalize(crossed, crossed);
+  const auto single = batch[1000].cross(transformed[1000]);
+  const FVector3 difference = crossed[1000] - single / single.length();
+  std::cout << "cross orthogonal? " << (std::abs(dots[500]) < 1e-5f)
+            << ", matches single? " << (difference.length() < 1e-6f)
+            << ", unit? " << (std::abs(crossed[7].length() - 1) < 1e-6f)
+            << ", dynamic too? "
+            << (DMatrix<float>(batch[3]).cross(DMatrix<float>(batch[4])) ==
+                DMatrix<float>(batch[3].cross(batch[4])))
+            << std::endl;
+}
+
+void testMatrixFiles() {
+  using mcpp::math::MapMode, mcpp::math::MappedMatrix;
+
+  const auto path =
+      (std::filesystem::temp_directory_path() / "mcpp_matrix_test.bin")
+          .string();
+  const auto m = randomMatrix<float>(123, 77);
+  mcpp::math::saveMatrix(path, m.view().block(3, 7, 100, 70));
+  const DMatrix<float> block(m.view().block(3, 7, 100, 70));
+
+  {
+    std::ifstream in(path, std::ios::binary);
+    const MappedMatrix<float> mapped(path);
+    std::cout << "mapped matches? "
+              << (DMatrix<float>(mapped.view()) == block)
+              << ", read matches? "
+              << (mcpp::math::readMatrix<float>(in) == block);
+  }
+
+  MappedMatrix<float> private_(path, MapMode::copyOnWrite);
+  private_.mutableView().row(0) = block.view().row(1);
+  const MappedMatrix<float> again(path);
+  std::cout << ", copy on write? "
+            << (private_(0, 5) == block(1, 5) && again(0, 5) == block(0, 5));
+
+  try {
+    const MappedMatrix<double> wrongType(path);
+    std::cout << ", wrong type caught? 0";
+  } catch (const std::runtime_error &) {
+    std::cout << ", wrong type caught? 1";
+  }
+  std::cout << std::endl;
+  std::filesystem::remove(path);
+}
+
+void testDecompositions() {
+  using namespace mcpp::math;
+
+  // 150 spans two full panels and a partial one
+  const auto a = randomMatrix<double>(150, 150);
+  const auto b = randomMatrix<double>(3, 150);
+  const LuDecomposition<double> lu(a);
+  const auto x = lu.solve(b);
+  DMatrix<double> identity(150, 150);
+  for (std::size_t i = 0; i < 150; ++i)
+    for (std::size_t j = 0; j < 150; ++j)
+      identity(i, j) = i == j;
+  std::cout << "lu residual: " << maxDifference(a * x, b)
+            << ", inverse residual: "
+            << maxDifference(lu.inverse() * a, identity) << '\n';
+
+  // a * a^t / n + i is symmetric positive definite
+  DMatrix<double> spd = a * a.transposed() / 150.;
+  for (std::size_t i = 0; i < 150; ++i)
+    spd(i, i) += 1;
+  const CholeskyDecomposition<double> cholesky(spd);
+  const auto &l = cholesky.factor();
+  std::cout << "cholesky error: " << maxDifference(l * l.transposed(), spd)
+            << ", solve residual: "
+            << maxDifference(spd * cholesky.solve(b), b)
+            << ", same determinant? "
+            << (std::abs(cholesky.determinant() / determinant(spd) - 1) <
+                1e-9)
+            << '\n';
+
+  DMatrix<double> singular = a;
+  for (std::size_t i = 0; i < 150; ++i)
+    singular(i, 7) = 0;
+  auto caught = 0;
+  try {
+    static_cast<void>(solve(singular, b));
+  } catch (const SingularMatrixError &) {
+    ++caught;
+  }
+  try {
+    CholeskyDecomposition<double> notDefinite(a);
+  } catch (const NotPositiveDefiniteError &) {
+    ++caught;
+  }
+  std::cout << "errors caught: " << caught
+            << ", singular determinant: " << determinant(singular) << '\n';
+
+  const FMatrix4x4 m4 = {
+      {2, 0, 1, 3}, {1, 4, 0, 0}, {0, 1, 5, 2}, {3, 0, 0, 1}};
+  const FMatrix3x3 m3 = {{4, 1, 0}, {2, 3, 1}, {0, 1, 6}};
+  DMatrix<float> d4(m4), d3(m3);
+  const auto i4 = inverse(m4) * m4;
+  const auto i3 = inverse(m3) * m3;
+  float error = 0;
+  for (std::size_t i = 0; i < 4; ++i)
+    for (std::size_t j = 0; j < 4; ++j) {
+      error = std::max(error, std::abs(i4(i, j) - (i == j)));
+      if (i < 3 && j < 3)
+        error = std::max(error, std::abs(i3(i, j) - (i == j)));
+    }
+  std::cout << "fixed-size inverse error: " << error << ", determinants: "
+            << determinant(m4) << " vs " << determinant(d4) << ", "
+            << determinant(m3) << " vs " << determinant(d3) << std::endl;
+}
+
+void testSparse() {
+  using mcpp::math::SparseMatrix;
+
+  // a 2d laplacian on a 40x40 grid, duplicates on the diagonal get summed
+  constexpr std::size_t side = 40, n = side * side;
+  mcpp::math::SparseMatrixBuilder<double> builder(n, n);
+  for (std::size_t i = 0; i < n; ++i) {
+    builder.add(i, i, 2);
+    builder.add(i, i, 2);
+    if (i % side != 0)
+      builder.add(i, i - 1, -1);
+    if (i % side != side - 1)
+      builder.add(i, i + 1, -1);
+    if (i >= side)
+      builder.add(i, i - side, -1);
+    if (i + side < n)
+      builder.add(i, i + side, -1);
+  }
+  const auto laplacian = builder.build();
+  const auto dense = laplacian.toDense();
+  const auto x = randomMatrix<double>(1, n), xs = randomMatrix<double>(20, n);
+
+  mcpp::concurrency::ThreadPool one(1), four(4);
+  const auto product = laplacian.multiply(xs, four);
+  std::cout << "nonzeros: " << laplacian.nonZeros()
+            << ", spmv error: " << maxDifference(laplacian * x, dense * x)
+            << ", spmm error: " << maxDifference(product, dense * xs)
+            << ", same single-threaded? "
+            << (product == laplacian.multiply(xs, one)) << '\n';
+
+  const SparseMatrix<double> fromDense(dense.view().block(3, 5, 300, 200));
+  const auto transposed = fromDense.transposed();
+  std::cout << "round trip? "
+            << (fromDense.toDense() ==
+                DMatrix<double>(dense.view().block(3, 5, 300, 200)))
+            << ", transposed? "
+            << (transposed.toDense() == fromDense.toDense().transposed())
+            << ", lookup? "
+            << (laplacian(41, 1) == -1 && laplacian(41, 41) == 4 &&
+                laplacian(41, 43) == 0)
+            << std::endl;
+}
+
+void testStrassen() {
+  using mcpp::math::strassenErrorBound, mcpp::math::strassenMultiply;
+
+  // 3 levels with padding on every side, then 2 levels without any
+  const auto a = randomMatrix<double>(260, 300);
+  const auto b = randomMatrix<double>(333, 260);
+  const auto bound = strassenErrorBound(a, b, {32});
+  const auto error = maxDifference(strassenMultiply(a, b, {32}), a * b);
+  std::cout << "strassen levels: " << bound.levels << ", error: " << error
+            << ", within bound? " << (error <= bound.strassen)
+            << ", bound vs classical: " << bound.strassen / bound.classical;
+
+  const auto c = randomMatrix<float>(256, 256);
+  std::cout << ", unpadded error: "
+            << maxDifference(strassenMultiply(c, c.view(), {64}), c * c)
+            << std::endl;
+}
+
+// elementwise copy into another element type
+template <typename To, typename From>
+DMatrix<To> converted(const DMatrix<From> &m) {
+  DMatrix<To> result(m.width(), m.height());
+  for (std::size_t i = 0; i < m.height(); ++i)
+    for (std::size_t j = 0; j < m.width(); ++j)
+      result(i, j) = float(m(i, j));
+  return result;
+}
+
+void testReducedPrecision() {
+  using mcpp::math::BFloat16, mcpp::math::Half;
+  using mcpp::math::kernels::conversionKernelsFor;
+  using mcpp::math::kernels::SimdLevel;
+
+  static_assert(Half(1.5f).bits() == 0x3e00 &&
+                Half(65520.f).bits() == 0x7c00 &&
+                BFloat16(1.f / 3).bits() == 0x3eab);
+
+  // every half, and floats spread over the whole range, through each level's
+  // kernels against the scalar conversion
+  std::vector<Half> halves(1 << 16), narrowed(1 << 16);
+  std::vector<BFloat16> bfloats(1 << 16);
+  std::vector<float> floats(1 << 16), widened(1 << 16);
+  std::mt19937 gen(7);
+  for (std::size_t i = 0; i < halves.size(); ++i) {
+    halves[i] = Half::fromBits(std::uint16_t(i));
+    floats[i] = std::bit_cast<float>(std::uint32_t(gen()));
+  }
+  const auto same = [](auto x, auto y) { return x.bits() == y.bits(); };
+  const auto best = mcpp::math::kernels::detectSimdLevel();
+  for (auto level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2,
+                     SimdLevel::avx512}) {
+    if (level > best)
+      break;
+    const auto half = conversionKernelsFor<Half>(level);
+    const auto bfloat = conversionKernelsFor<BFloat16>(level);
+    half.toFloat(halves.size(), halves.data(), widened.data());
+    bool ok = true;
+    for (std::size_t i = 0; i < halves.size(); ++i)
+      ok &= std::isnan(widened[i]) ? std::isnan(float(halves[i]))
+                                   : widened[i] == float(halves[i]);
+    half.fromFloat(floats.size(), floats.data(), narrowed.data());
+    for (std::size_t i = 0; i < floats.size(); ++i)
+      ok &= same(narrowed[i], Half(floats[i]));
+    bfloat.fromFloat(floats.size(), floats.data(), bfloats.data());
+    bfloat.toFloat(bfloats.size(), bfloats.data(), widened.data());
+    for (std::size_t i = 0; i < floats.size(); ++i)
+      ok &= same(bfloats[i], BFloat16(floats[i])) &&
+            std::bit_cast<std::uint32_t>(widened[i]) ==
+                std::uint32_t(bfloats[i].bits()) << 16;
+    std::cout << "conversions at level " << int(level) << " ok? " << ok
+              << '\n';
+  }
+
+  // products accumulate in float and round once, so they come out as the
+  // float product of the same operands rounded, give or take the last bit
+  const auto a = randomMatrix<float>(300, 200);
+  const auto b = randomMatrix<float>(250, 300);
+  const auto ha = converted<Half>(a), hb = converted<Half>(b);
+  const auto ba = converted<BFloat16>(a), bb = converted<BFloat16>(b);
+  const auto ulps = [](const auto &product, const DMatrix<float> &exact) {
+    int worst = 0;
+    for (std::size_t i = 0; i < exact.height(); ++i)
+      for (std::size_t j = 0; j < exact.width(); ++j) {
+        using T = std::remove_cvref_t<decltype(product(i, j))>;
+        const auto distance =
+            int(product(i, j).bits()) - int(T(exact(i, j)).bits());
+        worst = std::max(worst, std::abs(distance));
+      }
+    return worst;
+  };
+  std::cout << "half gemm ulps: "
+            << ulps(DMatrix<Half>(ha * hb),
+                    converted<float>(ha) * converted<float>(hb))
+            << ", bfloat16 gemm ulps: "
+            << ulps(DMatrix<BFloat16>(ba * bb),
+                    converted<float>(ba) * converted<float>(bb));
+
+  // 2048 + 1 is 2048 in half, a half accumulator would stop there
+  DMatrix<Half> ones(1, 4096);
+  for (auto &x : ones)
+    x = 1;
+  const DMatrix<Half> zeros = (ones + ones) * Half(0.5f) - ones;
+  std::cout << ", dot of 4096 ones: " << float(ones.dot(ones))
+            << ", expression zero? "
+            << std::all_of(zeros.begin(), zeros.end(),
+                           [](Half x) { return x == 0; });
+
+  // 70000 is past the largest half, only the final result may be rounded
+  DMatrix<Half> many(70000, 1);
+  for (auto &x : many)
+    x = 1;
+  std::cout << ", dot of 70000 ones in float: "
+            << mcpp::math::kernels::simdKernels<Half>().dot(
+                   70000, many.data(), many.data())
+            << ", their length: " << float(many.length()) << std::endl;
+}
+
+// a rotation by a quarter turn about z followed by a translation, all
+// evaluated by the compiler
+constexpr auto quarterTurn = [] {
+  auto m = FMatrix4x4::identity();
+  m(0, 0) = m(1, 1) = 0;
+  m(0, 1) = -1;
+  m(1, 0) = 1;
+  return m;
+}();
+
+constexpr FMatrix4x4 translation = {
+    {1, 0, 0, 5}, {0, 1, 0, 6}, {0, 0, 1, 7}, {0, 0, 0, 1}};
+
+constexpr FMatrix4x4 powers[] = {FMatrix4x4::identity(), quarterTurn,
+                                 quarterTurn * quarterTurn,
+                                 quarterTurn * quarterTurn * quarterTurn};
+
+void testConstexpr() {
+  using mcpp::math::FVector3, mcpp::math::FVector4;
+
+  constexpr auto transform = translation * quarterTurn;
+  constexpr auto moved = transform * FVector4{{1}, {0}, {0}, {1}};
+  static_assert(moved == FVector4{{5}, {7}, {7}, {1}});
+  static_assert(powers[3] * quarterTurn == FMatrix4x4::identity());
+  static_assert(quarterTurn.transposed() == powers[3]);
+  static_assert(FMatrix4x4(transform - transform * 1.f) == FMatrix4x4());
+  static_assert(FVector3{{1}, {0}, {0}}.cross(FVector3{{0}, {1}, {0}}) ==
+                FVector3{{0}, {0}, {1}});
+  static_assert(FVector3{{1}, {2}, {3}}.dot(FVector3{{4}, {5}, {6}}) == 32);
+
+  // past the simd dispatch threshold the kernels only run at runtime
+  constexpr auto big = [] {
+    mcpp::math::FMatrix<8, 8> m(1);
+    for (std::size_t i = 0; i < 64; ++i)
+      m(i / 8, i % 8) = float(i);
+    return m;
+  }();
+  constexpr auto bigTransposed = big.transposed();
+  constexpr auto doubled = FMatrix<8, 8>(big + big);
+  static_assert(bigTransposed(2, 5) == 42 && doubled(5, 2) == 84);
+  std::cout << "constexpr transforms: " << (transform * powers[1] ==
+                                            translation * powers[2])
+            << ", runtime kernels agree? "
+            << (big.transposed() == bigTransposed &&
+                FMatrix<8, 8>(big + big) == doubled)
+            << std::endl;
+}
+
+void testHeapMatrix() {
+  using mcpp::math::p1::HFMatrix;
+
+  HFMatrix a(DMatrix<float>{{1, 2}, {3, 4}});
+  auto b = a;
+  const auto sharedBefore = b.shared();
+  const float read = b(1, 1);
+  const auto sharedAfterRead = b.shared();
+  b(0, 0) = 10;
+  b(0, 1) += 1;
+  std::cout << "copy shared? " << sharedBefore << ", after a read? "
+            << (sharedAfterRead && read == 4) << ", original untouched? "
+            << (a(0, 0) == 1 && b(0, 0) == 10 && b(0, 1) == 3)
+            << ", detached? " << !b.shared();
+
+  // unshared rvalues are updated in place, shared ones are left alone
+  auto c = HFMatrix::clone(a);
+  const auto buffer = c.matrix().data();
+  auto sum = std::move(c) + a;
+  const auto sumReused = sum.matrix().data() == buffer;
+  const auto difference = a - std::move(sum) * 2.f;
+  std::cout << ", rvalues reused? "
+            << (sumReused && difference.matrix().data() == buffer)
+            << ", values? "
+            << (difference == HFMatrix(DMatrix<float>{{-3, -6}, {-9, -12}}));
+  const auto kept = a;
+  a *= 3.f;
+  a.transpose();
+  std::cout << ", shared operand kept? "
+            << (kept == HFMatrix(DMatrix<float>{{1, 2}, {3, 4}}) &&
+                a == HFMatrix(DMatrix<float>{{3, 9}, {6, 12}}))
+            << ", product? "
+            << (kept * kept == HFMatrix(DMatrix<float>{{7, 10}, {15, 22}}));
+
+  // every thread gets a copy of the same handle and writes its own element,
+  // which detaches it; the shared original never changes
+  const auto elements = randomMatrix<float>(64, 64);
+  const HFMatrix original(elements);
+  std::vector<HFMatrix> copies(8, original);
+  mcpp::concurrency::ThreadPool pool(4);
+  pool.parallelFor(copies.size(), [&](std::size_t i) {
+    for (std::size_t k = 0; k < 100; ++k) {
+      auto copy = copies[i];
+      copy(i, i) = float(i);
+      copies[i] = std::move(copy);
+    }
+  });
+  bool separate = true;
+  for (std::size_t i = 0; i < copies.size(); ++i)
+    separate &= copies[i](i, i) == float(i) &&
+                copies[i].matrix().data() != original.matrix().data();
+  std::cout << ", threads detached? " << separate << ", original intact? "
+            << (original.matrix() == elements)
+            << std::endl;
+}
+
+void testReductions() {
+  using mcpp::math::Reduction, mcpp::math::Summation,
+      mcpp::math::kernels::SimdLevel;
+
+  const auto a = randomMatrix<double>(1, 1001);
+  long double sum = 0, sumSquares = 0;
+  double smallest = a(0, 0), largestMagnitude = 0;
+  for (std::size_t i = 0; i < 1001; ++i) {
+    sum += a(i, 0);
+    sumSquares += (long double)a(i, 0) * a(i, 0);
+    smallest = std::min(smallest, a(i, 0));
+    largestMagnitude = std::max(largestMagnitude, std::abs(a(i, 0)));
+  }
+  const auto best = mcpp::math::kernels::detectSimdLevel();
+  for (auto level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2,
+                     SimdLevel::avx512}) {
+    if (level > best)
+      break;
+    const auto kernels =
+        mcpp::math::kernels::reductionKernelsFor<double>(level);
+    const auto at = [](Reduction kind) { return std::size_t(kind); };
+    std::cout << "level " << int(level) << " sum error: "
+              << std::abs(kernels.reduce[at(Reduction::sum)](1001, a.data()) -
+                          double(sum))
+              << ", kahan: "
+              << std::abs(kernels.kahan[at(Reduction::sum)](1001, a.data()) -
+                          double(sum))
+              << ", squares: "
+              << std::abs(kernels.reduce[at(Reduction::sumSquares)](
+                              1001, a.data()) -
+                          double(sumSquares))
+              << ", extremes ok? "
+              << (kernels.reduce[at(Reduction::min)](1001, a.data()) ==
+                      smallest &&
+                  kernels.reduce[at(Reduction::maxAbs)](1001, a.data()) ==
+                      largestMagnitude)
+              << std::endl;
+  }
+
+  // 2^22 tenths in float: plain drifts, pairwise and kahan shouldn't
+  DMatrix<float> tenths(1024, 4096);
+  std::fill(tenths.begin(), tenths.end(), 0.1f);
+  const auto exact = double(0.1f) * 1024 * 4096;
+  std::cout << "relative error of 2^22 float tenths, plain: "
+            << std::abs(tenths.sum(Summation::plain) - exact) / exact
+            << ", pairwise: "
+            << std::abs(tenths.sum(Summation::pairwise) - exact) / exact
+            << ", kahan: "
+            << std::abs(tenths.sum(Summation::kahan) - exact) / exact
+            << ", same on one thread? "
+            << (tenths.sum() == mcpp::math::kernels::reduceMatrix(
+                                    Reduction::sum, Summation::pairwise,
+                                    tenths.data(), 1024, 4096, 1024))
+            << std::endl;
+
+  // tall and narrow, split along the rows: the column sums mustn't depend
+  // on the pool and should stay as accurate as the whole-matrix ones
+  DMatrix<float> tall(3, 1 << 20);
+  std::fill(tall.begin(), tall.end(), 0.1f);
+  mcpp::concurrency::ThreadPool one(1), four(4);
+  std::vector<float> serial(3), onOne(3), onFour(3);
+  const auto columnSums = [&](float *out, mcpp::concurrency::ThreadPool *pool) {
+    mcpp::math::kernels::reduceColumns(Reduction::sum, Summation::pairwise,
+                                       tall.data(), 3, 1 << 20, 3, out, pool);
+  };
+  columnSums(serial.data(), nullptr);
+  columnSums(onOne.data(), &one);
+  columnSums(onFour.data(), &four);
+  const auto tallExact = double(0.1f) * (1 << 20);
+  std::cout << "tall column sum error: "
+            << std::abs(onFour[2] - tallExact) / tallExact
+            << ", same for any pool? "
+            << (serial == onOne && onOne == onFour) << ", empty norms: "
+            << DMatrix<float>(0, 4).normL1() << ' '
+            << DMatrix<float>(4, 0).normInf() << std::endl;
+
+  // padded rows, the norms against a naive pass
+  DMatrix<double> p(37, 23, mcpp::math::Padding::cacheLine);
+  p.view() = randomMatrix<double>(37, 23);
+  p(17, 29) = 5;
+  p(3, 2) = -5;
+  double frobenius = 0, l1 = 0, lInf = 0;
+  for (std::size_t j = 0; j < 37; ++j) {
+    double column = 0;
+    for (std::size_t i = 0; i < 23; ++i)
+      column += std::abs(p(i, j));
+    l1 = std::max(l1, column);
+  }
+  for (std::size_t i = 0; i < 23; ++i) {
+    double row = 0;
+    for (std::size_t j = 0; j < 37; ++j) {
+      row += std::abs(p(i, j));
+      frobenius += p(i, j) * p(i, j);
+    }
+    lInf = std::max(lInf, row);
+  }
+  const auto top = p.argmax(), bottom = p.argmin();
+  std::cout << "padded frobenius error: "
+            << std::abs(p.norm() - std::sqrt(frobenius))
+            << ", l1 error: " << std::abs(p.normL1() - l1)
+            << ", l-infinity error: " << std::abs(p.normInf() - lInf)
+            << ", argmax: " << top.row << ' ' << top.column
+            << ", argmin: " << bottom.row << ' ' << bottom.column << std::endl;
+
+  const DMatrix<float> m = {{1, -2, 3}, {-4, 5, -6}};
+  const auto rows = m.rowwise(Reduction::sumAbs),
+             columns = m.columnwise(Reduction::max);
+  std::cout << "row sums of magnitudes: " << rows(0, 0) << ' ' << rows(1, 0)
+            << ", column maxima: " << columns(0, 0) << ' ' << columns(0, 1)
+            << ' ' << columns(0, 2) << ", norms: " << m.normL1() << ' '
+            << m.normInf() << std::endl;
+
+  const mcpp::math::FMatrix<3, 2> f = {{1, -2, 3}, {-4, 5, -6}};
+  const auto halves = converted<mcpp::math::Half>(m);
+  std::cout << "fixed-size: " << f.sum() << ' ' << f.normInf() << ' '
+            << f.columnwise(Reduction::sumSquares)(0, 2) << ", half: "
+            << float(halves.sum()) << ' ' << float(halves.max()) << std::endl;
+}
+
+} // namespace
+
+void testMatrix() {
+  std::cout << "--- TESTING MATRICES ---\n";
+
+  testProduct();
+  testParallelProduct();
+  testExpressions();
+  testSimdKernels();
+  testBlas();
+  testGemv();
+  testTransposes();
+  testViews();
+  testPadding();
+  testBatches();
+  testMatrixFiles();
+  testDecompositions();
+  testSparse();
+  testStrassen();
+  testReducedPrecision();
+  testConstexpr();
+  testHeapMatrix();
+  testReductions();
+}
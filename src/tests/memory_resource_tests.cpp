@@ -0,0 +1,142 @@
+#include "tests/memory_resource_tests.hpp"
+#include "data_structures/dynamic_array.hpp"
+#include "data_structures/linked_list.hpp"
+#include "data_structures/small_array.hpp"
+#include "math/matrix.hpp"
+#include "memory/memory_resource.hpp"
+#include "misc/string.hpp"
+#include <cstddef>
+#include <iostream>
+
+namespace {
+
+using namespace mcpp::memory;
+
+// passes everything on to the heap, counting what reaches it
+class CountingResource : public MemoryResource {
+public:
+  std::size_t allocations = 0, deallocations = 0;
+
+protected:
+  void *doAllocate_(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return heapResource()->allocate(bytes, alignment);
+  }
+
+  void doDeallocate_(void *pointer, std::size_t bytes,
+                     std::size_t alignment) noexcept override {
+    ++deallocations;
+    heapResource()->deallocate(pointer, bytes, alignment);
+  }
+};
+
+void testMonotonic() {
+  using mcpp::data_structures::Array;
+
+  CountingResource counting;
+  {
+    // the first chunk is on the stack, later ones come from upstream
+    std::byte buffer[256];
+    MonotonicResource arena(buffer, sizeof(buffer), &counting);
+    Array<int> a(&arena);
+    for (auto i = 0; i < 10; ++i)
+      a.push(i);
+    std::cout << "10 ints from the stack buffer, upstream allocations: "
+              << counting.allocations << '\n';
+    for (auto i = 10; i < 1000; ++i)
+      a.push(i);
+    std::cout << "1000 ints, upstream allocations: " << counting.allocations
+              << ", a[999] = " << a[999] << '\n';
+
+    mcpp::String s("a string too long for the sso buffer", &arena);
+    auto longer = s + ", and then some";
+    std::cout << "arena strings: " << longer
+              << ", same resource? " << (longer.resource() == &arena) << '\n';
+
+    // element alignment is respected
+    mcpp::math::DMatrix<float> m(5, 5, &arena);
+    std::cout << "arena matrix cache line aligned? "
+              << (reinterpret_cast<std::uintptr_t>(m.data()) %
+                      cacheLineSize ==
+                  0)
+              << '\n';
+    a.clear();
+    arena.release();
+    std::cout << "after release, freed upstream: " << counting.deallocations
+              << '/' << counting.allocations << '\n';
+  }
+}
+
+void testPool() {
+  using mcpp::data_structures::LinkedList;
+
+  CountingResource counting;
+  PoolResource pool(&counting);
+  {
+    LinkedList<int> l(&pool);
+    for (auto i = 0; i < 100; ++i)
+      l.push(i);
+    const auto chunks = counting.allocations;
+    // removed nodes go back on the free list and get reused
+    for (auto round = 0; round < 10; ++round) {
+      for (auto i = 0; i < 100; ++i)
+        l.remove(i);
+      for (auto i = 0; i < 100; ++i)
+        l.push(i);
+    }
+    std::cout << "pool chunks for 100 nodes: " << chunks
+              << ", after 1000 more removes and pushes: "
+              << counting.allocations << ", size: " << l.size() << '\n';
+    l.remove(0);
+    l.remove(99);
+    l.push(100);
+    std::cout << "without the ends and with 100 at the back: ";
+    for (auto i : l)
+      if (i < 3 || i > 97)
+        std::cout << i << ' ';
+    std::cout << '\n';
+  }
+  // too big for the pool, straight to upstream
+  const auto before = counting.allocations;
+  mcpp::data_structures::Array<double> big(1000, &pool);
+  std::cout << "big array went upstream? "
+            << (counting.allocations == before + 1) << '\n';
+}
+
+void testDefaultResource() {
+  using mcpp::data_structures::Array;
+  using mcpp::data_structures::SmallArray;
+
+  CountingResource counting;
+  const auto previous = setDefaultResource(&counting);
+  {
+    Array<int> a{1, 2, 3};
+    SmallArray<int, 2> small{1, 2, 3};
+    std::cout << "default resource allocations: " << counting.allocations;
+  }
+  setDefaultResource(previous);
+  std::cout << ", deallocations: " << counting.deallocations << '\n';
+
+  // copies go to the default resource, moves keep theirs, and moving between
+  // resources moves the elements instead of the buffer
+  MonotonicResource arena;
+  Array<mcpp::String> a(&arena);
+  a.emplace("on the arena");
+  auto copy = a;
+  auto moved = std::move(a);
+  Array<mcpp::String> heap;
+  heap = std::move(moved);
+  std::cout << "copy on the heap? " << (copy.resource() == heapResource())
+            << ", heap = " << heap << ", still on the heap? "
+            << (heap.resource() == heapResource()) << std::endl;
+}
+
+} // namespace
+
+void testMemoryResources() {
+  std::cout << "--- TESTING MEMORY RESOURCES ---\n";
+
+  testMonotonic();
+  testPool();
+  testDefaultResource();
+}